@@ -18,11 +18,27 @@ public final class JxlNukePlugin: Nuke.ImageDecoding {
         return ImageContainer(image: image)
     }
 
+    private var progressiveDecoder: JXLProgressiveDecoder?
+    private var consumedBytes = 0
+
     public init() {
     }
 
     public func decodePartiallyDownloadedData(_ data: Data) -> ImageContainer? {
-        return nil
+        guard data.count > consumedBytes, JXLCoder.isJXL(data: data) else { return nil }
+        do {
+            let decoder = try progressiveDecoder ?? JXLProgressiveDecoder()
+            progressiveDecoder = decoder
+            // Nuke hands over everything downloaded so far, only the new tail is fed
+            let hasUpdate = try decoder.append(data: data.subdata(in: consumedBytes..<data.count))
+            consumedBytes = data.count
+            guard hasUpdate else { return nil }
+            return ImageContainer(image: try decoder.image(), isPreview: true)
+        } catch {
+            progressiveDecoder = nil
+            consumedBytes = Int.max
+            return nil
+        }
     }
 }
 
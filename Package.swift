@@ -28,6 +28,11 @@ let package = Package(
                 linkerSettings: [
                     .linkedFramework("Accelerate")
                 ]),
+        .executableTarget(
+            name: "JxlBenchmark",
+            dependencies: ["jxlc"],
+            path: "Sources/JxlBenchmark",
+            cxxSettings: [.headerSearchPath("../jxlc"), .headerSearchPath("../jxlc/algo")]),
         .binaryTarget(name: "libbrotlicommon", path: "Sources/Frameworks/libbrotlicommon.xcframework"),
         .binaryTarget(name: "libbrotlidec", path: "Sources/Frameworks/libbrotlidec.xcframework"),
         .binaryTarget(name: "libbrotlienc", path: "Sources/Frameworks/libbrotlienc.xcframework"),
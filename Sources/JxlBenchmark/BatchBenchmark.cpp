@@ -0,0 +1,84 @@
+//
+//  BatchBenchmark.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlBenchmark.hpp"
+#include "JxlWorker.hpp"
+#include "JxlBatchDecoder.hpp"
+#include <atomic>
+
+namespace jxlbench {
+
+int RunBatchBenchmark() {
+    // Mostly small images with a few large ones, like a gallery of thumbnails and the photos they came from
+    const uint32_t sizes[] = { 64, 96, 128, 192, 256, 384, 512, 128, 64, 1024 };
+    const size_t imageCount = 200;
+    std::vector<std::vector<uint8_t>> files;
+    files.reserve(imageCount);
+    uint64_t totalPixels = 0;
+    for (size_t i = 0; i < imageCount; ++i) {
+        const uint32_t size = sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+        files.push_back(MakeTestFile(size, size));
+        totalPixels += static_cast<uint64_t>(size) * size;
+    }
+    std::vector<jxlcoder::JxlBatchInput> inputs;
+    for (const auto& file : files) {
+        inputs.push_back({ file.data(), file.size() });
+    }
+
+    double serial = MeasureMicroseconds(1, [&] {
+        for (const auto& file : files) {
+            std::vector<uint8_t> pixels;
+            size_t xsize, ysize;
+            JxlColorDescription color;
+            int depth, components;
+            bool useFloats;
+            JxlExposedOrientation orientation;
+            Check(DecodeJpegXlOneShot(file.data(), file.size(), &pixels, &xsize, &ysize, &color,
+                                      &depth, &components, &useFloats, &orientation, r8),
+                  "decoding in a loop");
+        }
+    }, 3);
+
+    jxlcoder::JxlBatchOptions options;
+    options.pixelFormat = r8;
+    double batched = MeasureMicroseconds(1, [&] {
+        std::atomic<size_t> decoded(0);
+        jxlcoder::DecodeJpegXlBatch(inputs, options, [&](jxlcoder::JxlBatchResult& result) {
+            Check(result.success, "decoding in a batch");
+            decoded.fetch_add(1, std::memory_order_relaxed);
+        });
+        Check(decoded.load() == inputs.size(), "every image of the batch completes");
+    }, 3);
+
+    PrintHeader(std::to_string(imageCount) + " mixed size images, " +
+                FormatNumber(totalPixels / 1e6) + " megapixels",
+                { "path", "total ms", "images/s", "speedup" });
+    PrintRow({ "serial loop", FormatNumber(serial / 1000.0), FormatNumber(imageCount / (serial / 1e6)), "1.00x" });
+    PrintRow({ "batch", FormatNumber(batched / 1000.0), FormatNumber(imageCount / (batched / 1e6)),
+        FormatNumber(serial / batched, 2) + "x" });
+    return 0;
+}
+
+}
@@ -0,0 +1,115 @@
+//
+//  JxlBenchmark.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlBenchmark.hpp"
+#include "JxlWorker.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <utility>
+
+namespace jxlbench {
+
+std::vector<uint8_t> MakeTestPixels(uint32_t width, uint32_t height) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    uint32_t seed = 0x9E3779B9u;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const int noise = static_cast<int>(seed >> 28) - 8;
+            uint8_t* pixel = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+            pixel[0] = static_cast<uint8_t>(std::clamp(static_cast<int>(x * 255 / std::max(width - 1, 1u)) + noise, 0, 255));
+            pixel[1] = static_cast<uint8_t>(std::clamp(static_cast<int>(y * 255 / std::max(height - 1, 1u)) + noise, 0, 255));
+            pixel[2] = static_cast<uint8_t>(std::clamp(static_cast<int>((x + y) * 127 / std::max(width + height - 2, 1u)) + 64 + noise, 0, 255));
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+std::vector<uint8_t> MakeTestFile(uint32_t width, uint32_t height) {
+    static std::map<std::pair<uint32_t, uint32_t>, std::vector<uint8_t>> files;
+    auto key = std::make_pair(width, height);
+    auto it = files.find(key);
+    if (it != files.end()) {
+        return it->second;
+    }
+    std::vector<uint8_t> compressed;
+    Check(EncodeJxlOneshot(MakeTestPixels(width, height), width, height, &compressed, rgba, lossy, 1.0f, 3, 0),
+          "encoding test file");
+    files.emplace(key, compressed);
+    return compressed;
+}
+
+double MeasureMicroseconds(int iterations, const std::function<void()>& func, int rounds) {
+    // Warm up caches, pools and the executor threads before anything is timed
+    func();
+    std::vector<double> samples;
+    for (int round = 0; round < rounds; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back(elapsed.count() / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+static std::vector<size_t> widths;
+
+void PrintHeader(const std::string& title, const std::vector<std::string>& columns) {
+    std::printf("\n%s\n", title.c_str());
+    widths.clear();
+    for (const auto& column : columns) {
+        widths.push_back(std::max<size_t>(column.size(), 12));
+    }
+    PrintRow(columns);
+}
+
+void PrintRow(const std::vector<std::string>& cells) {
+    for (size_t i = 0; i < cells.size(); ++i) {
+        size_t width = i < widths.size() ? widths[i] : 12;
+        std::printf("%-*s  ", static_cast<int>(width), cells[i].c_str());
+    }
+    std::printf("\n");
+}
+
+std::string FormatNumber(double value, int precision) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.*f", precision, value);
+    return buffer;
+}
+
+void Check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "Failed: %s\n", what);
+        std::exit(1);
+    }
+}
+
+}
@@ -0,0 +1,68 @@
+//
+//  JxlBenchmark.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#ifndef JxlBenchmark_hpp
+#define JxlBenchmark_hpp
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace jxlbench {
+
+/**
+ * Deterministic RGBA 8-bit test content: smooth gradients with some noise, so files are neither trivial
+ * nor incompressible
+ */
+std::vector<uint8_t> MakeTestPixels(uint32_t width, uint32_t height);
+
+/**
+ * Lossy RGBA file of the test content, encoded once per size at low effort
+ */
+std::vector<uint8_t> MakeTestFile(uint32_t width, uint32_t height);
+
+/**
+ * Runs func iterations times per round and returns the median time of one call in microseconds
+ */
+double MeasureMicroseconds(int iterations, const std::function<void()>& func, int rounds = 5);
+
+void PrintHeader(const std::string& title, const std::vector<std::string>& columns);
+void PrintRow(const std::vector<std::string>& cells);
+std::string FormatNumber(double value, int precision = 1);
+
+// A failed decode or encode invalidates the numbers, benchmarks stop on the first one
+void Check(bool condition, const char* what);
+
+int RunPoolBenchmark();
+int RunRegionBenchmark();
+int RunBatchBenchmark();
+int RunSessionBenchmark();
+
+}
+
+#endif /* JxlBenchmark_hpp */
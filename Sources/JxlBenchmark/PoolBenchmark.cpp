@@ -0,0 +1,118 @@
+//
+//  PoolBenchmark.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlBenchmark.hpp"
+#include "JxlWorker.hpp"
+#include <jxl/decode_cxx.h>
+#include <jxl/resizable_parallel_runner_cxx.h>
+
+namespace jxlbench {
+
+/**
+ * What DecodeJpegXlOneShot did before decoders were pooled: a new decoder and thread pool per call
+ */
+static bool DecodeWithNewDecoder(const std::vector<uint8_t>& file, std::vector<uint8_t>* pixels) {
+    auto runner = JxlResizableParallelRunnerMake(nullptr);
+    auto dec = JxlDecoderMake(nullptr);
+    if (JXL_DEC_SUCCESS != JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_BASIC_INFO | JXL_DEC_FULL_IMAGE) ||
+        JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec.get(), JxlResizableParallelRunner, runner.get())) {
+        return false;
+    }
+    JxlDecoderSetInput(dec.get(), file.data(), file.size());
+    JxlDecoderCloseInput(dec.get());
+    JxlPixelFormat format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+    for (;;) {
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec.get());
+        if (status == JXL_DEC_BASIC_INFO) {
+            JxlBasicInfo info;
+            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec.get(), &info)) {
+                return false;
+            }
+            JxlResizableParallelRunnerSetThreads(runner.get(),
+                                                 JxlResizableParallelRunnerSuggestThreads(info.xsize, info.ysize));
+            pixels->resize(static_cast<size_t>(info.xsize) * info.ysize * 4);
+        } else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
+            if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutBuffer(dec.get(), &format, pixels->data(), pixels->size())) {
+                return false;
+            }
+        } else if (status == JXL_DEC_FULL_IMAGE) {
+            continue;
+        } else if (status == JXL_DEC_SUCCESS) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+static bool BasicInfoWithNewDecoder(const std::vector<uint8_t>& file) {
+    auto dec = JxlDecoderMake(nullptr);
+    if (JXL_DEC_SUCCESS != JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_BASIC_INFO)) {
+        return false;
+    }
+    JxlDecoderSetInput(dec.get(), file.data(), file.size());
+    JxlDecoderCloseInput(dec.get());
+    JxlBasicInfo info;
+    return JxlDecoderProcessInput(dec.get()) == JXL_DEC_BASIC_INFO &&
+    JXL_DEC_SUCCESS == JxlDecoderGetBasicInfo(dec.get(), &info);
+}
+
+int RunPoolBenchmark() {
+    PrintHeader("Per call latency, new decoder and runner vs pooled decoder (microseconds)",
+                { "size", "new decode", "pooled decode", "speedup", "new info", "pooled info", "speedup" });
+    for (uint32_t size : { 64u, 128u, 256u, 512u }) {
+        const std::vector<uint8_t> file = MakeTestFile(size, size);
+        const int iterations = static_cast<int>(std::max<uint32_t>(20, 2000 * 64 * 64 / (size * size)));
+
+        std::vector<uint8_t> pixels;
+        double fresh = MeasureMicroseconds(iterations, [&] {
+            Check(DecodeWithNewDecoder(file, &pixels), "decoding with a new decoder");
+        });
+        double pooled = MeasureMicroseconds(iterations, [&] {
+            size_t xsize, ysize;
+            JxlColorDescription color;
+            int depth, components;
+            bool useFloats;
+            JxlExposedOrientation orientation;
+            Check(DecodeJpegXlOneShot(file.data(), file.size(), &pixels, &xsize, &ysize, &color,
+                                      &depth, &components, &useFloats, &orientation, r8),
+                  "decoding with a pooled decoder");
+        });
+        double freshInfo = MeasureMicroseconds(iterations * 10, [&] {
+            Check(BasicInfoWithNewDecoder(file), "reading basic info with a new decoder");
+        });
+        double pooledInfo = MeasureMicroseconds(iterations * 10, [&] {
+            size_t xsize, ysize;
+            Check(DecodeBasicInfo(file.data(), file.size(), &xsize, &ysize), "reading basic info with a pooled decoder");
+        });
+
+        const std::string label = std::to_string(size) + "x" + std::to_string(size);
+        PrintRow({ label, FormatNumber(fresh), FormatNumber(pooled), FormatNumber(fresh / pooled, 2) + "x",
+            FormatNumber(freshInfo, 2), FormatNumber(pooledInfo, 2), FormatNumber(freshInfo / pooledInfo, 2) + "x" });
+    }
+    return 0;
+}
+
+}
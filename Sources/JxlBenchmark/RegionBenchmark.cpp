@@ -0,0 +1,86 @@
+//
+//  RegionBenchmark.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlBenchmark.hpp"
+#include "JxlWorker.hpp"
+#include "JxlByteSource.hpp"
+#include <cstring>
+
+namespace jxlbench {
+
+int RunRegionBenchmark() {
+    const uint32_t imageSize = 2048;
+    const std::vector<uint8_t> file = MakeTestFile(imageSize, imageSize);
+
+    PrintHeader("Region of a " + std::to_string(imageSize) + "x" + std::to_string(imageSize) +
+                " image, full decode and crop vs region decode",
+                { "region", "full ms", "region ms", "speedup", "full MB", "region MB" });
+    for (uint32_t regionSize : { 128u, 512u, 1024u }) {
+        const size_t regionX = (imageSize - regionSize) / 2;
+        const size_t regionY = (imageSize - regionSize) / 2;
+        const size_t regionBytes = static_cast<size_t>(regionSize) * regionSize * 4;
+
+        std::vector<uint8_t> fullPixels;
+        std::vector<uint8_t> cropped(regionBytes);
+        double full = MeasureMicroseconds(3, [&] {
+            size_t xsize, ysize;
+            JxlColorDescription color;
+            int depth, components;
+            bool useFloats;
+            JxlExposedOrientation orientation;
+            Check(DecodeJpegXlOneShot(file.data(), file.size(), &fullPixels, &xsize, &ysize, &color,
+                                      &depth, &components, &useFloats, &orientation, r8),
+                  "decoding the full image");
+            const size_t rowBytes = static_cast<size_t>(regionSize) * 4;
+            for (size_t y = 0; y < regionSize; ++y) {
+                std::memcpy(cropped.data() + y * rowBytes,
+                            fullPixels.data() + ((regionY + y) * xsize + regionX) * 4, rowBytes);
+            }
+        });
+
+        std::vector<uint8_t> regionPixels;
+        double region = MeasureMicroseconds(3, [&] {
+            jxlcoder::JxlMemoryByteSource source(file.data(), file.size());
+            JxlColorDescription color;
+            int depth, components;
+            bool useFloats;
+            Check(DecodeJpegXlRegion(source, regionX, regionY, regionSize, regionSize, &regionPixels,
+                                     &color, &depth, &components, &useFloats, r8),
+                  "decoding the region");
+        });
+        Check(regionPixels == cropped, "region decode matches the cropped full decode");
+
+        // Pixel buffers held at the peak of each path, decoder internals are the same for both
+        const double megabyte = 1024.0 * 1024.0;
+        const std::string label = std::to_string(regionSize) + "x" + std::to_string(regionSize);
+        PrintRow({ label, FormatNumber(full / 1000.0), FormatNumber(region / 1000.0),
+            FormatNumber(full / region, 2) + "x",
+            FormatNumber((fullPixels.size() + cropped.size()) / megabyte),
+            FormatNumber(regionPixels.size() / megabyte) });
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,72 @@
+//
+//  SessionBenchmark.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlBenchmark.hpp"
+#include "JxlWorker.hpp"
+#include "JxlEncoderSession.hpp"
+
+namespace jxlbench {
+
+int RunSessionBenchmark() {
+    JxlEncoderProfile profile;
+    profile.numChannels = 4;
+    profile.compressionOption = lossy;
+    profile.distance = 1.0f;
+    profile.effort = 3;
+
+    PrintHeader("Encoding same shaped images, EncodeJxlHDR per image vs one JxlEncoderSession (ms per image)",
+                { "size", "one-shot", "session", "speedup", "allocations", "same output" });
+    for (uint32_t size : { 128u, 256u, 512u, 1024u }) {
+        const std::vector<uint8_t> pixels = MakeTestPixels(size, size);
+        const int iterations = static_cast<int>(std::max<uint32_t>(5, 200 * 128 * 128 / (size * size)));
+
+        std::vector<uint8_t> oneShotOutput;
+        double oneShot = MeasureMicroseconds(iterations, [&] {
+            oneShotOutput.clear();
+            Check(EncodeJxlHDR(pixels, size, size, &oneShotOutput, profile.numChannels,
+                               profile.containerBitsPerSample, profile.originalBitsPerSample, profile.isFloat,
+                               nullptr, profile.transferFunction, profile.colorPrimaries,
+                               profile.compressionOption, profile.distance, profile.effort,
+                               profile.decodingSpeed),
+                  "encoding with EncodeJxlHDR");
+        });
+
+        JxlEncoderSession session(profile);
+        std::vector<uint8_t> sessionOutput;
+        double reused = MeasureMicroseconds(iterations, [&] {
+            sessionOutput.clear();
+            Check(session.encode(pixels, size, size, &sessionOutput), "encoding with a session");
+        });
+
+        const std::string label = std::to_string(size) + "x" + std::to_string(size);
+        PrintRow({ label, FormatNumber(oneShot / 1000.0, 2), FormatNumber(reused / 1000.0, 2),
+            FormatNumber(oneShot / reused, 2) + "x",
+            std::to_string(session.memoryStats().allocationCount),
+            sessionOutput == oneShotOutput ? "yes" : "no" });
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,67 @@
+//
+//  main.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlBenchmark.hpp"
+#include <cstdio>
+#include <cstring>
+
+/**
+ * Micro benchmarks of the codec core, run with
+ *     swift run -c release JxlBenchmark [name]
+ * Without a name every benchmark runs.
+ */
+int main(int argc, const char* argv[]) {
+    struct Benchmark {
+        const char* name;
+        int (*run)();
+    };
+    const Benchmark benchmarks[] = {
+        { "pool", jxlbench::RunPoolBenchmark },
+        { "region", jxlbench::RunRegionBenchmark },
+        { "batch", jxlbench::RunBatchBenchmark },
+        { "session", jxlbench::RunSessionBenchmark },
+    };
+
+    const char* requested = argc > 1 ? argv[1] : nullptr;
+    bool found = false;
+    for (const auto& benchmark : benchmarks) {
+        if (requested && std::strcmp(requested, benchmark.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (int result = benchmark.run()) {
+            return result;
+        }
+    }
+    if (!found) {
+        std::fprintf(stderr, "Unknown benchmark %s, available:", requested);
+        for (const auto& benchmark : benchmarks) {
+            std::fprintf(stderr, " %s", benchmark.name);
+        }
+        std::fprintf(stderr, "\n");
+        return 1;
+    }
+    return 0;
+}
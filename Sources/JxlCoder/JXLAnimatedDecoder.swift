@@ -32,8 +32,11 @@ public class JXLAnimatedDecoder {
 
     private let dec: CJpegXLAnimatedDecoder
 
-    public init(data: Data) throws {
-        dec = try CJpegXLAnimatedDecoder(data)
+    /***
+     - Parameter premultiplied: frames come out with color multiplied by alpha, as compositors expect it
+     **/
+    public init(data: Data, premultiplied: Bool = false) throws {
+        dec = try CJpegXLAnimatedDecoder(data, premultiplied: premultiplied)
     }
 
     public var numberOfFrames: Int {
@@ -52,4 +55,19 @@ public class JXLAnimatedDecoder {
         try dec.get(Int32(frame))
     }
 
+    public var numberOfLayers: Int {
+        Int(dec.layersCount())
+    }
+
+    /***
+     Blends the next stored layer onto a canvas kept by the decoder, decoding only the layer's rectangle.
+     Layers have to be composed in order, layer 0 starts over.
+     - Returns: the canvas and the rectangle of it that changed
+     **/
+    public func compose(layer: Int) throws -> (JXLPlatformImage, CGRect) {
+        var dirtyRect = CGRect.zero
+        let image = try dec.composeLayer(Int32(layer), dirtyRect: &dirtyRect)
+        return (image, dirtyRect)
+    }
+
 }
@@ -0,0 +1,47 @@
+//
+//  JXLCancellation.swift
+//  Jxl Coder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+import Foundation
+#if canImport(jxlc)
+import jxlc
+#endif
+
+public extension JXLCancellationToken {
+
+    /***
+     Runs body with the token applied to every JXLCoder call made from it on the calling thread
+     - Throws: CancellationError if the token was cancelled or its deadline passed, otherwise what body throws
+     **/
+    func run<T>(_ body: () throws -> T) throws -> T {
+        var result: Result<T, Error>?
+        performCancellable {
+            result = Result { try body() }
+        }
+        if case .failure = result, isCancelled() {
+            throw CancellationError()
+        }
+        return try result!.get()
+    }
+}
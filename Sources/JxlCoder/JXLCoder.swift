@@ -52,42 +52,226 @@ public class JXLCoder {
     /***
      - Parameter scale: scale of UIImage
      - Parameter rescale: image will be rescaled to provided size
+     - Parameter premultiplied: return color multiplied by alpha, as compositors expect it
      - Returns: Decoded JXL image if this is the valid one
      **/
     public static func decode(srcStream: InputStream, 
                               rescale: CGSize = .zero,
                               scale: Int = 1,
-                              pixelFormat: JXLPreferredPixelFormat = .optimal) throws -> JXLPlatformImage {
-        return try shared.decode(srcStream, rescale: rescale, pixelFormat: pixelFormat, scale: Int32(scale))
+                              pixelFormat: JXLPreferredPixelFormat = .optimal,
+                              premultiplied: Bool = false) throws -> JXLPlatformImage {
+        return try shared.decode(srcStream, rescale: rescale, pixelFormat: pixelFormat,
+                                 premultiplied: premultiplied, scale: Int32(scale))
     }
 
     /***
      - Parameter scale: scale of UIImage
      - Parameter sampleSize: if image size larger than sampler then it will be resized to sample
+     - Parameter premultiplied: return color multiplied by alpha, as compositors expect it
      - Returns: Decoded JXL image if this is the valid one
      **/
     public static func decode(url: URL, 
                               rescale: CGSize = .zero,
                               scale: Int = 1,
-                              pixelFormat: JXLPreferredPixelFormat = .optimal) throws -> JXLPlatformImage {
+                              pixelFormat: JXLPreferredPixelFormat = .optimal,
+                              premultiplied: Bool = false) throws -> JXLPlatformImage {
         guard let srcStream = InputStream(url: url) else {
             throw NSError(domain: "JXLCoder", code: 500,
                           userInfo: [NSLocalizedDescriptionKey: "JXLCoder cannot open provided URL"])
         }
-        return try shared.decode(srcStream, rescale: rescale, pixelFormat: pixelFormat, scale: Int32(scale))
+        return try shared.decode(srcStream, rescale: rescale, pixelFormat: pixelFormat,
+                                 premultiplied: premultiplied, scale: Int32(scale))
     }
 
     /***
      - Parameter scale: scale of UIImage
      - Parameter rescale: image will be rescaled to provided size
+     - Parameter premultiplied: return color multiplied by alpha, as compositors expect it
      - Returns: Decoded JXL image if this is the valid one
      **/
     public static func decode(data: Data, 
                               rescale: CGSize = .zero,
                               scale: Int = 1,
+                              pixelFormat: JXLPreferredPixelFormat = .optimal,
+                              premultiplied: Bool = false) throws -> JXLPlatformImage {
+        let srcStream = InputStream(data: data)
+        return try shared.decode(srcStream, rescale: rescale, pixelFormat: pixelFormat,
+                                 premultiplied: premultiplied, scale: Int32(scale))
+    }
+
+    /***
+     Decodes with pixels converted into the target color space in the same pass, so they need no further color matching
+     - Parameter colorSpace: space of the returned pixels, the image is tagged with it
+     - Parameter scale: scale of UIImage
+     - Parameter premultiplied: return color multiplied by alpha, as compositors expect it
+     - Returns: Decoded JXL image if this is the valid one
+     **/
+    public static func decode(data: Data,
+                              colorSpace: JXLTargetColorSpace,
+                              scale: Int = 1,
+                              pixelFormat: JXLPreferredPixelFormat = .optimal,
+                              premultiplied: Bool = false) throws -> JXLPlatformImage {
+        let srcStream = InputStream(data: data)
+        return try shared.decode(srcStream, colorSpace: colorSpace, pixelFormat: pixelFormat,
+                                 premultiplied: premultiplied, scale: Int32(scale))
+    }
+
+    /***
+     Decodes with pixels converted into the target color space in the same pass, so they need no further color matching
+     - Parameter colorSpace: space of the returned pixels, the image is tagged with it
+     - Parameter scale: scale of UIImage
+     - Parameter premultiplied: return color multiplied by alpha, as compositors expect it
+     - Returns: Decoded JXL image if this is the valid one
+     **/
+    public static func decode(url: URL,
+                              colorSpace: JXLTargetColorSpace,
+                              scale: Int = 1,
+                              pixelFormat: JXLPreferredPixelFormat = .optimal,
+                              premultiplied: Bool = false) throws -> JXLPlatformImage {
+        guard let srcStream = InputStream(url: url) else {
+            throw NSError(domain: "JXLCoder", code: 500,
+                          userInfo: [NSLocalizedDescriptionKey: "JXLCoder cannot open provided URL"])
+        }
+        return try shared.decode(srcStream, colorSpace: colorSpace, pixelFormat: pixelFormat,
+                                 premultiplied: premultiplied, scale: Int32(scale))
+    }
+
+    /***
+     Decodes only the requested part of the image, useful for tiles out of very large images
+     - Parameter region: rectangle in displayed image coordinates, must fit into the image
+     - Parameter scale: scale of UIImage
+     - Returns: Decoded region of JXL image if this is the valid one
+     **/
+    public static func decode(data: Data,
+                              region: CGRect,
+                              scale: Int = 1,
                               pixelFormat: JXLPreferredPixelFormat = .optimal) throws -> JXLPlatformImage {
         let srcStream = InputStream(data: data)
-        return try shared.decode(srcStream, rescale: rescale, pixelFormat: pixelFormat, scale: Int32(scale))
+        return try shared.decode(srcStream, region: region, pixelFormat: pixelFormat, scale: Int32(scale))
+    }
+
+    /***
+     Decodes only the requested part of the image, useful for tiles out of very large images
+     - Parameter region: rectangle in displayed image coordinates, must fit into the image
+     - Parameter scale: scale of UIImage
+     - Returns: Decoded region of JXL image if this is the valid one
+     **/
+    public static func decode(url: URL,
+                              region: CGRect,
+                              scale: Int = 1,
+                              pixelFormat: JXLPreferredPixelFormat = .optimal) throws -> JXLPlatformImage {
+        guard let srcStream = InputStream(url: url) else {
+            throw NSError(domain: "JXLCoder", code: 500,
+                          userInfo: [NSLocalizedDescriptionKey: "JXLCoder cannot open provided URL"])
+        }
+        return try shared.decode(srcStream, region: region, pixelFormat: pixelFormat, scale: Int32(scale))
+    }
+
+    /***
+     Preview first decoding for list views: the embedded preview when it covers the minimum size,
+     otherwise the cheapest reduced resolution step that does
+     - Parameter minimumSize: smallest acceptable size, the result is not resampled down to it
+     - Parameter scale: scale of UIImage
+     **/
+    public static func preview(data: Data,
+                               minimumSize: CGSize,
+                               scale: Int = 1,
+                               pixelFormat: JXLPreferredPixelFormat = .optimal) throws -> JXLPlatformImage {
+        let srcStream = InputStream(data: data)
+        return try shared.preview(srcStream, minimumSize: minimumSize, pixelFormat: pixelFormat, scale: Int32(scale))
+    }
+
+    /***
+     Decodes at full resolution and reads Exif and XMP in the same pass over the data
+     - Parameter scale: scale of UIImage
+     - Returns: Decoded JXL image and its metadata
+     **/
+    public static func decodeWithMetadata(data: Data,
+                                          scale: Int = 1,
+                                          pixelFormat: JXLPreferredPixelFormat = .optimal,
+                                          premultiplied: Bool = false) throws -> (JXLPlatformImage, JXLMetadata) {
+        let srcStream = InputStream(data: data)
+        var boxes: [JXLMetadataBox]?
+        let image = try shared.decode(srcStream, pixelFormat: pixelFormat, premultiplied: premultiplied,
+                                      scale: Int32(scale), boxes: &boxes)
+        return (image, JXLMetadata(boxes: boxes ?? []))
+    }
+
+    /***
+     Reads Exif, XMP, JUMBF and any other metadata boxes without decoding pixels, Brotli compressed boxes come out decompressed
+     - Returns: Boxes in file order
+     **/
+    public static func boxes(data: Data) throws -> [JXLMetadataBox] {
+        let srcStream = InputStream(data: data)
+        return try shared.boxes(srcStream)
+    }
+
+    /***
+     Releases decoders kept for reuse and the memory they cache, call it on memory warnings
+     **/
+    public static func purgeCaches() {
+        JxlInternalCoder.purgeCaches()
+    }
+
+    /***
+     Reads Exif and XMP without decoding pixels
+     **/
+    public static func metadata(data: Data) throws -> JXLMetadata {
+        return JXLMetadata(boxes: try boxes(data: data))
+    }
+
+    /***
+     Decodes many images at once, small ones side by side on single threads and large ones split across threads
+     - Parameter images: encoded images, result indices refer to this array
+     - Parameter completion: called once per image from worker threads, possibly concurrently
+     - Parameter scale: scale of UIImage
+     **/
+    public static func decode(batch images: [Data],
+                              scale: Int = 1,
+                              pixelFormat: JXLPreferredPixelFormat = .optimal,
+                              premultiplied: Bool = false,
+                              completion: @escaping (Int, Result<JXLPlatformImage, Error>) -> Void) {
+        shared.decodeBatch(images, pixelFormat: pixelFormat, premultiplied: premultiplied,
+                           scale: Int32(scale)) { index, image, error in
+            if let image {
+                completion(index, .success(image))
+            } else {
+                completion(index, .failure(error ?? NSError(domain: "JXLCoder", code: 500,
+                                                            userInfo: [NSLocalizedDescriptionKey: "Failed to decode JXL image"])))
+            }
+        }
+    }
+
+    /***
+     Encodes many images at once, extracting the pixels of some images while others are being encoded
+     - Parameter images: result indices refer to this array
+     - Parameter metadata: nil, or one entry per image
+     - Parameter maxThreads: images in flight at once, 0 uses every thread of the shared executor
+     - Parameter maxInFlightBytes: bound on the pixel memory of the images in flight, 0 keeps the default of 1 GiB
+     - Parameter completion: called once per image from worker threads, possibly concurrently
+     **/
+    public static func encodeHDR(batch images: [JXLPlatformImage],
+                                 metadata: [JXLMetadata?]? = nil,
+                                 compressionOption: JXLCompressionOption = .lossless,
+                                 effort: Int = 7,
+                                 distance: Float = 1.0,
+                                 decodingSpeed: JXLEncoderDecodingSpeed = .slowest,
+                                 maxThreads: Int = 0,
+                                 maxInFlightBytes: UInt64 = 0,
+                                 completion: @escaping (Int, Result<Data, Error>) -> Void) {
+        let exifData = metadata?.map { $0?.exifData ?? Data() }
+        let xmpData = metadata?.map { $0?.xmpData ?? Data() }
+        shared.encodeHDRBatch(images, exifData: exifData, xmpData: xmpData,
+                              compressionOption: compressionOption, effort: Int32(effort),
+                              distance: distance, decodingSpeed: decodingSpeed,
+                              maxThreads: maxThreads, maxInFlightBytes: maxInFlightBytes) { index, data, error in
+            if let data {
+                completion(index, .success(data))
+            } else {
+                completion(index, .failure(error ?? NSError(domain: "JXLCoder", code: 500,
+                                                            userInfo: [NSLocalizedDescriptionKey: "JXL HDR encoding failed"])))
+            }
+        }
     }
 
     /***
@@ -124,6 +308,22 @@ public class JXLCoder {
         return try JxlConstruction.inverse(jxlData)
     }
     
+    /***
+     Reads only the image headers, suitable for upload validation and list views
+     - Returns: `.complete` with the image descriptor, or `.needMoreData` with a hint of the prefix length to retry with
+     **/
+    public static func probe(data: Data) throws -> JXLProbeResult {
+        var neededBytes: Int = 0
+        if let descriptor = shared.probe(data, neededBytes: &neededBytes) {
+            return .complete(descriptor)
+        }
+        if neededBytes == 0 {
+            throw NSError(domain: "JXLCoder", code: 500,
+                          userInfo: [NSLocalizedDescriptionKey: "Not an JXL image"])
+        }
+        return .needMoreData(neededBytes)
+    }
+
     /***
      - Returns: size of the image, if successfully get this
      **/
@@ -211,6 +411,7 @@ public class JXLCoder {
     ///   - distance: Lossy compression distance (0.0 = lossless, 1.0 = visually lossless, 15.0 = max lossy).
     ///               Only used when `compressionOption` is `.lossy`. Default 1.0 (visually lossless).
     ///   - decodingSpeed: Trade decode speed vs file size
+    ///   - embedPreview: Store low resolution steps first, so `preview(data:minimumSize:)` reads only a small prefix
     /// - Returns: JXL encoded data preserving full color fidelity, bit depth, and metadata
     /// - Throws: If encoding fails
     public static func encodeHDR(
@@ -219,7 +420,8 @@ public class JXLCoder {
         compressionOption: JXLCompressionOption = .lossless,
         effort: Int = 7,
         distance: Float = 1.0,
-        decodingSpeed: JXLEncoderDecodingSpeed = .slowest
+        decodingSpeed: JXLEncoderDecodingSpeed = .slowest,
+        embedPreview: Bool = false
     ) throws -> Data {
         return try shared.encodeHDR(
             image,
@@ -228,7 +430,124 @@ public class JXLCoder {
             compressionOption: compressionOption,
             effort: Int32(effort),
             distance: distance,
-            decodingSpeed: decodingSpeed
+            decodingSpeed: decodingSpeed,
+            embedPreview: embedPreview
+        )
+    }
+
+    /// Encode image preserving HDR/wide color gamut, original bit depth, and metadata straight into a file.
+    ///
+    /// Compressed bytes are written while they are produced, so the encoded file is never held in memory.
+    /// Parameters are the same as in `encodeHDR(image:metadata:)`.
+    /// - Parameter url: destination file, replaced if it exists
+    /// - Throws: If encoding or writing fails
+    public static func encodeHDR(
+        image: JXLPlatformImage,
+        metadata: JXLMetadata?,
+        to url: URL,
+        compressionOption: JXLCompressionOption = .lossless,
+        effort: Int = 7,
+        distance: Float = 1.0,
+        decodingSpeed: JXLEncoderDecodingSpeed = .slowest,
+        embedPreview: Bool = false
+    ) throws {
+        guard let outputStream = OutputStream(url: url, append: false) else {
+            throw NSError(domain: "JXLCoder", code: 500,
+                          userInfo: [NSLocalizedDescriptionKey: "JXLCoder cannot open provided URL"])
+        }
+        try shared.encodeHDR(
+            image,
+            exifData: metadata?.exifData,
+            xmpData: metadata?.xmpData,
+            compressionOption: compressionOption,
+            effort: Int32(effort),
+            distance: distance,
+            decodingSpeed: decodingSpeed,
+            embedPreview: embedPreview,
+            outputStream: outputStream
+        )
+    }
+
+    /// Encode a very large image preserving HDR/wide color gamut, original bit depth, and metadata into a file
+    /// with bounded memory.
+    ///
+    /// Pixels are converted a few groups at a time while the encoder streams the frame, and compressed
+    /// bytes are written as they are produced, so neither a converted copy of the image nor the file is held
+    /// in memory. Streaming costs some density and the file is not progressive, so there is no `embedPreview`.
+    /// Other parameters are the same as in `encodeHDR(image:metadata:)`.
+    /// - Parameter url: destination file, replaced if it exists
+    /// - Throws: If encoding or writing fails
+    public static func encodeHDRChunked(
+        image: JXLPlatformImage,
+        metadata: JXLMetadata?,
+        to url: URL,
+        compressionOption: JXLCompressionOption = .lossless,
+        effort: Int = 7,
+        distance: Float = 1.0,
+        decodingSpeed: JXLEncoderDecodingSpeed = .slowest
+    ) throws {
+        guard let outputStream = OutputStream(url: url, append: false) else {
+            throw NSError(domain: "JXLCoder", code: 500,
+                          userInfo: [NSLocalizedDescriptionKey: "JXLCoder cannot open provided URL"])
+        }
+        try shared.encodeHDRChunked(
+            image,
+            exifData: metadata?.exifData,
+            xmpData: metadata?.xmpData,
+            compressionOption: compressionOption,
+            effort: Int32(effort),
+            distance: distance,
+            decodingSpeed: decodingSpeed,
+            outputStream: outputStream
         )
     }
+
+    /// Lossy encoding that finds the distance meeting `target` instead of taking one.
+    /// Candidates are encoded at low effort in parallel to predict the distance, the result is encoded at `effort`.
+    /// - Parameter target: maximum file size in bytes, or minimum mean luma SSIM in 0...1
+    /// - Parameter maxTrials: upper bound on encodes made in total, at least 2
+    /// - Returns: the encoded file, the closest candidate when the target cannot be met within `maxTrials`
+    /// - Throws: If encoding fails
+    public static func encodeHDR(
+        image: JXLPlatformImage,
+        metadata: JXLMetadata? = nil,
+        target: JXLRateTarget,
+        effort: Int = 7,
+        decodingSpeed: JXLEncoderDecodingSpeed = .slowest,
+        maxTrials: Int = 6
+    ) throws -> Data {
+        let rateTarget: jxlc.JXLRateTarget
+        let targetValue: Double
+        switch target {
+        case .fileSize(let bytes):
+            rateTarget = .fileSize
+            targetValue = Double(bytes)
+        case .ssim(let score):
+            rateTarget = .ssim
+            targetValue = Double(score)
+        }
+        return try shared.encodeHDR(
+            image,
+            exifData: metadata?.exifData,
+            xmpData: metadata?.xmpData,
+            rateTarget: rateTarget,
+            targetValue: targetValue,
+            effort: Int32(effort),
+            decodingSpeed: decodingSpeed,
+            maxTrials: Int32(maxTrials)
+        )
+    }
+}
+
+public enum JXLRateTarget {
+    /// Largest acceptable file size in bytes
+    case fileSize(Int)
+    /// Smallest acceptable mean SSIM of the luma, 0...1
+    case ssim(Float)
+}
+
+public enum JXLProbeResult {
+    case complete(JXLImageDescriptor)
+    /// Headers continue past the provided data, retry with at least this many bytes from the start
+    case needMoreData(Int)
 }
@@ -0,0 +1,54 @@
+//
+//  JXLEncoderSession.swift
+//  Jxl Coder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+import Foundation
+#if canImport(jxlc)
+import jxlc
+#endif
+
+/// Encodes many images with the same settings, e.g. a stream of same-shaped photos.
+/// The encoder, its memory and the thread runner are kept between images instead of being
+/// set up again for every call to `JXLCoder.encodeHDR`.
+/// A session encodes one image at a time, use one session per thread.
+public class JXLEncoderSession {
+
+    private let session: CJpegXLEncoderSession
+
+    /// Parameters have the same meaning as in `JXLCoder.encodeHDR(image:metadata:)`
+    public init(compressionOption: JXLCompressionOption = .lossless,
+                effort: Int = 7,
+                distance: Float = 1.0,
+                decodingSpeed: JXLEncoderDecodingSpeed = .slowest) throws {
+        session = try CJpegXLEncoderSession(compressionOption,
+                                            effort: Int32(effort),
+                                            distance: distance,
+                                            decodingSpeed: decodingSpeed)
+    }
+
+    /// Encodes image preserving HDR/wide color gamut, original bit depth, and metadata
+    public func encode(image: JXLPlatformImage, metadata: JXLMetadata? = nil) throws -> Data {
+        try session.encode(image, exifData: metadata?.exifData, xmpData: metadata?.xmpData)
+    }
+}
@@ -120,6 +120,23 @@ public struct JXLMetadata {
         return try JXLMetadata(properties: properties)
     }
 
+    /// Build metadata from boxes read out of a JXL container.
+    ///
+    /// The first Exif and "xml " boxes are used, the 4-byte TIFF header offset is skipped.
+    ///
+    /// - Parameter boxes: Boxes returned by `JXLCoder.boxes(data:)` or `JXLCoder.decodeWithMetadata(data:)`
+    public init(boxes: [JXLMetadataBox]) {
+        var exif: Data? = nil
+        if let box = boxes.first(where: { $0.type == "Exif" }), box.data.count >= 4 {
+            let offset = box.data.prefix(4).reduce(0) { ($0 << 8) | Int($1) }
+            if offset <= box.data.count - 4 {
+                exif = box.data.subdata(in: (4 + offset)..<box.data.count)
+            }
+        }
+        self.exifData = exif
+        self.xmpData = boxes.first(where: { $0.type == "xml " })?.data
+    }
+
     // MARK: - Private
 
     /// Serialize ImageIO properties dictionary to raw EXIF bytes.
@@ -0,0 +1,64 @@
+//
+//  JXLProgressiveDecoder.swift
+//  Jxl Coder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+import Foundation
+#if canImport(jxlc)
+import jxlc
+#endif
+
+/// Decodes JXL image while it is being downloaded.
+/// Intermediate images become available at DC and pass boundaries before the whole file has arrived.
+public class JXLProgressiveDecoder {
+
+    private let dec: CJpegXLProgressiveDecoder
+
+    public init(pixelFormat: JXLPreferredPixelFormat = .optimal) throws {
+        dec = try CJpegXLProgressiveDecoder(pixelFormat)
+    }
+
+    /**
+     - Parameter data: next chunk of the file
+     - Returns: true if a new image is available through `image()`
+     */
+    @discardableResult
+    public func append(data: Data) throws -> Bool {
+        try dec.append(data)
+        return dec.hasUpdate()
+    }
+
+    /// Call once the whole file was appended
+    public func finish() throws {
+        try dec.finish()
+    }
+
+    public var isComplete: Bool {
+        dec.isComplete()
+    }
+
+    public func image(scale: Int = 1) throws -> JXLPlatformImage {
+        try dec.image(Int32(scale))
+    }
+
+}
@@ -31,11 +31,24 @@
 
 @interface CJpegXLAnimatedDecoder : NSObject
 -(nullable id)initWith:(nonnull NSData*)data error:(NSError * _Nullable *_Nullable)error;
+/// With premultiplied frames come out with color multiplied by alpha, ready for compositing
+-(nullable id)initWith:(nonnull NSData*)data
+         premultiplied:(bool)premultiplied
+                 error:(NSError * _Nullable *_Nullable)error;
 -(NSUInteger)framesCount;
 -(int)frameDuration:(int)frame;
 -(int)loopCount;
 -(nullable JXLSystemImage *)get:(int)frame
                             error:(NSError *_Nullable * _Nullable)error;
+/// Layers as stored in the file, several of them may make up one displayed frame
+-(NSUInteger)layersCount;
+/// Decodes only the layer's own rectangle and blends it onto a canvas kept between calls.
+/// Composing the layer after the previous one blends only that layer, any other index composes
+/// the canvas again from layer 0 and reports all of it as dirty.
+/// @param dirtyRect receives the part of the canvas that changed
+-(nullable JXLSystemImage *)composeLayer:(int)layer
+                               dirtyRect:(CGRect * _Nullable)dirtyRect
+                                   error:(NSError *_Nullable * _Nullable)error;
 @end
 
 #endif /* JPEGXL_ANIMATED_DECODER_H */
@@ -26,6 +26,8 @@
 #import <Foundation/Foundation.h>
 #import "CJpegXLAnimatedDecoder.h"
 #import "JxlAnimatedDecoder.hpp"
+#import "JxlLayerCompositor.hpp"
+#include <memory>
 #include <vector>
 
 template <typename DataType>
@@ -43,15 +45,25 @@ static void JXLDCGData8ProviderReleaseDataCallback(void *info, const void *data,
 @implementation CJpegXLAnimatedDecoder {
     JxlAnimatedDecoder* dec;
     std::vector<uint8_t> mSrc;
+    std::unique_ptr<jxlcoder::JxlLayerCompositor> compositor;
+    // Layer the canvas was last composed up to, -1 before the first one
+    int composedLayer;
 }
 
 -(nullable id)initWith:(nonnull NSData*)data error:(NSError * _Nullable *_Nullable)error {
+    return [self initWith:data premultiplied:false error:error];
+}
+
+-(nullable id)initWith:(nonnull NSData*)data
+         premultiplied:(bool)premultiplied
+                 error:(NSError * _Nullable *_Nullable)error {
     dec = nullptr;
+    composedLayer = -1;
     try {
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>([data bytes]);
         mSrc.resize([data length]);
         std::copy(ptr, ptr + [data length], mSrc.begin());
-        dec = new JxlAnimatedDecoder(mSrc);
+        dec = new JxlAnimatedDecoder(mSrc, premultiplied);
     } catch (AnimatedDecoderError& err) {
         NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
         *error = [[NSError alloc] initWithDomain:@"JpegXLAnimatedDecoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
@@ -64,68 +76,75 @@ static void JXLDCGData8ProviderReleaseDataCallback(void *info, const void *data,
     return self;
 }
 
--(nullable JXLSystemImage *)get:(int)frame
-                            error:(NSError *_Nullable * _Nullable)error {
-    try {
-        JxlFrame jxlFrame = dec->getFrame(frame);
-        auto wrapper = new JXLDDataWrapper<uint8_t>(jxlFrame.pixels);
-
-        CGDataProviderRef provider = CGDataProviderCreateWithData(wrapper,
-                                                                  wrapper->data.data(),
-                                                                  wrapper->data.size(),
-                                                                  JXLDCGData8ProviderReleaseDataCallback);
-        if (!provider) {
-            delete wrapper;
-            *error = [[NSError alloc] initWithDomain:@"JXLCoder"
-                                                code:500
-                                            userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate required provider" }];
-            return nullptr;
-        }
+static JXLSystemImage * _Nullable JXLDCreateImage(const std::vector<uint8_t>& pixels, int width, int height,
+                                                 const std::vector<uint8_t>& iccProfile, bool premultiplied,
+                                                 NSError * _Nullable * _Nullable error) {
+    auto wrapper = new JXLDDataWrapper<uint8_t>(pixels);
+
+    CGDataProviderRef provider = CGDataProviderCreateWithData(wrapper,
+                                                              wrapper->data.data(),
+                                                              wrapper->data.size(),
+                                                              JXLDCGData8ProviderReleaseDataCallback);
+    if (!provider) {
+        delete wrapper;
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate required provider" }];
+        return nullptr;
+    }
 
-        int bitsPerComponent = sizeof(uint8_t) * 8;
-        int components = 4;
-        int bitsPerPixel = bitsPerComponent*components;
-        int stride = 4 * dec->getWidth() * sizeof(uint8_t);
+    int bitsPerComponent = sizeof(uint8_t) * 8;
+    int components = 4;
+    int bitsPerPixel = bitsPerComponent*components;
+    int stride = 4 * width * sizeof(uint8_t);
+
+    CGColorSpaceRef colorSpace;
+    if (iccProfile.size() > 0) {
+        CFDataRef iccData = CFDataCreate(kCFAllocatorDefault, iccProfile.data(), iccProfile.size());
+        colorSpace = CGColorSpaceCreateWithICCData(iccData);
+        CFRelease(iccData);
+    } else {
+        colorSpace = CGColorSpaceCreateDeviceRGB();
+    }
 
-        CGColorSpaceRef colorSpace;
-        if (jxlFrame.iccProfile.size() > 0) {
-            CFDataRef iccData = CFDataCreate(kCFAllocatorDefault, jxlFrame.iccProfile.data(), jxlFrame.iccProfile.size());
-            colorSpace = CGColorSpaceCreateWithICCData(iccData);
-            CFRelease(iccData);
-        } else {
-            colorSpace = CGColorSpaceCreateDeviceRGB();
-        }
+    if (!colorSpace) {
+        colorSpace = CGColorSpaceCreateDeviceRGB();
+    }
 
-        if (!colorSpace) {
-            colorSpace = CGColorSpaceCreateDeviceRGB();
-        }
+    int flags;
+    flags = (int)kCGImageByteOrderDefault;
+    if (components == 4) {
+        flags |= premultiplied ? (int)kCGImageAlphaPremultipliedLast : (int)kCGImageAlphaLast;
+    } else {
+        flags |= (int)kCGImageAlphaNone;
+    }
 
-        int flags;
-        flags = (int)kCGImageByteOrderDefault;
-        if (components == 4) {
-            flags |= (int)kCGImageAlphaLast;
-        } else {
-            flags |= (int)kCGImageAlphaNone;
-        }
+    CGImageRef imageRef = CGImageCreate(width, height, bitsPerComponent,
+                                        bitsPerPixel,
+                                        stride,
+                                        colorSpace, flags, provider, NULL, false, kCGRenderingIntentDefault);
+    if (!imageRef) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate CGImageRef" }];
+        return NULL;
+    }
+    JXLSystemImage *image = nil;
+#if JXL_PLUGIN_MAC
+    image = [[NSImage alloc] initWithCGImage:imageRef size:CGSizeZero];
+#else
+    image = [UIImage imageWithCGImage:imageRef scale:1 orientation:UIImageOrientationUp];
+#endif
+
+    return image;
+}
 
-        CGImageRef imageRef = CGImageCreate(dec->getWidth(), dec->getHeight(), bitsPerComponent,
-                                            bitsPerPixel,
-                                            stride,
-                                            colorSpace, flags, provider, NULL, false, kCGRenderingIntentDefault);
-        if (!imageRef) {
-            *error = [[NSError alloc] initWithDomain:@"JXLCoder"
-                                                code:500
-                                            userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate CGImageRef" }];
-            return NULL;
-        }
-        JXLSystemImage *image = nil;
-    #if JXL_PLUGIN_MAC
-        image = [[NSImage alloc] initWithCGImage:imageRef size:CGSizeZero];
-    #else
-        image = [UIImage imageWithCGImage:imageRef scale:1 orientation:UIImageOrientationUp];
-    #endif
-
-        return image;
+-(nullable JXLSystemImage *)get:(int)frame
+                            error:(NSError *_Nullable * _Nullable)error {
+    try {
+        JxlFrame jxlFrame = dec->getFrame(frame);
+        return JXLDCreateImage(jxlFrame.pixels, dec->getWidth(), dec->getHeight(),
+                               jxlFrame.iccProfile, dec->isPremultiplied(), error);
     } catch (AnimatedDecoderError& err) {
         NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
         *error = [[NSError alloc] initWithDomain:@"JpegXLAnimatedDecoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
@@ -137,6 +156,52 @@ static void JXLDCGData8ProviderReleaseDataCallback(void *info, const void *data,
     }
 }
 
+-(NSUInteger)layersCount {
+    return static_cast<NSUInteger>(dec->getNumberOfLayers());
+}
+
+-(nullable JXLSystemImage *)composeLayer:(int)layer
+                               dirtyRect:(CGRect * _Nullable)dirtyRect
+                                   error:(NSError *_Nullable * _Nullable)error {
+    try {
+        if (layer < 0 || layer >= dec->getNumberOfLayers()) {
+            throw AnimatedDecoderError("Requested layer index is out of range");
+        }
+        jxlcoder::JxlLayerRect rect;
+        if (!compositor || layer != composedLayer + 1) {
+            // Layers blend onto the canvas and references the earlier ones left, anything
+            // but the next layer is composed again from the first one
+            composedLayer = -1;
+            compositor = std::make_unique<jxlcoder::JxlLayerCompositor>(dec->getWidth(), dec->getHeight(),
+                                                                        dec->isPremultiplied());
+            for (int i = 0; i < layer; ++i) {
+                JxlLayer earlier = dec->getLayer(i);
+                compositor->apply(earlier);
+            }
+            JxlLayer jxlLayer = dec->getLayer(layer);
+            compositor->apply(jxlLayer);
+            rect = { .x = 0, .y = 0,
+                .width = static_cast<uint32_t>(dec->getWidth()), .height = static_cast<uint32_t>(dec->getHeight()) };
+        } else {
+            JxlLayer jxlLayer = dec->getLayer(layer);
+            rect = compositor->apply(jxlLayer);
+        }
+        composedLayer = layer;
+        if (dirtyRect) {
+            *dirtyRect = CGRectMake(rect.x, rect.y, rect.width, rect.height);
+        }
+        return JXLDCreateImage(compositor->canvas(), dec->getWidth(), dec->getHeight(),
+                               dec->getIccProfile(), dec->isPremultiplied(), error);
+    } catch (std::exception& err) {
+        // The canvas may hold a partly blended layer
+        compositor.reset();
+        composedLayer = -1;
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JpegXLAnimatedDecoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    }
+}
+
 -(NSUInteger)framesCount {
     return static_cast<NSUInteger>(dec->getNumberOfFrames());
 }
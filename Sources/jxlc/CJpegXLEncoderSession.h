@@ -0,0 +1,45 @@
+//
+//  CJpegXLEncoderSession.h
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JPEGXL_ENCODER_SESSION_H
+#define JPEGXL_ENCODER_SESSION_H
+
+#import "JXLSystemImage.hpp"
+#import <Foundation/Foundation.h>
+
+@interface CJpegXLEncoderSession : NSObject
+-(nullable id)initWith:(JXLCompressionOption)compressionOption
+                effort:(int)effort
+              distance:(float)distance
+         decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+                 error:(NSError * _Nullable *_Nullable)error;
+/// Encodes one image preserving its bit depth and color the same way encodeHDR does, on the session's encoder
+-(nullable NSData*)encode:(nonnull JXLSystemImage *)platformImage
+                 exifData:(nullable NSData *)exifData
+                  xmpData:(nullable NSData *)xmpData
+                    error:(NSError * _Nullable *_Nullable)error;
+@end
+
+#endif /* JPEGXL_ENCODER_SESSION_H */
@@ -0,0 +1,148 @@
+//
+//  CJpegXLEncoderSession.mm
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "CJpegXLEncoderSession.h"
+#import "JxlEncoderSession.hpp"
+#include <vector>
+
+class JXLSessionDataWrapper {
+public:
+    std::vector<uint8_t> data;
+};
+
+static std::vector<uint8_t> JXLSessionBytes(NSData * _Nullable data) {
+    if (!data || data.length == 0) {
+        return {};
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data.bytes);
+    return std::vector<uint8_t>(bytes, bytes + data.length);
+}
+
+@implementation CJpegXLEncoderSession {
+    JxlEncoderSession* session;
+}
+
+-(nullable id)initWith:(JXLCompressionOption)compressionOption
+                effort:(int)effort
+              distance:(float)distance
+         decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+                 error:(NSError * _Nullable *_Nullable)error {
+    session = nullptr;
+    if (distance < 0.0f || distance > 25.0f) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: @"Distance must be in range 0.0...25.0" }];
+        return nil;
+    }
+    if (effort < 1 || effort > 9) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: @"Effort must be clamped in 1...9" }];
+        return nil;
+    }
+
+    JxlEncoderProfile profile;
+    profile.compressionOption = compressionOption == kLossless ? lossless : lossy;
+    profile.distance = distance;
+    profile.effort = effort;
+    profile.decodingSpeed = (int)decodingSpeed;
+    try {
+        session = new JxlEncoderSession(profile);
+    } catch (EncoderSessionError& err) {
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    } catch (std::bad_alloc &err) {
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    }
+    return self;
+}
+
+-(nullable NSData*)encode:(nonnull JXLSystemImage *)platformImage
+                 exifData:(nullable NSData *)exifData
+                  xmpData:(nullable NSData *)xmpData
+                    error:(NSError * _Nullable *_Nullable)error {
+    JXLSessionDataWrapper* wrapper = new JXLSessionDataWrapper();
+    try {
+        std::vector<uint8_t> pixels;
+        std::vector<uint8_t> iccProfile;
+        JXLImageInfo info;
+        if (![platformImage jxlExtractPixels:pixels iccProfile:iccProfile info:&info]) {
+            delete wrapper;
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+                                            userInfo:@{ NSLocalizedDescriptionKey: @"Failed to extract pixel data from image" }];
+            return nil;
+        }
+        if (info.width <= 0 || info.height <= 0) {
+            delete wrapper;
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+                                            userInfo:@{ NSLocalizedDescriptionKey: @"Width and height must be > 0" }];
+            return nil;
+        }
+
+        // Layout and color come from each image, quality settings stay as the session was created with
+        JxlEncoderProfile& profile = session->profile();
+        profile.numChannels = info.bitsPerPixel / info.bitsPerComponent;
+        profile.containerBitsPerSample = info.bitsPerComponent;
+        profile.originalBitsPerSample = info.originalBitsPerComponent;
+        profile.isFloat = info.isFloat;
+        profile.iccProfile = std::move(iccProfile);
+        profile.transferFunction = static_cast<JxlTransferFunctionType>(info.transferFunction);
+        profile.colorPrimaries = static_cast<JxlColorPrimariesType>(info.colorPrimaries);
+
+        std::vector<uint8_t> exifVector = JXLSessionBytes(exifData);
+        std::vector<uint8_t> xmpVector = JXLSessionBytes(xmpData);
+
+        if (!session->encode(pixels, info.width, info.height, &wrapper->data,
+                             exifVector.empty() ? nullptr : &exifVector,
+                             xmpVector.empty() ? nullptr : &xmpVector)) {
+            delete wrapper;
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+                                            userInfo:@{ NSLocalizedDescriptionKey: @"JXL HDR encoding failed" }];
+            return nil;
+        }
+
+        return [[NSData alloc] initWithBytesNoCopy:wrapper->data.data()
+                                            length:wrapper->data.size()
+                                       deallocator:^(void * _Nonnull bytes, NSUInteger length) {
+            delete wrapper;
+        }];
+    } catch (std::bad_alloc &err) {
+        delete wrapper;
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    }
+}
+
+-(void)dealloc {
+    if (session) {
+        delete session;
+        session = nullptr;
+    }
+}
+
+@end
@@ -0,0 +1,44 @@
+//
+//  CJpegXLProgressiveDecoder.h
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JPEGXL_PROGRESSIVE_DECODER_H
+#define JPEGXL_PROGRESSIVE_DECODER_H
+
+#import "JXLSystemImage.hpp"
+#import <Foundation/Foundation.h>
+
+@interface CJpegXLProgressiveDecoder : NSObject
+-(nullable id)initWith:(JXLPreferredPixelFormat)pixelFormat error:(NSError * _Nullable *_Nullable)error;
+/// Appends next chunk of the file and decodes as far as possible
+-(nullable void*)append:(nonnull NSData*)data error:(NSError * _Nullable *_Nullable)error;
+/// Signals that the whole file was appended
+-(nullable void*)finish:(NSError * _Nullable *_Nullable)error;
+/// True if a new intermediate or final image became available since the last call to `image`
+-(bool)hasUpdate;
+-(bool)isComplete;
+-(nullable JXLSystemImage *)image:(int)scale error:(NSError *_Nullable * _Nullable)error;
+@end
+
+#endif /* JPEGXL_PROGRESSIVE_DECODER_H */
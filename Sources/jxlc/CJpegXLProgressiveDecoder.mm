@@ -0,0 +1,197 @@
+//
+//  CJpegXLProgressiveDecoder.mm
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "CJpegXLProgressiveDecoder.h"
+#import "JxlProgressiveDecoder.hpp"
+#import "JXLBitmapFormat.h"
+#include <vector>
+#include <algorithm>
+
+template <typename DataType>
+class JXLPDataWrapper {
+public:
+    JXLPDataWrapper(const std::vector<DataType>& src): data(src) {}
+    const std::vector<DataType> data;
+};
+
+static void JXLPCGData8ProviderReleaseDataCallback(void *info, const void *data, size_t size) {
+    auto dataWrapper = static_cast<JXLPDataWrapper<uint8_t>*>(info);
+    delete dataWrapper;
+}
+
+@implementation CJpegXLProgressiveDecoder {
+    JxlProgressiveDecoder* dec;
+    bool updated;
+}
+
+-(nullable id)initWith:(JXLPreferredPixelFormat)pixelFormat error:(NSError * _Nullable *_Nullable)error {
+    dec = nullptr;
+    updated = false;
+    JxlDecodingPixelFormat jxlPixelFormat = JXLDecodingPixelFormat(pixelFormat);
+    try {
+        dec = new JxlProgressiveDecoder(jxlPixelFormat);
+    } catch (ProgressiveDecoderError& err) {
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JpegXLProgressiveDecoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    } catch (std::bad_alloc &err) {
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JpegXLProgressiveDecoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    }
+    return self;
+}
+
+-(nullable void*)append:(nonnull NSData*)data error:(NSError * _Nullable *_Nullable)error {
+    try {
+        auto status = dec->append(reinterpret_cast<const uint8_t*>([data bytes]), [data length]);
+        if (status != progressiveNeedMoreInput) {
+            updated = true;
+        }
+        return (__bridge void*)self;
+    } catch (ProgressiveDecoderError& err) {
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JpegXLProgressiveDecoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    } catch (std::bad_alloc &err) {
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JpegXLProgressiveDecoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    }
+}
+
+-(nullable void*)finish:(NSError * _Nullable *_Nullable)error {
+    try {
+        auto status = dec->close();
+        if (status != progressiveNeedMoreInput) {
+            updated = true;
+        }
+        return (__bridge void*)self;
+    } catch (ProgressiveDecoderError& err) {
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JpegXLProgressiveDecoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    }
+}
+
+-(bool)hasUpdate {
+    return updated;
+}
+
+-(bool)isComplete {
+    return dec->isComplete();
+}
+
+-(nullable JXLSystemImage *)image:(int)scale error:(NSError *_Nullable * _Nullable)error {
+    if (!dec->hasImage()) {
+        *error = [[NSError alloc] initWithDomain:@"JpegXLProgressiveDecoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: @"Not enough data to render an image yet" }];
+        return nil;
+    }
+    try {
+        updated = false;
+        auto wrapper = new JXLPDataWrapper<uint8_t>(dec->getPixels());
+
+        CGDataProviderRef provider = CGDataProviderCreateWithData(wrapper,
+                                                                  wrapper->data.data(),
+                                                                  wrapper->data.size(),
+                                                                  JXLPCGData8ProviderReleaseDataCallback);
+        if (!provider) {
+            delete wrapper;
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                                code:500
+                                            userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate required provider" }];
+            return nil;
+        }
+
+        size_t xSize = dec->getWidth();
+        size_t ySize = dec->getHeight();
+        auto orientation = dec->getOrientation();
+        if (orientation == Rotate90CW || orientation == Rotate90CCW
+            || orientation == AntiTranspose
+            || orientation == OrientTranspose) {
+            std::swap(xSize, ySize);
+        }
+
+        int components = dec->getComponents();
+        JxlDataType dataType = dec->getDataType();
+        size_t bitsPerComponent = JXLBitsPerComponent(dataType);
+        size_t bitsPerPixel = bitsPerComponent*components;
+        size_t stride = components * xSize * bitsPerComponent / 8;
+
+        CGColorSpaceRef colorSpace = nullptr;
+        auto& iccProfile = dec->getIccProfile();
+        if (iccProfile.size() > 0) {
+            CFDataRef iccData = CFDataCreate(kCFAllocatorDefault, iccProfile.data(), iccProfile.size());
+            colorSpace = CGColorSpaceCreateWithICCData(iccData);
+            CFRelease(iccData);
+        }
+        if (!colorSpace) {
+            if (components > 1) {
+                colorSpace = CGColorSpaceCreateDeviceRGB();
+            } else {
+                colorSpace = CGColorSpaceCreateDeviceGray();
+            }
+        }
+
+        CGBitmapInfo flags = JXLBitmapInfo(dataType, components);
+
+        CGImageRef imageRef = CGImageCreate(xSize, ySize, bitsPerComponent,
+                                            bitsPerPixel,
+                                            stride,
+                                            colorSpace, flags, provider, NULL, false, kCGRenderingIntentDefault);
+        CGDataProviderRelease(provider);
+        CGColorSpaceRelease(colorSpace);
+        if (!imageRef) {
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                                code:500
+                                            userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate CGImageRef" }];
+            return nil;
+        }
+        JXLSystemImage *image = nil;
+    #if JXL_PLUGIN_MAC
+        image = [[NSImage alloc] initWithCGImage:imageRef size:CGSizeZero];
+    #else
+        image = [UIImage imageWithCGImage:imageRef scale:scale orientation:UIImageOrientationUp];
+    #endif
+        CGImageRelease(imageRef);
+        return image;
+    } catch (std::bad_alloc &err) {
+        NSString *str = [[NSString alloc] initWithCString:err.what() encoding:NSUTF8StringEncoding];
+        *error = [[NSError alloc] initWithDomain:@"JpegXLProgressiveDecoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: str }];
+        return nil;
+    }
+}
+
+-(void)dealloc {
+    if (dec) {
+        delete dec;
+        dec = nullptr;
+    }
+}
+
+@end
@@ -0,0 +1,132 @@
+//
+//  JXLBitmapFormat.h
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JXLBitmapFormat_h
+#define JXLBitmapFormat_h
+
+#import <CoreGraphics/CoreGraphics.h>
+#import "JXLSystemImage.hpp"
+#import "JxlDefinitions.h"
+#import "RgbaScaler.h"
+#include <jxl/types.h>
+
+#ifdef __cplusplus
+
+static inline JxlDecodingPixelFormat JXLDecodingPixelFormat(JXLPreferredPixelFormat preferredPixelFormat) {
+    switch (preferredPixelFormat) {
+        case kOptimal:
+            return optimal;
+        case kR8:
+            return r8;
+        case kR16:
+            return r16;
+        case kFloat16:
+            return f16;
+        case kFloat32:
+            return f32;
+    }
+    return optimal;
+}
+
+static inline JxlTargetColorSpace JXLOutputColorSpace(JXLTargetColorSpace colorSpace) {
+    switch (colorSpace) {
+        case kTargetOriginal:
+            return colorSpaceOriginal;
+        case kTargetSRGB:
+            return colorSpaceSRGB;
+        case kTargetDisplayP3:
+            return colorSpaceDisplayP3;
+        case kTargetBT2020PQ:
+            return colorSpaceBT2020PQ;
+        case kTargetLinearSRGB:
+            return colorSpaceLinearSRGB;
+    }
+    return colorSpaceOriginal;
+}
+
+/**
+ * Sample type the decoder produced for the requested format, useFloats as returned by the decoder
+ */
+static inline JxlDataType JXLOutputDataType(JxlDecodingPixelFormat pixelFormat, bool useFloats) {
+    if (pixelFormat == f16) {
+        return JXL_TYPE_FLOAT16;
+    } else if (pixelFormat == f32) {
+        return JXL_TYPE_FLOAT;
+    }
+    return useFloats ? JXL_TYPE_UINT16 : JXL_TYPE_UINT8;
+}
+
+static inline size_t JXLBitsPerComponent(JxlDataType type) {
+    switch (type) {
+        case JXL_TYPE_UINT16:
+        case JXL_TYPE_FLOAT16:
+            return 16;
+        case JXL_TYPE_FLOAT:
+            return 32;
+        default:
+            return 8;
+    }
+}
+
+static inline CGBitmapInfo JXLBitmapInfo(JxlDataType type, int components, bool premultiplied = false) {
+    CGBitmapInfo flags;
+    switch (type) {
+        case JXL_TYPE_UINT16:
+            flags = kCGBitmapByteOrder16Host;
+            break;
+        case JXL_TYPE_FLOAT16:
+            flags = kCGBitmapByteOrder16Host | kCGBitmapFloatComponents;
+            break;
+        case JXL_TYPE_FLOAT:
+            flags = kCGBitmapByteOrder32Host | kCGBitmapFloatComponents;
+            break;
+        default:
+            flags = kCGImageByteOrderDefault;
+            break;
+    }
+    if (components == 4) {
+        flags |= premultiplied ? kCGImageAlphaPremultipliedLast : kCGImageAlphaLast;
+    } else {
+        flags |= kCGImageAlphaNone;
+    }
+    return flags;
+}
+
+static inline JxlIPixelFormat JXLScalerPixelFormat(JxlDataType type) {
+    switch (type) {
+        case JXL_TYPE_UINT16:
+            return kF16;
+        case JXL_TYPE_FLOAT16:
+            return kHalf;
+        case JXL_TYPE_FLOAT:
+            return kFloat;
+        default:
+            return kU8;
+    }
+}
+
+#endif
+
+#endif /* JXLBitmapFormat_h */
@@ -0,0 +1,44 @@
+//
+//  JXLCancellationToken.h
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JXLCancellationToken_h
+#define JXLCancellationToken_h
+
+#import <Foundation/Foundation.h>
+
+/// Stops codec calls made inside `performCancellable:` once cancelled or past the deadline,
+/// they return an error within a few milliseconds and release their threads and memory.
+@interface JXLCancellationToken : NSObject
+- (nonnull instancetype)init;
+/// The token cancels itself once timeout seconds have passed
+- (nonnull instancetype)initWithTimeout:(NSTimeInterval)timeout;
+/// Safe to call from any thread
+- (void)cancel;
+- (bool)isCancelled;
+/// Runs block on the calling thread, every decode or encode started from it observes this token
+- (void)performCancellable:(NS_NOESCAPE void (^_Nonnull)(void))block;
+@end
+
+#endif /* JXLCancellationToken_h */
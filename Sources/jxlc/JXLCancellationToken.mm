@@ -0,0 +1,66 @@
+//
+//  JXLCancellationToken.mm
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "JXLCancellationToken.h"
+#import "JxlCancellation.hpp"
+#include <chrono>
+#include <memory>
+
+@implementation JXLCancellationToken {
+    std::shared_ptr<jxlcoder::JxlCancellationToken> token;
+}
+
+- (nonnull instancetype)init {
+    self = [super init];
+    if (self) {
+        token = std::make_shared<jxlcoder::JxlCancellationToken>();
+    }
+    return self;
+}
+
+- (nonnull instancetype)initWithTimeout:(NSTimeInterval)timeout {
+    self = [super init];
+    if (self) {
+        auto deadline = jxlcoder::JxlCancellationToken::Clock::now()
+        + std::chrono::duration_cast<jxlcoder::JxlCancellationToken::Clock::duration>(std::chrono::duration<double>(timeout));
+        token = std::make_shared<jxlcoder::JxlCancellationToken>(deadline);
+    }
+    return self;
+}
+
+- (void)cancel {
+    token->cancel();
+}
+
+- (bool)isCancelled {
+    return token->isCancelled();
+}
+
+- (void)performCancellable:(NS_NOESCAPE void (^_Nonnull)(void))block {
+    jxlcoder::JxlCancellationScope scope(token);
+    block();
+}
+
+@end
@@ -40,7 +40,9 @@
 #endif
 
 #ifdef __cplusplus
+#include <memory>
 #include <vector>
+#include "JxlPixelSource.hpp"
 #endif
 
 // HDR transfer function types
@@ -89,6 +91,23 @@ typedef NS_ENUM(NSInteger, JXLPreferredPixelFormat) {
     kOptimal NS_SWIFT_NAME(optimal),
     kR8 NS_SWIFT_NAME(r8),
     kR16 NS_SWIFT_NAME(r16),
+    kFloat16 NS_SWIFT_NAME(float16),   // Half float RGBA or gray, original transfer function kept
+    kFloat32 NS_SWIFT_NAME(float32),   // Float RGBA or gray, original transfer function kept
+};
+
+// Color space decoded pixels are converted into while they are decoded
+typedef NS_ENUM(NSInteger, JXLTargetColorSpace) {
+    kTargetOriginal NS_SWIFT_NAME(original) = 0,
+    kTargetSRGB NS_SWIFT_NAME(srgb) = 1,
+    kTargetDisplayP3 NS_SWIFT_NAME(displayP3) = 2,
+    kTargetBT2020PQ NS_SWIFT_NAME(bt2020PQ) = 3,
+    kTargetLinearSRGB NS_SWIFT_NAME(linearSRGB) = 4,
+};
+
+// What rate controlled encoding searches the distance for
+typedef NS_ENUM(NSInteger, JXLRateTarget) {
+    kRateTargetFileSize NS_SWIFT_NAME(fileSize) = 0,
+    kRateTargetSSIM NS_SWIFT_NAME(ssim) = 1,    // Mean SSIM of the luma, 0...1
 };
 
 typedef NS_ENUM(NSInteger, JXLEncoderDecodingSpeed)  {
@@ -106,6 +125,10 @@ typedef NS_ENUM(NSInteger, JXLEncoderDecodingSpeed)  {
 - (bool)jxlExtractPixels:(std::vector<uint8_t>&)buffer
               iccProfile:(std::vector<uint8_t>&)iccProfile
                     info:(nonnull JXLImageInfo*)info;
+// Same layout as jxlExtractPixels, converted on demand a rectangle at a time while encoding
+- (bool)jxlPixelSource:(std::unique_ptr<jxlcoder::JxlPixelSource>&)source
+            iccProfile:(std::vector<uint8_t>&)iccProfile
+                  info:(nonnull JXLImageInfo*)info;
 #endif
 @end
 
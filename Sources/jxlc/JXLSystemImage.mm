@@ -659,16 +659,176 @@ static void unpackPacked10BitToRGB16(const uint32_t* src, uint16_t* dst, size_t
     }
 }
 
-- (bool)jxlExtractPixels:(std::vector<uint8_t>&)buffer
-              iccProfile:(std::vector<uint8_t>&)iccProfile
-                    info:(nonnull JXLImageInfo*)info {
+// Layout of the pixels jxlExtractPixels produces from a source image with this info:
+// RGB or RGBA with the source's component type, packed 10-bit widened to 16-bit RGB
+static JXLImageInfo outputImageInfo(const JXLImageInfo& source) {
+    JXLImageInfo info = source;
+    if (source.isPacked10Bit) {
+        // Output as 16-bit RGB container, but preserve original 10-bit precision info
+        info.originalBitsPerComponent = 10;  // Preserve original precision for encoder
+        info.bitsPerComponent = 16;          // Container size after unpacking
+        info.hasAlpha = false;               // Packed 10-bit has no real alpha
+        info.bitsPerPixel = 48;              // 3 * 16
+    } else {
+        // We always output RGBA (4 channels) or RGB (3 channels) depending on hasAlpha
+        info.bitsPerPixel = (source.hasAlpha ? 4 : 3) * source.bitsPerComponent;
+    }
+    return info;
+}
+
+// Converts count pixels of one source row into the output layout, scratch holds the RGBA
+// intermediate when a padding or missing alpha has to be stripped
+static void convertPixelSpan(const uint8_t* src, uint8_t* dst, size_t count,
+                             const JXLImageInfo& info, std::vector<uint8_t>& scratch) {
+    if (info.isPacked10Bit) {
+        // Packed 10-bit: 32 bits per pixel containing 3x10-bit RGB + 2-bit padding
+        unpackPacked10BitToRGB16((const uint32_t*)src, (uint16_t*)dst, count,
+                                 info.alphaFirst, info.byteOrderLittle);
+        return;
+    }
+
+    int srcChannels = info.bitsPerPixel / info.bitsPerComponent;
+    size_t bytesPerComponent = info.bitsPerComponent / 8;
+    size_t outBytes = count * (info.hasAlpha ? 4 : 3) * bytesPerComponent;
+    uint8_t* rgba = dst;
+    if (!info.hasAlpha) {
+        scratch.resize(count * 4 * bytesPerComponent);
+        rgba = scratch.data();
+    }
+
+    if ((srcChannels == 1 || srcChannels == 2) && info.bitsPerComponent == 8) {
+        // Grayscale or Grayscale+Alpha -> expand to RGBA first, then strip if needed
+        grayscaleToRGB8(src, rgba, count, srcChannels, info.hasAlpha);
+        if (!info.hasAlpha) {
+            stripAlpha8(rgba, dst, count);
+        }
+    } else if ((srcChannels == 1 || srcChannels == 2) && info.bitsPerComponent == 16) {
+        if (info.isFloat) {
+            grayscaleToRGB16_float((const uint16_t*)src, (uint16_t*)rgba, count, srcChannels, info.hasAlpha);
+        } else {
+            grayscaleToRGB16_int((const uint16_t*)src, (uint16_t*)rgba, count, srcChannels, info.hasAlpha);
+        }
+        if (!info.hasAlpha) {
+            stripAlpha16((const uint16_t*)rgba, (uint16_t*)dst, count);
+        }
+    } else if (srcChannels == 3) {
+        // RGB without alpha - copy directly
+        memcpy(dst, src, outBytes);
+    } else if (srcChannels == 4 && info.bitsPerComponent == 8) {
+        // RGBA, BGRA, ARGB, or ABGR -> normalize to RGBA in place
+        memcpy(rgba, src, count * 4);
+        convertToRGBA8(rgba, count, info.alphaFirst, info.byteOrderLittle, info.hasAlpha);
+
+        // Unpremultiply if needed (now that data is in RGBA order)
+        if (info.alphaPremultiplied && info.hasAlpha) {
+            unpremultiplyRGBA8(rgba, count);
+        }
+        if (!info.hasAlpha) {
+            // Strip the padding/dummy alpha channel
+            stripAlpha8(rgba, dst, count);
+        }
+    } else if (srcChannels == 4 && info.bitsPerComponent == 16) {
+        memcpy(rgba, src, count * 4 * 2);
+        if (info.isFloat) {
+            convertToRGBA16_float((uint16_t*)rgba, count, info.alphaFirst, info.hasAlpha);
+            if (info.alphaPremultiplied && info.hasAlpha) {
+                unpremultiplyRGBA_float16((uint16_t*)rgba, (int)count, 1);
+            }
+        } else {
+            convertToRGBA16_int((uint16_t*)rgba, count, info.alphaFirst, info.hasAlpha);
+            if (info.alphaPremultiplied && info.hasAlpha) {
+                unpremultiplyRGBA16_int((uint16_t*)rgba, count);
+            }
+        }
+        if (!info.hasAlpha) {
+            stripAlpha16((const uint16_t*)rgba, (uint16_t*)dst, count);
+        }
+    } else if (srcChannels == 4 && info.bitsPerComponent == 32) {
+        // Float32 data (32-bit floats are always float, not integer)
+        memcpy(rgba, src, count * 4 * 4);
+        convertToRGBA32_float((float*)rgba, count, info.alphaFirst, info.hasAlpha);
+        if (info.alphaPremultiplied && info.hasAlpha) {
+            unpremultiplyRGBA32_float((float*)rgba, count);
+        }
+        if (!info.hasAlpha) {
+            stripAlpha32((const float*)rgba, (float*)dst, count);
+        }
+    } else {
+        // Unsupported layouts come out black
+        memset(dst, 0, outBytes);
+    }
+}
+
+// For 16-bit integer data, detect actual bit depth (may be 10-bit, 12-bit, etc.)
+// This helps improve compression for HEIC/RAW images stored in 16-bit containers
+// Note: Even HDR content from cameras (iPhone HEIC, Sony ARW, Canon CR3) is 10-14 bit max.
+// True 16-bit sources are essentially non-existent in photography.
+static bool mayHaveLowerBitDepth(const JXLImageInfo& info) {
+    return info.bitsPerComponent == 16 && !info.isFloat && !info.isPacked10Bit;
+}
+
+static void detectOriginalBitDepth(const uint8_t* pixels, size_t pixelCount, JXLImageInfo* info) {
+    if (mayHaveLowerBitDepth(*info)) {
+        int actualBitDepth = detectActualBitDepth16(
+            (const uint16_t*)pixels,
+            pixelCount,
+            info->bitsPerPixel / info->bitsPerComponent
+        );
+        if (actualBitDepth < 16) {
+            info->originalBitsPerComponent = actualBitDepth;
+        }
+    }
+}
+
+// Converts rows of the image's backing data into the output layout only when the encoder asks for them
+class JXLImagePixelSource : public jxlcoder::JxlPixelSource {
+public:
+    // Takes over the reference to pixelData
+    JXLImagePixelSource(CFDataRef pixelData, size_t stride, const JXLImageInfo& sourceInfo) :
+    pixelData(pixelData), stride(stride), sourceInfo(sourceInfo), outputInfo(outputImageInfo(sourceInfo)) {}
+
+    JXLImagePixelSource(const JXLImagePixelSource&) = delete;
+    JXLImagePixelSource& operator=(const JXLImagePixelSource&) = delete;
+
+    ~JXLImagePixelSource() override {
+        CFRelease(pixelData);
+    }
+
+    bool read(size_t x, size_t y, size_t width, size_t height, uint8_t* destination, size_t rowStride) override {
+        if (x + width > (size_t)sourceInfo.width || y + height > (size_t)sourceInfo.height) {
+            return false;
+        }
+        const uint8_t* src = CFDataGetBytePtr(pixelData) + x * (sourceInfo.bitsPerPixel / 8);
+        std::vector<uint8_t> scratch;
+        for (size_t row = 0; row < height; ++row) {
+            convertPixelSpan(src + (y + row) * stride, destination + row * rowStride, width, sourceInfo, scratch);
+        }
+        return true;
+    }
+
+    const JXLImageInfo& info() const {
+        return outputInfo;
+    }
+
+private:
+    CFDataRef pixelData;
+    size_t stride;
+    JXLImageInfo sourceInfo;
+    JXLImageInfo outputInfo;
+};
+
+// Raw pixel data of the image - NO REDRAWING, preserves HDR values.
+// The returned data must be released, info describes it as stored in the image
+- (nullable CFDataRef)jxlCopyPixelData:(std::vector<uint8_t>&)iccProfile
+                                  info:(nonnull JXLImageInfo*)info
+                                stride:(nonnull size_t*)stride {
     CGImageRef imageRef;
 #if TARGET_OS_OSX
     imageRef = [self CGImageForProposedRect:nil context:nil hints:nil];
 #else
     imageRef = [self CGImage];
 #endif
-    if (!imageRef) return false;
+    if (!imageRef) return nullptr;
 
     [self jxlGetImageInfo:info];
 
@@ -684,166 +844,65 @@ static void unpackPacked10BitToRGB16(const uint32_t* src, uint16_t* dst, size_t
         }
     }
 
-    // Get raw pixel data directly - NO REDRAWING, preserves HDR values
     CGDataProviderRef provider = CGImageGetDataProvider(imageRef);
-    if (!provider) return false;
+    if (!provider) return nullptr;
+
+    *stride = CGImageGetBytesPerRow(imageRef);
+    return CGDataProviderCopyData(provider);
+}
 
-    CFDataRef pixelData = CGDataProviderCopyData(provider);
+- (bool)jxlExtractPixels:(std::vector<uint8_t>&)buffer
+              iccProfile:(std::vector<uint8_t>&)iccProfile
+                    info:(nonnull JXLImageInfo*)info {
+    size_t srcStride = 0;
+    CFDataRef pixelData = [self jxlCopyPixelData:iccProfile info:info stride:&srcStride];
     if (!pixelData) return false;
 
     const uint8_t* src = (const uint8_t*)CFDataGetBytePtr(pixelData);
-    size_t srcStride = CGImageGetBytesPerRow(imageRef);
-    int srcBytesPerPixel = info->bitsPerPixel / 8;
-    size_t srcRowBytes = info->width * srcBytesPerPixel;
-
-    size_t pixelCount = info->width * info->height;
-    int srcChannels = info->bitsPerPixel / info->bitsPerComponent;
-    int bytesPerComponent = info->bitsPerComponent / 8;
-
-    // We always output RGBA (4 channels) or RGB (3 channels) depending on hasAlpha
-    // For grayscale, we expand to RGB/RGBA
-    int outChannels = info->hasAlpha ? 4 : 3;
-    size_t outBytesPerPixel = outChannels * bytesPerComponent;
-    buffer.resize(pixelCount * outBytesPerPixel);
-
-    // First, copy source data handling stride
-    std::vector<uint8_t> srcBuffer;
-    if (srcStride == srcRowBytes) {
-        srcBuffer.assign(src, src + srcRowBytes * info->height);
-    } else {
-        srcBuffer.resize(srcRowBytes * info->height);
-        for (int y = 0; y < info->height; y++) {
-            memcpy(srcBuffer.data() + y * srcRowBytes,
-                   src + y * srcStride,
-                   srcRowBytes);
-        }
-    }
-
-    CFRelease(pixelData);
+    JXLImageInfo sourceInfo = *info;
+    // Update info to reflect output format
+    *info = outputImageInfo(sourceInfo);
 
-    // Handle packed 10-bit format specially
-    if (info->isPacked10Bit) {
-        // Packed 10-bit: 32 bits per pixel containing 3x10-bit RGB + 2-bit padding
-        // Output as 16-bit RGB container, but preserve original 10-bit precision info
-        info->originalBitsPerComponent = 10;  // Preserve original precision for encoder
-        info->bitsPerComponent = 16;          // Container size after unpacking
-        info->hasAlpha = false;               // Packed 10-bit has no real alpha
-        buffer.resize(pixelCount * 3 * 2);    // 3 channels * 16-bit
-
-        unpackPacked10BitToRGB16(
-            (const uint32_t*)srcBuffer.data(),
-            (uint16_t*)buffer.data(),
-            pixelCount,
-            info->alphaFirst,
-            info->byteOrderLittle
-        );
+    size_t pixelCount = (size_t)info->width * info->height;
+    size_t outRowBytes = (size_t)info->width * (info->bitsPerPixel / 8);
+    buffer.resize(outRowBytes * info->height);
 
-        info->bitsPerPixel = 48;  // 3 * 16
-        return true;
+    // Row by row, so the source stride is handled without copying the source first
+    std::vector<uint8_t> scratch;
+    for (int y = 0; y < info->height; y++) {
+        convertPixelSpan(src + y * srcStride, buffer.data() + y * outRowBytes, info->width, sourceInfo, scratch);
     }
 
-    // Process based on source channel count
-    if (srcChannels == 1 || srcChannels == 2) {
-        // Grayscale or Grayscale+Alpha -> expand to RGB/RGBA
-        if (info->bitsPerComponent == 8) {
-            // Expand to RGBA first, then strip if needed
-            std::vector<uint8_t> rgbaBuffer(pixelCount * 4);
-            grayscaleToRGB8(srcBuffer.data(), rgbaBuffer.data(), pixelCount, srcChannels, info->hasAlpha);
-            if (info->hasAlpha) {
-                buffer = std::move(rgbaBuffer);
-            } else {
-                stripAlpha8(rgbaBuffer.data(), buffer.data(), pixelCount);
-            }
-        } else if (info->bitsPerComponent == 16) {
-            std::vector<uint16_t> rgbaBuffer(pixelCount * 4);
-            if (info->isFloat) {
-                grayscaleToRGB16_float((uint16_t*)srcBuffer.data(), rgbaBuffer.data(), pixelCount, srcChannels, info->hasAlpha);
-            } else {
-                grayscaleToRGB16_int((uint16_t*)srcBuffer.data(), rgbaBuffer.data(), pixelCount, srcChannels, info->hasAlpha);
-            }
-            if (info->hasAlpha) {
-                memcpy(buffer.data(), rgbaBuffer.data(), pixelCount * 4 * 2);
-            } else {
-                stripAlpha16(rgbaBuffer.data(), (uint16_t*)buffer.data(), pixelCount);
-            }
-        }
-    } else if (srcChannels == 3) {
-        // RGB without alpha - copy directly
-        buffer = std::move(srcBuffer);
-        // Note: hasAlpha should be false here, outChannels = 3
-    } else if (srcChannels == 4) {
-        // RGBA, BGRA, ARGB, or ABGR -> normalize to RGBA
-        if (info->bitsPerComponent == 8) {
-            // Convert in place to RGBA order
-            convertToRGBA8(srcBuffer.data(), pixelCount, info->alphaFirst, info->byteOrderLittle, info->hasAlpha);
-
-            // Unpremultiply if needed (now that data is in RGBA order)
-            if (info->alphaPremultiplied && info->hasAlpha) {
-                unpremultiplyRGBA8(srcBuffer.data(), pixelCount);
-            }
-
-            if (info->hasAlpha) {
-                buffer = std::move(srcBuffer);
-            } else {
-                // Strip the padding/dummy alpha channel
-                stripAlpha8(srcBuffer.data(), buffer.data(), pixelCount);
-            }
-        } else if (info->bitsPerComponent == 16) {
-            if (info->isFloat) {
-                // Float16 data
-                convertToRGBA16_float((uint16_t*)srcBuffer.data(), pixelCount, info->alphaFirst, info->hasAlpha);
-
-                if (info->alphaPremultiplied && info->hasAlpha) {
-                    unpremultiplyRGBA_float16((uint16_t*)srcBuffer.data(), info->width, info->height);
-                }
-            } else {
-                // Integer 16-bit data
-                convertToRGBA16_int((uint16_t*)srcBuffer.data(), pixelCount, info->alphaFirst, info->hasAlpha);
-
-                if (info->alphaPremultiplied && info->hasAlpha) {
-                    unpremultiplyRGBA16_int((uint16_t*)srcBuffer.data(), pixelCount);
-                }
-            }
-
-            if (info->hasAlpha) {
-                buffer = std::move(srcBuffer);
-            } else {
-                stripAlpha16((uint16_t*)srcBuffer.data(), (uint16_t*)buffer.data(), pixelCount);
-            }
-        } else if (info->bitsPerComponent == 32) {
-            // Float32 data (32-bit floats are always float, not integer)
-            convertToRGBA32_float((float*)srcBuffer.data(), pixelCount, info->alphaFirst, info->hasAlpha);
+    CFRelease(pixelData);
 
-            if (info->alphaPremultiplied && info->hasAlpha) {
-                unpremultiplyRGBA32_float((float*)srcBuffer.data(), pixelCount);
-            }
+    detectOriginalBitDepth(buffer.data(), pixelCount, info);
 
-            if (info->hasAlpha) {
-                buffer = std::move(srcBuffer);
-            } else {
-                stripAlpha32((float*)srcBuffer.data(), (float*)buffer.data(), pixelCount);
-            }
-        }
-    }
+    return true;
+}
 
-    // Update info to reflect output format
-    info->bitsPerPixel = outChannels * info->bitsPerComponent;
+- (bool)jxlPixelSource:(std::unique_ptr<jxlcoder::JxlPixelSource>&)source
+            iccProfile:(std::vector<uint8_t>&)iccProfile
+                  info:(nonnull JXLImageInfo*)info {
+    size_t srcStride = 0;
+    CFDataRef pixelData = [self jxlCopyPixelData:iccProfile info:info stride:&srcStride];
+    if (!pixelData) return false;
 
-    // For 16-bit integer data, detect actual bit depth (may be 10-bit, 12-bit, etc.)
-    // This helps improve compression for HEIC/RAW images stored in 16-bit containers
-    // Note: Even HDR content from cameras (iPhone HEIC, Sony ARW, Canon CR3) is 10-14 bit max.
-    // True 16-bit sources are essentially non-existent in photography.
-    if (info->bitsPerComponent == 16 && !info->isFloat && !info->isPacked10Bit) {
-        int actualBitDepth = detectActualBitDepth16(
-            (const uint16_t*)buffer.data(),
-            pixelCount,
-            outChannels
-        );
-        if (actualBitDepth < 16) {
-            info->originalBitsPerComponent = actualBitDepth;
+    auto imageSource = std::make_unique<JXLImagePixelSource>(pixelData, srcStride, *info);
+    *info = imageSource->info();
+
+    // Precision goes into the header before any rectangle is encoded, so it is detected
+    // up front on a few evenly spaced rows instead of the whole image
+    if (mayHaveLowerBitDepth(*info) && info->width > 0 && info->height > 0) {
+        size_t sampleRows = std::min(info->height, 16);
+        size_t rowBytes = (size_t)info->width * (info->bitsPerPixel / 8);
+        std::vector<uint8_t> sample(sampleRows * rowBytes);
+        for (size_t i = 0; i < sampleRows; i++) {
+            imageSource->read(0, i * info->height / sampleRows, info->width, 1, sample.data() + i * rowBytes, rowBytes);
         }
+        detectOriginalBitDepth(sample.data(), sampleRows * info->width, info);
     }
 
+    source = std::move(imageSource);
     return true;
 }
 
@@ -27,6 +27,9 @@
 
 JxlFrame JxlAnimatedDecoder::getFrame(int framePosition) {
     std::lock_guard guard(lock);
+    jxlcoder::JxlMemoryOperation operation(arena);
+    // The decoder outlives single calls, so cancellation is taken from whoever asks for this frame
+    runner.cancellation = jxlcoder::JxlCancellationScope::current();
     if (framePosition < 0) {
         std::string str = "Frame position must be positive";
         throw AnimatedDecoderError(str);
@@ -37,6 +40,7 @@ JxlFrame JxlAnimatedDecoder::getFrame(int framePosition) {
         throw AnimatedDecoderError(str);
     }
 
+    nextLayer = -1;
     JxlDecoderRewind(dec.get());
     if (JXL_DEC_SUCCESS != JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_FULL_IMAGE | JXL_DEC_FRAME)) {
         std::string str = "Cannot subscribe to events";
@@ -57,7 +61,14 @@ JxlFrame JxlAnimatedDecoder::getFrame(int framePosition) {
     int frameTime = 0;
     std::vector<uint8_t> pixels;
     JxlPixelFormat format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+    jxlcoder::JxlPipelineOutput output(premultiply);
     for (;;) {
+        if (runner.cancelled()) {
+            // Leaves the decoder ready for the next request
+            JxlDecoderRewind(dec.get());
+            std::string str = "Decoding was cancelled";
+            throw AnimatedDecoderError(str);
+        }
         JxlDecoderStatus status = JxlDecoderProcessInput(dec.get());
         if (status == JXL_DEC_FRAME) {
             JxlFrameHeader header;
@@ -85,6 +96,16 @@ JxlFrame JxlAnimatedDecoder::getFrame(int framePosition) {
             pixels.resize(info.xsize * info.ysize * (components) * sizeof(uint8_t));
             void *pixelsBuffer = (void *) pixels.data();
 
+            if (!premultiply.empty()) {
+                // Rows arrive oriented, so they are as wide as the displayed frame
+                if (JXL_DEC_SUCCESS != output.attach(dec.get(), format, pixels.data(),
+                                                     getWidth() * components * sizeof(uint8_t))) {
+                    std::string str = "Cannot decoder buffer info";
+                    throw AnimatedDecoderError(str);
+                }
+                continue;
+            }
+
             if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutBuffer(dec.get(),
                                                                &format,
                                                                pixelsBuffer,
@@ -111,8 +132,119 @@ JxlFrame JxlAnimatedDecoder::getFrame(int framePosition) {
     }
 }
 
+JxlLayer JxlAnimatedDecoder::getLayer(int layerPosition) {
+    std::lock_guard guard(lock);
+    jxlcoder::JxlMemoryOperation operation(arena);
+    runner.cancellation = jxlcoder::JxlCancellationScope::current();
+    if (layerPosition < 0 || layerPosition >= this->layerHeaders.size()) {
+        std::string str = "Requested layer index is out of range";
+        throw AnimatedDecoderError(str);
+    }
+
+    // Layers are composed in order, so the decoder usually stands right before the requested one.
+    // Starting over would decode again every skipped layer that later ones refer to.
+    const bool continuing = nextLayer == layerPosition;
+    nextLayer = -1;
+    if (!continuing) {
+        JxlDecoderRewind(dec.get());
+        if (JXL_DEC_SUCCESS != JxlDecoderSetCoalescing(dec.get(), JXL_FALSE)) {
+            std::string str = "Cannot disable coalescing";
+            throw AnimatedDecoderError(str);
+        }
+        if (JXL_DEC_SUCCESS != JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_FULL_IMAGE | JXL_DEC_FRAME)) {
+            std::string str = "Cannot subscribe to events";
+            throw AnimatedDecoderError(str);
+        }
+        if (JXL_DEC_SUCCESS != JxlDecoderSetInput(dec.get(), data.data(), data.size())) {
+            std::string str = "Set input has failed";
+            throw AnimatedDecoderError(str);
+        }
+        JxlDecoderCloseInput(dec.get());
+        JxlDecoderSkipFrames(dec.get(), layerPosition);
+    }
+
+    const JxlFrameHeader& header = layerHeaders[layerPosition];
+    const JxlLayerInfo& layerInfo = header.layer_info;
+    const bool last = layerPosition + 1 == static_cast<int>(layerHeaders.size());
+    // A layer with a duration and reference 0 is not kept, the last one never is
+    const bool saved = !last && (header.duration == 0 || layerInfo.save_as_reference != 0);
+    // Layer pixels are oriented like frames are
+    const bool transposed = info.orientation >= JXL_ORIENT_TRANSPOSE;
+    JxlLayer layer = {
+        .x = layerInfo.crop_x0,
+        .y = layerInfo.crop_y0,
+        .width = transposed ? layerInfo.ysize : layerInfo.xsize,
+        .height = transposed ? layerInfo.xsize : layerInfo.ysize,
+        .blendMode = layerInfo.blend_info.blendmode,
+        .blendSource = layerInfo.blend_info.source,
+        .saveAsReference = saved ? static_cast<int>(layerInfo.save_as_reference) : -1,
+        .duration = frameInfo[layerPosition].duration,
+    };
+
+    JxlPixelFormat format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+    jxlcoder::JxlPipelineOutput output(premultiply);
+    for (;;) {
+        if (runner.cancelled()) {
+            JxlDecoderRewind(dec.get());
+            std::string str = "Decoding was cancelled";
+            throw AnimatedDecoderError(str);
+        }
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec.get());
+        if (status == JXL_DEC_FRAME) {
+            continue;
+        } else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
+            size_t bufferSize;
+            if (JXL_DEC_SUCCESS != JxlDecoderImageOutBufferSize(dec.get(), &format, &bufferSize)) {
+                std::string str = "Cannot retreive buffer info size";
+                throw AnimatedDecoderError(str);
+            }
+            const size_t stride = static_cast<size_t>(layer.width) * 4;
+            if (bufferSize != stride * layer.height) {
+                std::string str = "Cannot retreive buffer info size";
+                throw AnimatedDecoderError(str);
+            }
+            layer.pixels.resize(bufferSize);
+            if (!premultiply.empty()) {
+                if (JXL_DEC_SUCCESS != output.attach(dec.get(), format, layer.pixels.data(), stride)) {
+                    std::string str = "Cannot decoder buffer info";
+                    throw AnimatedDecoderError(str);
+                }
+                continue;
+            }
+            if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutBuffer(dec.get(), &format,
+                                                               layer.pixels.data(), layer.pixels.size())) {
+                std::string str = "Cannot decoder buffer info";
+                throw AnimatedDecoderError(str);
+            }
+        } else if (status == JXL_DEC_FULL_IMAGE || status == JXL_DEC_SUCCESS) {
+            if (status == JXL_DEC_FULL_IMAGE && !last) {
+                // Stays right after this layer for the next one
+                nextLayer = layerPosition + 1;
+                return layer;
+            }
+            JxlDecoderRewind(dec.get());
+            JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_FRAME | JXL_DEC_FULL_IMAGE);
+            JxlDecoderSetInput(dec.get(), data.data(), data.size());
+            JxlDecoderCloseInput(dec.get());
+            return layer;
+        } else {
+            std::string str = "Error event has received";
+            throw AnimatedDecoderError(str);
+        }
+    }
+}
+
 JxlFrame JxlAnimatedDecoder::nextFrame() {
     std::lock_guard guard(lock);
+    jxlcoder::JxlMemoryOperation operation(arena);
+    if (nextLayer >= 0) {
+        // Layer decoding stopped in the middle of the file, frames start from the beginning as before
+        nextLayer = -1;
+        JxlDecoderRewind(dec.get());
+        JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_FRAME | JXL_DEC_FULL_IMAGE);
+        JxlDecoderSetInput(dec.get(), data.data(), data.size());
+        JxlDecoderCloseInput(dec.get());
+    }
     int frameTime = 0;
     for (;;) {
         JxlDecoderStatus status = JxlDecoderProcessInput(dec.get());
@@ -33,9 +33,10 @@
 #include <vector>
 #include <jxl/decode.h>
 #include <jxl/decode_cxx.h>
-#include <jxl/resizable_parallel_runner.h>
-#include <jxl/resizable_parallel_runner_cxx.h>
 #include <thread>
+#include "JxlSharedRunner.hpp"
+#include "JxlRowPipeline.hpp"
+#include "JxlMemoryArena.hpp"
 
 class AnimatedDecoderError : public std::exception {
 public:
@@ -59,9 +60,33 @@ struct JxlFrameInfo {
     int duration;
 };
 
+/**
+ * One layer exactly as stored, before libjxl would blend it onto the canvas.
+ * pixels are width x height RGBA8, placed at x, y on the canvas, which may be partially outside of it.
+ */
+struct JxlLayer {
+    std::vector<uint8_t> pixels;
+    int32_t x;
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+    JxlBlendMode blendMode;
+    // Reference slot (0-3) the layer is blended onto
+    uint32_t blendSource;
+    // Reference slot the blended result is kept in for later layers, -1 when nothing refers to it
+    int saveAsReference;
+    // Zero for layers that only build up the next displayed frame
+    int duration;
+};
+
 class JxlAnimatedDecoder {
 public:
-    JxlAnimatedDecoder(std::vector<uint8_t>& src) {
+    /**
+     * @param premultiplyAlpha frames come out with color multiplied by alpha, straight alpha is premultiplied
+     * while rows are decoded instead of in a separate pass
+     */
+    JxlAnimatedDecoder(std::vector<uint8_t>& src, bool premultiplyAlpha = false,
+                       JxlRunnerPriority priority = runnerNormal) : runner(priority), premultiplyAlpha(premultiplyAlpha) {
         this->data = src;
 
         if (JXL_SIG_INVALID == JxlSignatureCheck(src.data(), src.size())) {
@@ -69,15 +94,14 @@ public:
             throw AnimatedDecoderError(str);
         }
 
-        runner = JxlResizableParallelRunnerMake(nullptr);
-
-        dec = JxlDecoderMake(nullptr);
+        jxlcoder::JxlMemoryOperation operation(arena);
+        dec = JxlDecoderMake(arena.manager());
         if (!dec) {
             std::string str = "Cannot create decoder";
             throw AnimatedDecoderError(str);
         }
         
-        if (JXL_DEC_SUCCESS != JxlDecoderSetUnpremultiplyAlpha(dec.get(), JXL_TRUE)) {
+        if (JXL_DEC_SUCCESS != JxlDecoderSetUnpremultiplyAlpha(dec.get(), premultiplyAlpha ? JXL_FALSE : JXL_TRUE)) {
             std::string str = "Cannot initialize decoder";
             throw AnimatedDecoderError(str);
         }
@@ -92,8 +116,8 @@ public:
         }
 
         if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec.get(),
-                                                           JxlResizableParallelRunner,
-                                                           runner.get())) {
+                                                           jxlcoder::JxlSharedParallelRunner,
+                                                           &runner)) {
             std::string str = "Cannot attach parallel runner to decoder";
             throw AnimatedDecoderError(str);
         }
@@ -119,10 +143,9 @@ public:
                 loopCount = info.have_animation ? info.animation.num_loops : -1;
                 denom = info.have_animation ? info.animation.tps_denominator : 1;
                 numer = info.have_animation ? info.animation.tps_numerator : 1;
-
-                JxlResizableParallelRunnerSetThreads(
-                        runner.get(),
-                        JxlResizableParallelRunnerSuggestThreads(info.xsize, info.ysize));
+                if (premultiplyAlpha && info.alpha_bits > 0 && !info.alpha_premultiplied) {
+                    premultiply.add(std::make_shared<jxlcoder::JxlPremultiplyStage>());
+                }
             } else if (status == JXL_DEC_FULL_IMAGE) {
                 // All decoding successfully finished, we are at the end of the file.
                 // We must rewind the decoder to get a new frame.
@@ -145,6 +168,8 @@ public:
                     frameTime = 0;
                 JxlFrameInfo info = { .duration = frameTime };
                 this->frameInfo.push_back(info);
+                // Coalescing is off here, so every layer is reported with its own header
+                this->layerHeaders.push_back(header);
             } else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
                 if (JXL_DEC_SUCCESS != JxlDecoderSkipCurrentFrame(dec.get())) {
                     std::string str = "Cannot properly resolve animation info";
@@ -176,17 +201,36 @@ public:
 
     JxlFrame nextFrame();
     JxlFrame getFrame(int at);
+    /**
+     * Decodes a single layer without coalescing, only its own rectangle is decoded and nothing is blended.
+     * Feed the layers in order into a jxlcoder::JxlLayerCompositor to build the displayed frames.
+     * Asking for the layer after the previous one continues decoding, any other index starts over.
+     */
+    JxlLayer getLayer(int at);
+
+    int getNumberOfLayers() {
+        return static_cast<int>(layerHeaders.size());
+    }
 
     int getLoopCount() {
         return loopCount;
     }
 
+    // Displayed size, frames come out already oriented
     int getWidth() {
-        return info.xsize;
+        return info.orientation >= JXL_ORIENT_TRANSPOSE ? info.ysize : info.xsize;
     }
 
     int getHeight() {
-        return info.ysize;
+        return info.orientation >= JXL_ORIENT_TRANSPOSE ? info.xsize : info.ysize;
+    }
+
+    bool isPremultiplied() {
+        return premultiplyAlpha;
+    }
+
+    const std::vector<uint8_t>& getIccProfile() {
+        return iccProfile;
     }
 
     int getNumberOfFrames() {
@@ -207,15 +251,22 @@ public:
     }
 
 private:
+    jxlcoder::JxlSharedRunner runner;
     std::vector<uint8_t> data;
     std::vector<uint8_t> iccProfile;
     std::vector<JxlFrameInfo> frameInfo;
+    std::vector<JxlFrameHeader> layerHeaders;
+    // Declared before the decoder, which allocates from it
+    jxlcoder::JxlMemoryArena arena;
     JxlDecoderPtr dec;
     JxlBasicInfo info;
     int loopCount;
     int denom;
     int numer;
-    JxlResizableParallelRunnerPtr runner;
+    bool premultiplyAlpha;
+    jxlcoder::JxlRowPipeline premultiply;
+    // Layer the decoder stands right before after the previous getLayer, -1 when it has to rewind
+    int nextLayer = -1;
     std::mutex lock;
 };
 
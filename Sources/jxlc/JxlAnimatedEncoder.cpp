@@ -27,8 +27,11 @@
 
 void JxlAnimatedEncoder::addFrame(std::vector<uint8_t>& data, int frameTime) {
     std::lock_guard guard(lock);
+    jxlcoder::JxlMemoryOperation operation(arena);
 
     addedFrames += 1;
+    // With an output attached the frame is encoded right away
+    runner.cancellation = jxlcoder::JxlCancellationScope::current();
 
     JxlEncoderInitFrameHeader(&header);
     header.timecode = 0;
@@ -54,29 +57,31 @@ void JxlAnimatedEncoder::addFrame(std::vector<uint8_t>& data, int frameTime) {
 }
 
 void JxlAnimatedEncoder::encode(std::vector<uint8_t>& dst) {
+    finish();
+    std::lock_guard guard(lock);
+    if (externalOutput) {
+        dst.clear();
+    } else {
+        dst = std::move(buffered);
+    }
+}
+
+void JxlAnimatedEncoder::finish() {
     std::lock_guard guard(lock);
     if (addedFrames == 0) {
         std::string str = "Cannot compress empty animation";
         throw AnimatedEncoderError(str);
     }
+    jxlcoder::JxlMemoryOperation operation(arena);
     JxlEncoderCloseFrames(enc.get());
+    runner.cancellation = jxlcoder::JxlCancellationScope::current();
 
-    dst.resize(64);
-    uint8_t *nextOut = dst.data();
-    size_t availOut = dst.size() - (nextOut - dst.data());
-    JxlEncoderStatus processResult = JXL_ENC_NEED_MORE_OUTPUT;
-    while (processResult == JXL_ENC_NEED_MORE_OUTPUT) {
-        processResult = JxlEncoderProcessOutput(enc.get(), &nextOut, &availOut);
-        if (processResult == JXL_ENC_NEED_MORE_OUTPUT) {
-            size_t offset = nextOut - dst.data();
-            dst.resize(dst.size() * 2);
-            nextOut = dst.data() + offset;
-            availOut = dst.size() - offset;
-        }
+    if (!writer.finish(enc.get())) {
+        std::string str = writer.failed() ? "Writing encoded image has failed" : "Encoding image has failed";
+        throw AnimatedEncoderError(str);
     }
-    dst.resize(nextOut - dst.data());
-    if (JXL_ENC_SUCCESS != processResult) {
-        std::string str = "Encoding image has failed";
+    if (runner.cancelled()) {
+        std::string str = "Encoding was cancelled";
         throw AnimatedEncoderError(str);
     }
 }
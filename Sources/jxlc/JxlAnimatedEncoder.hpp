@@ -31,9 +31,11 @@
 #include <stdio.h>
 #include <jxl/encode.h>
 #include <jxl/encode_cxx.h>
-#include <jxl/thread_parallel_runner_cxx.h>
 #include <string>
 #include "JxlDefinitions.h"
+#include "JxlSharedRunner.hpp"
+#include "JxlOutputSink.hpp"
+#include "JxlMemoryArena.hpp"
 #include <vector>
 #include <thread>
 
@@ -54,19 +56,27 @@ public:
     JxlAnimatedEncoder(int width, int height, JxlPixelType pixelType, 
                        JxlEncodingPixelFormat encodingPixelFormat, 
                        JxlCompressionOption compressionOption, 
-                       int numLoops, int quality, int effort, int decodingSpeed): width(width), height(height),
+                       int numLoops, int quality, int effort, int decodingSpeed,
+                       JxlRunnerPriority priority = runnerNormal,
+                       jxlcoder::JxlOutputSink* output = nullptr): width(width), height(height),
     pixelType(pixelType), encodingPixelFormat(encodingPixelFormat),
-    compressionOption(compressionOption), quality(quality), effort(effort) {
-        if (!enc || !runner) {
+    compressionOption(compressionOption), quality(quality), effort(effort), runner(priority),
+    externalOutput(output != nullptr), writer(output ? *output : bufferedSink) {
+        if (!enc) {
             std::string str = "Cannot initialize encoder";
             throw AnimatedEncoderError(str);
         }
         if (JXL_ENC_SUCCESS != JxlEncoderSetParallelRunner(enc.get(),
-                                                           JxlThreadParallelRunner,
-                                                           runner.get())) {
+                                                           jxlcoder::JxlSharedParallelRunner,
+                                                           &runner)) {
             std::string str = "Cannot initialize parallel runner";
             throw AnimatedEncoderError(str);
         }
+        // Frames are written out as they are encoded instead of being collected until the end
+        if (!writer.attach(enc.get())) {
+            std::string str = "Cannot attach output to encoder";
+            throw AnimatedEncoderError(str);
+        }
 
         pixelFormat = {3, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
         switch (pixelType) {
@@ -190,7 +200,15 @@ public:
     }
 
     void addFrame(std::vector<uint8_t>& data, int frameTime);
+    /**
+     * Writes out the rest of the animation, either to the sink given to the constructor
+     * or into dst, which then takes the buffered output without a copy
+     */
     void encode(std::vector<uint8_t>& dst);
+    /**
+     * Same as encode, for encoders writing to their own sink
+     */
+    void finish();
 
     int getWidth() {
         return width;
@@ -220,9 +238,15 @@ private:
     JxlPixelFormat pixelFormat;
     int addedFrames = 0;
 
-    JxlEncoderPtr enc = JxlEncoderMake(nullptr);
-    JxlThreadParallelRunnerPtr runner = JxlThreadParallelRunnerMake(nullptr,
-                                                                    JxlThreadParallelRunnerDefaultNumWorkerThreads());
+    jxlcoder::JxlSharedRunner runner;
+    const bool externalOutput;
+    std::vector<uint8_t> buffered;
+    jxlcoder::JxlVectorOutputSink bufferedSink{buffered};
+    // Declared before the encoder, which writes into it until destroyed
+    jxlcoder::JxlOutputWriter writer;
+    // Declared before the encoder, which allocates from it
+    jxlcoder::JxlMemoryArena arena;
+    JxlEncoderPtr enc = JxlEncoderMake(arena.manager());
 
     JxlBasicInfo basicInfo;
     JxlFrameHeader header;
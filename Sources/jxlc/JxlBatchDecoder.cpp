@@ -0,0 +1,111 @@
+//
+//  JxlBatchDecoder.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlBatchDecoder.hpp"
+#include "JxlWorker.hpp"
+#include "JxlSharedRunner.hpp"
+#include "JxlCancellation.hpp"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <numeric>
+
+namespace jxlcoder {
+
+void DecodeJpegXlBatch(const std::vector<JxlBatchInput>& inputs,
+                       const JxlBatchOptions& options,
+                       const JxlBatchCompletion& completion) {
+    if (inputs.empty()) {
+        return;
+    }
+
+    // Headers only, this is negligible next to decoding
+    std::vector<uint64_t> pixelCounts(inputs.size(), 0);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        JxlImageDescriptor descriptor;
+        size_t neededBytes = 0;
+        if (ProbeJpegXl(inputs[i].data, inputs[i].size, &descriptor, &neededBytes)) {
+            pixelCounts[i] = static_cast<uint64_t>(descriptor.width) * descriptor.height;
+        }
+    }
+
+    // Largest first keeps a big image from being the only work left at the end
+    std::vector<size_t> order(inputs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return pixelCounts[lhs] > pixelCounts[rhs];
+    });
+
+    JxlSharedExecutor& executor = JxlSharedExecutor::shared();
+    const size_t threads = executor.getMaxThreads();
+    std::atomic<size_t> started(0);
+    // Tasks run on executor threads, the caller's cancellation is carried over to them explicitly
+    auto cancellation = JxlCancellationScope::current();
+
+    executor.parallelFor(static_cast<uint32_t>(inputs.size()), options.priority,
+                         [&](uint32_t position, size_t) {
+        const size_t index = order[position];
+        const uint64_t pixels = pixelCounts[index];
+        // Images not yet picked up by any thread
+        const size_t waiting = inputs.size() - started.fetch_add(1, std::memory_order_relaxed) - 1;
+
+        JxlBatchResult result;
+        result.index = index;
+        result.parallelized = pixels >= options.largeImagePixels
+        || (pixels >= options.minimumParallelPixels && waiting < threads);
+
+        auto provider = [&result](size_t, size_t height, size_t rowBytes,
+                                  size_t*, size_t* bufferSize) -> uint8_t* {
+            *bufferSize = rowBytes * height;
+            result.pixels.resize(*bufferSize);
+            return result.pixels.data();
+        };
+        JxlCancellationScope scope(cancellation);
+        if (cancellation && cancellation->isCancelled()) {
+            completion(result);
+            return;
+        }
+        JxlMemoryByteSource source(inputs[index].data, inputs[index].size);
+        JxlDecodeOptions decodeOptions;
+        decodeOptions.premultiplyAlpha = options.premultiplyAlpha;
+        decodeOptions.simdOrientation = options.simdOrientation;
+        decodeOptions.colorSpace = options.colorSpace;
+        try {
+            result.success = DecodeJpegXlIntoBuffer(source, provider, &result.xsize, &result.ysize,
+                                                    &result.color, &result.depth, &result.components,
+                                                    &result.useFloats, options.pixelFormat, decodeOptions,
+                                                    JxlSharedRunner(options.priority, !result.parallelized));
+        } catch (std::bad_alloc&) {
+            result.success = false;
+        }
+        if (!result.success) {
+            result.pixels.clear();
+            result.pixels.shrink_to_fit();
+        }
+        completion(result);
+    });
+}
+
+}
@@ -0,0 +1,96 @@
+//
+//  JxlBatchDecoder.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlBatchDecoder_hpp
+#define JxlBatchDecoder_hpp
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "JxlDefinitions.h"
+#include "JxlWorker.hpp"
+
+namespace jxlcoder {
+
+struct JxlBatchInput {
+    const uint8_t* data;
+    size_t size;
+};
+
+struct JxlBatchResult {
+    // Position of the image in the inputs
+    size_t index = 0;
+    bool success = false;
+    std::vector<uint8_t> pixels;
+    // Displayed size, orientation already applied
+    size_t xsize = 0;
+    size_t ysize = 0;
+    JxlColorDescription color;
+    int depth = 0;
+    int components = 0;
+    bool useFloats = false;
+    // Whether the image was decoded with threads of its own or on a single thread
+    bool parallelized = false;
+};
+
+struct JxlBatchOptions {
+    JxlDecodingPixelFormat pixelFormat = optimal;
+    bool premultiplyAlpha = false;
+    // Orients the finished image with the SIMD kernels instead of inside libjxl
+    bool simdOrientation = false;
+    // Pixels are converted into this space while they are decoded
+    JxlTargetColorSpace colorSpace = colorSpaceOriginal;
+    JxlRunnerPriority priority = runnerNormal;
+    // Images at least this large are always split across threads
+    uint64_t largeImagePixels = 4 * 1024 * 1024;
+    // Images at least this large are split across threads once fewer images than threads are left
+    uint64_t minimumParallelPixels = 256 * 1024;
+};
+
+/**
+ * Called once per image as soon as it is decoded, from executor threads and possibly concurrently.
+ * The result may be moved from.
+ */
+typedef std::function<void(JxlBatchResult& result)> JxlBatchCompletion;
+
+/**
+ * Decodes every input on the shared executor and blocks until all of them are done.
+ * Images are started largest first. Each one either runs on a single thread, next to other images,
+ * or with libjxl's parallel sections spread over the executor, depending on its pixel count
+ * and how many images are still waiting, so small images do not pay for synchronization
+ * and large ones do not end up alone on one thread at the end of the batch.
+ * The caller's JxlCancellationScope applies to every image, those not started yet are reported as failed.
+ */
+void DecodeJpegXlBatch(const std::vector<JxlBatchInput>& inputs,
+                       const JxlBatchOptions& options,
+                       const JxlBatchCompletion& completion);
+
+}
+
+#endif
+
+#endif /* JxlBatchDecoder_hpp */
@@ -0,0 +1,177 @@
+//
+//  JxlBatchEncoder.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlBatchEncoder.hpp"
+#include "JxlSharedRunner.hpp"
+#include "JxlMemoryArena.hpp"
+#include "JxlOutputSink.hpp"
+#include "JxlCancellation.hpp"
+#include <jxl/encode_cxx.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+
+namespace jxlcoder {
+
+/**
+ * Bytes held by the images in flight. Acquiring waits until the request fits,
+ * except when nothing is in flight, so an image larger than the limit still goes through alone.
+ */
+class JxlBatchMemoryBudget {
+public:
+    explicit JxlBatchMemoryBudget(uint64_t limit) : limit(limit) {}
+
+    void acquire(uint64_t bytes) {
+        std::unique_lock<std::mutex> guard(lock);
+        released.wait(guard, [&] { return used == 0 || used + bytes <= limit; });
+        used += bytes;
+    }
+
+    // Accounts for memory that turned out to differ from what was acquired, never waits
+    void adjust(uint64_t acquired, uint64_t actual) {
+        std::lock_guard<std::mutex> guard(lock);
+        used = used - acquired + actual;
+        if (actual < acquired) {
+            released.notify_all();
+        }
+    }
+
+    void release(uint64_t bytes) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            used -= bytes;
+        }
+        released.notify_all();
+    }
+
+private:
+    std::mutex lock;
+    std::condition_variable released;
+    uint64_t limit;
+    uint64_t used = 0;
+};
+
+/**
+ * Encoder kept by one worker for all of its images, reset between them
+ * so the memory libjxl freed is reused from the arena.
+ */
+struct JxlBatchEncoderWorker {
+    explicit JxlBatchEncoderWorker(JxlRunnerPriority priority) : runner(priority), enc(JxlEncoderMake(arena.manager())) {
+        runner.maxThreads = kHDREncoderMaxThreads;
+    }
+
+    bool encode(JxlBatchEncodeImage& image, bool serial, std::vector<uint8_t>* compressed) {
+        if (!enc) {
+            return false;
+        }
+        JxlEncoderReset(enc.get());
+        runner.serial = serial;
+        runner.cancellation = JxlCancellationScope::current();
+        JxlMemoryScope::begin(arena);
+
+        JxlVectorOutputSink output(*compressed);
+        bool encoded = JXL_ENC_SUCCESS == JxlEncoderSetParallelRunner(enc.get(), JxlSharedParallelRunner, &runner) &&
+        EncodeJxlHDRFrame(enc.get(), output, image.profile, image.xsize, image.ysize, &image.pixels, nullptr,
+                          image.exif.empty() ? nullptr : &image.exif,
+                          image.xmp.empty() ? nullptr : &image.xmp) &&
+        !runner.cancelled();
+
+        JxlMemoryScope::collect(arena);
+        return encoded;
+    }
+
+    JxlMemoryArena arena;
+    JxlSharedRunner runner;
+    JxlEncoderPtr enc;
+};
+
+void EncodeJxlHDRBatch(size_t count,
+                       const JxlBatchEncodeOptions& options,
+                       const JxlBatchEncodeEstimate& estimate,
+                       const JxlBatchEncodePrepare& prepare,
+                       const JxlBatchEncodeCompletion& completion) {
+    if (count == 0) {
+        return;
+    }
+
+    JxlSharedExecutor& executor = JxlSharedExecutor::shared();
+    size_t workers = executor.getMaxThreads();
+    if (options.maxThreads > 0) {
+        workers = std::min(workers, options.maxThreads);
+    }
+    workers = std::max<size_t>(1, std::min(workers, count));
+
+    JxlBatchMemoryBudget budget(options.maxInFlightBytes);
+    std::atomic<size_t> next(0);
+    // Tasks run on executor threads, the caller's cancellation is carried over to them explicitly
+    auto cancellation = JxlCancellationScope::current();
+
+    executor.parallelFor(static_cast<uint32_t>(workers), options.priority, [&](uint32_t, size_t) {
+        JxlCancellationScope scope(cancellation);
+        JxlBatchEncoderWorker encoder(options.priority);
+
+        for (size_t index = next.fetch_add(1, std::memory_order_relaxed); index < count;
+             index = next.fetch_add(1, std::memory_order_relaxed)) {
+            JxlBatchEncodeResult result;
+            result.index = index;
+            if (cancellation && cancellation->isCancelled()) {
+                completion(result);
+                continue;
+            }
+
+            // Without an estimate the whole budget is taken, so the image is prepared with nothing else in flight
+            const uint64_t estimated = estimate ? estimate(index) : 0;
+            uint64_t reserved = estimated > 0 ? estimated : options.maxInFlightBytes;
+            budget.acquire(reserved);
+            try {
+                JxlBatchEncodeImage image;
+                if (prepare(index, image)) {
+                    uint64_t prepared = std::max<uint64_t>(estimated, image.pixels.capacity());
+                    budget.adjust(reserved, prepared);
+                    reserved = prepared;
+
+                    // Images not yet picked up by any worker
+                    const size_t waiting = count - std::min(count, next.load(std::memory_order_relaxed));
+                    const uint64_t pixels = static_cast<uint64_t>(image.xsize) * image.ysize;
+                    result.parallelized = pixels >= options.largeImagePixels || waiting < workers;
+                    result.success = encoder.encode(image, !result.parallelized, &result.compressed);
+                }
+            } catch (std::bad_alloc&) {
+                result.success = false;
+            }
+            budget.release(reserved);
+
+            if (!result.success) {
+                result.compressed.clear();
+                result.compressed.shrink_to_fit();
+            }
+            completion(result);
+        }
+    });
+}
+
+}
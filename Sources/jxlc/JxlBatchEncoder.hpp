@@ -0,0 +1,105 @@
+//
+//  JxlBatchEncoder.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlBatchEncoder_hpp
+#define JxlBatchEncoder_hpp
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "JxlDefinitions.h"
+#include "JxlWorker.hpp"
+
+namespace jxlcoder {
+
+// Pixels of one image ready to be encoded, filled by JxlBatchEncodePrepare
+struct JxlBatchEncodeImage {
+    std::vector<uint8_t> pixels;
+    uint32_t xsize = 0;
+    uint32_t ysize = 0;
+    // Layout and color of pixels and the encoding settings, may differ between images
+    JxlEncoderProfile profile;
+    std::vector<uint8_t> exif;
+    std::vector<uint8_t> xmp;
+};
+
+struct JxlBatchEncodeResult {
+    // Position of the image in the batch
+    size_t index = 0;
+    bool success = false;
+    std::vector<uint8_t> compressed;
+    // Whether the image was encoded with threads of its own or on a single thread
+    bool parallelized = false;
+};
+
+struct JxlBatchEncodeOptions {
+    JxlRunnerPriority priority = runnerNormal;
+    // Images prepared or encoded at the same time, 0 uses every executor thread
+    size_t maxThreads = 0;
+    // Pixel memory of the images in flight, an image that alone exceeds it is still encoded, one at a time
+    uint64_t maxInFlightBytes = 1024 * 1024 * 1024;
+    // Images at least this large are always split across threads
+    uint64_t largeImagePixels = 4 * 1024 * 1024;
+};
+
+/**
+ * Upper bound of the memory preparing the image takes, called before it is prepared.
+ * 0 when unknown, the image is then prepared only once nothing else is in flight
+ * and the size of its prepared pixels is accounted for afterwards.
+ */
+typedef std::function<uint64_t(size_t index)> JxlBatchEncodeEstimate;
+/**
+ * Converts the image at index into pixels the encoder takes, from executor threads and possibly concurrently.
+ * @return false if the image cannot be prepared, it is reported as failed
+ */
+typedef std::function<bool(size_t index, JxlBatchEncodeImage& image)> JxlBatchEncodePrepare;
+/**
+ * Called once per image as soon as it is encoded, from executor threads and possibly concurrently.
+ * The result may be moved from.
+ */
+typedef std::function<void(JxlBatchEncodeResult& result)> JxlBatchEncodeCompletion;
+
+/**
+ * Prepares and encodes count images on the shared executor and blocks until all of them are done.
+ * Every worker takes the next image, prepares it and encodes it on an encoder it keeps across images,
+ * so the preparation of one image runs while other workers encode theirs and no thread waits on a stage.
+ * Images are encoded on a single thread while there are more of them left than workers,
+ * the last ones and those above largeImagePixels spread libjxl's parallel sections over the executor.
+ * A worker waits before preparing while the images in flight hold maxInFlightBytes.
+ * The caller's JxlCancellationScope applies to every image, those not started yet are reported as failed.
+ */
+void EncodeJxlHDRBatch(size_t count,
+                       const JxlBatchEncodeOptions& options,
+                       const JxlBatchEncodeEstimate& estimate,
+                       const JxlBatchEncodePrepare& prepare,
+                       const JxlBatchEncodeCompletion& completion);
+
+}
+
+#endif
+
+#endif /* JxlBatchEncoder_hpp */
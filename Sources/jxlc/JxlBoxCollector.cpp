@@ -0,0 +1,125 @@
+//
+//  JxlBoxCollector.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlBoxCollector.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace jxlcoder {
+
+static const size_t JxlBoxChunkSize = 16 * 1024;
+
+bool JxlBoxCollector::attach(JxlDecoder* dec) {
+    return JXL_DEC_SUCCESS == JxlDecoderSetDecompressBoxes(dec, JXL_TRUE);
+}
+
+bool JxlBoxCollector::wants(const std::string& type) const {
+    if (type == "Exif") {
+        return kinds & exif;
+    } else if (type == "xml ") {
+        return kinds & xmp;
+    } else if (type == "jumb") {
+        return kinds & jumbf;
+    }
+    // Signature, file type, level, codestream, frame index and JPEG reconstruction boxes belong to the container
+    static const char* containerTypes[] = { "JXL ", "ftyp", "jxll", "jxlc", "jxlp", "jxli", "jbrd" };
+    for (const char* containerType : containerTypes) {
+        if (type == containerType) {
+            return false;
+        }
+    }
+    return kinds & other;
+}
+
+void JxlBoxCollector::complete(JxlDecoder* dec) {
+    if (!collecting) {
+        return;
+    }
+    collecting = false;
+    size_t remaining = JxlDecoderReleaseBoxBuffer(dec);
+    JxlMetadataBox& box = collected.back();
+    box.data.resize(box.data.size() - remaining);
+}
+
+bool JxlBoxCollector::onBox(JxlDecoder* dec) {
+    complete(dec);
+
+    JxlBoxType type;
+    if (JXL_DEC_SUCCESS != JxlDecoderGetBoxType(dec, type, JXL_TRUE)) {
+        return false;
+    }
+    std::string decompressedType(type, sizeof(JxlBoxType));
+    if (!wants(decompressedType)) {
+        return true;
+    }
+    JxlBoxType rawType;
+    if (JXL_DEC_SUCCESS != JxlDecoderGetBoxType(dec, rawType, JXL_FALSE)) {
+        return false;
+    }
+
+    uint64_t rawSize = 0;
+    JxlDecoderGetBoxSizeRaw(dec, &rawSize);
+    JxlMetadataBox box;
+    box.type = decompressedType;
+    box.compressed = std::memcmp(rawType, "brob", sizeof(JxlBoxType)) == 0;
+    // Raw size is exact for plain boxes, compressed ones grow on demand
+    size_t initialSize = rawSize > 0 && rawSize <= maxBoxSize ? static_cast<size_t>(rawSize) : JxlBoxChunkSize;
+    box.data.resize(std::max(initialSize, size_t(1)));
+    collected.push_back(std::move(box));
+
+    JxlMetadataBox& current = collected.back();
+    if (JXL_DEC_SUCCESS != JxlDecoderSetBoxBuffer(dec, current.data.data(), current.data.size())) {
+        collected.pop_back();
+        return false;
+    }
+    collecting = true;
+    return true;
+}
+
+bool JxlBoxCollector::onNeedMoreOutput(JxlDecoder* dec) {
+    if (!collecting) {
+        return false;
+    }
+    JxlMetadataBox& box = collected.back();
+    size_t remaining = JxlDecoderReleaseBoxBuffer(dec);
+    size_t written = box.data.size() - remaining;
+    if (box.data.size() >= maxBoxSize) {
+        // Too large to keep, the rest of the box is skipped
+        collecting = false;
+        collected.pop_back();
+        return true;
+    }
+    box.data.resize(std::min(box.data.size() * 2, maxBoxSize));
+    if (JXL_DEC_SUCCESS != JxlDecoderSetBoxBuffer(dec, box.data.data() + written, box.data.size() - written)) {
+        return false;
+    }
+    return true;
+}
+
+void JxlBoxCollector::finish(JxlDecoder* dec) {
+    complete(dec);
+}
+
+}
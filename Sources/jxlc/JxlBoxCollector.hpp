@@ -0,0 +1,107 @@
+//
+//  JxlBoxCollector.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlBoxCollector_hpp
+#define JxlBoxCollector_hpp
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <jxl/decode.h>
+
+namespace jxlcoder {
+
+struct JxlMetadataBox {
+    // Type of the contents, "brob" boxes report the type they were compressed from
+    std::string type;
+    // Stored Brotli compressed, data is already decompressed
+    bool compressed;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * Collects container metadata boxes while the decoder runs, so metadata never needs a second parse of the file.
+ * Codestream and other boxes that describe the container itself are never collected.
+ */
+class JxlBoxCollector {
+public:
+    enum Kind : uint32_t {
+        exif = 1,
+        xmp = 2,
+        jumbf = 4,
+        // Application specific boxes of any other type
+        other = 8,
+        all = exif | xmp | jumbf | other
+    };
+
+    /**
+     * @param kinds mask of Kind values to collect
+     * @param maxBoxSize decompressed size at which a single box is dropped, guards against Brotli bombs
+     */
+    explicit JxlBoxCollector(uint32_t kinds = exif | xmp | jumbf, size_t maxBoxSize = 64 * 1024 * 1024) :
+    kinds(kinds), maxBoxSize(maxBoxSize) {}
+
+    /**
+     * Enables transparent brob decompression, call before decoding starts and subscribe to JXL_DEC_BOX
+     */
+    bool attach(JxlDecoder* dec);
+
+    /**
+     * Call on JXL_DEC_BOX, finishes the previous box and sets up the next one
+     */
+    bool onBox(JxlDecoder* dec);
+
+    /**
+     * Call on JXL_DEC_BOX_NEED_MORE_OUTPUT
+     */
+    bool onNeedMoreOutput(JxlDecoder* dec);
+
+    /**
+     * Call on JXL_DEC_SUCCESS, finishes the last box
+     */
+    void finish(JxlDecoder* dec);
+
+    std::vector<JxlMetadataBox>& boxes() {
+        return collected;
+    }
+
+private:
+    bool wants(const std::string& type) const;
+    void complete(JxlDecoder* dec);
+
+    uint32_t kinds;
+    size_t maxBoxSize;
+    std::vector<JxlMetadataBox> collected;
+    // Set while collected.back() is being written to
+    bool collecting = false;
+};
+
+}
+
+#endif
+
+#endif /* JxlBoxCollector_hpp */
@@ -0,0 +1,123 @@
+//
+//  JxlByteSource.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlByteSource.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace jxlcoder {
+
+bool JxlMemoryByteSource::read(uint8_t* destination, size_t maxLength, size_t* bytesRead) {
+    size_t count = std::min(maxLength, size - position);
+    if (count > 0) {
+        std::memcpy(destination, data + position, count);
+    }
+    position += count;
+    *bytesRead = count;
+    return true;
+}
+
+bool JxlMemoryByteSource::contiguous(const uint8_t** data, size_t* size) {
+    *data = this->data + position;
+    *size = this->size - position;
+    position = this->size;
+    return true;
+}
+
+bool JxlFileDescriptorByteSource::read(uint8_t* destination, size_t maxLength, size_t* bytesRead) {
+    for (;;) {
+        ssize_t result = ::read(fd, destination, maxLength);
+        if (result >= 0) {
+            *bytesRead = static_cast<size_t>(result);
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+bool JxlInputFeeder::feed(JxlDecoder* decoder) {
+    if (closed) {
+        // Decoder still wants bytes after the end of the stream
+        return false;
+    }
+
+    size_t remaining = 0;
+    if (attached) {
+        remaining = JxlDecoderReleaseInput(decoder);
+        attached = false;
+    }
+
+    if (window.empty()) {
+        const uint8_t* data;
+        size_t size;
+        if (source.contiguous(&data, &size)) {
+            closed = true;
+            if (JXL_DEC_SUCCESS != JxlDecoderSetInput(decoder, data, size)) {
+                return false;
+            }
+            JxlDecoderCloseInput(decoder);
+            return true;
+        }
+        window.resize(chunkSize);
+    }
+
+    if (remaining > 0 && remaining < filled) {
+        std::memmove(window.data(), window.data() + filled - remaining, remaining);
+    }
+    filled = remaining;
+
+    if (filled == window.size()) {
+        window.resize(window.size() * 2);
+    }
+
+    size_t bytesRead = 0;
+    if (!source.read(window.data() + filled, window.size() - filled, &bytesRead)) {
+        return false;
+    }
+    filled += bytesRead;
+    closed = bytesRead == 0;
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetInput(decoder, window.data(), filled)) {
+        return false;
+    }
+    attached = true;
+    if (closed) {
+        JxlDecoderCloseInput(decoder);
+    }
+    return true;
+}
+
+void JxlInputFeeder::release(JxlDecoder* decoder) {
+    if (attached) {
+        JxlDecoderReleaseInput(decoder);
+        attached = false;
+    }
+}
+
+}
@@ -0,0 +1,134 @@
+//
+//  JxlByteSource.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlByteSource_hpp
+#define JxlByteSource_hpp
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <jxl/decode.h>
+
+namespace jxlcoder {
+
+/**
+ * Abstract reader the streaming decoders pull compressed bytes from.
+ */
+class JxlByteSource {
+public:
+    virtual ~JxlByteSource() = default;
+
+    /**
+     * Blocks until at least one byte is available or the stream ends.
+     * @param bytesRead set to 0 when the end of the stream is reached
+     * @return false on I/O error
+     */
+    virtual bool read(uint8_t* destination, size_t maxLength, size_t* bytesRead) = 0;
+
+    /**
+     * Sources that already hold the whole file in memory expose it here, so it is handed to libjxl without a copy.
+     */
+    virtual bool contiguous(const uint8_t** /* data */, size_t* /* size */) {
+        return false;
+    }
+};
+
+class JxlMemoryByteSource : public JxlByteSource {
+public:
+    JxlMemoryByteSource(const uint8_t* data, size_t size) : data(data), size(size), position(0) {}
+
+    bool read(uint8_t* destination, size_t maxLength, size_t* bytesRead) override;
+    bool contiguous(const uint8_t** data, size_t* size) override;
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+};
+
+/**
+ * Reads from a file descriptor that stays owned by the caller.
+ */
+class JxlFileDescriptorByteSource : public JxlByteSource {
+public:
+    explicit JxlFileDescriptorByteSource(int fd) : fd(fd) {}
+
+    bool read(uint8_t* destination, size_t maxLength, size_t* bytesRead) override;
+
+private:
+    int fd;
+};
+
+class JxlCallbackByteSource : public JxlByteSource {
+public:
+    typedef std::function<bool(uint8_t* destination, size_t maxLength, size_t* bytesRead)> Reader;
+
+    explicit JxlCallbackByteSource(Reader reader) : reader(std::move(reader)) {}
+
+    bool read(uint8_t* destination, size_t maxLength, size_t* bytesRead) override {
+        return reader(destination, maxLength, bytesRead);
+    }
+
+private:
+    Reader reader;
+};
+
+/**
+ * Feeds a decoder from a byte source through JxlDecoderSetInput/JxlDecoderReleaseInput.
+ * Only the bytes libjxl has not consumed yet are kept, the window grows only when the decoder
+ * needs more contiguous data than it currently holds.
+ */
+class JxlInputFeeder {
+public:
+    explicit JxlInputFeeder(JxlByteSource& source, size_t chunkSize = 64 * 1024) :
+    source(source), chunkSize(chunkSize), filled(0), attached(false), closed(false) {}
+
+    /**
+     * Call on JXL_DEC_NEED_MORE_INPUT and once before the first JxlDecoderProcessInput.
+     * @return false if the source failed or was exhausted, i.e. the file is truncated
+     */
+    bool feed(JxlDecoder* decoder);
+
+    /**
+     * Detaches the window from the decoder, must be called before the decoder outlives the feeder.
+     */
+    void release(JxlDecoder* decoder);
+
+private:
+    JxlByteSource& source;
+    std::vector<uint8_t> window;
+    size_t chunkSize;
+    size_t filled;
+    bool attached;
+    bool closed;
+};
+
+}
+
+#endif
+
+#endif /* JxlByteSource_hpp */
@@ -0,0 +1,45 @@
+//
+//  JxlCancellation.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlCancellation.hpp"
+
+namespace jxlcoder {
+
+static thread_local JxlCancellationScope* currentCancellationScope = nullptr;
+
+JxlCancellationScope::JxlCancellationScope(std::shared_ptr<JxlCancellationToken> token) :
+token(std::move(token)), previous(currentCancellationScope) {
+    currentCancellationScope = this;
+}
+
+JxlCancellationScope::~JxlCancellationScope() {
+    currentCancellationScope = previous;
+}
+
+std::shared_ptr<JxlCancellationToken> JxlCancellationScope::current() {
+    return currentCancellationScope ? currentCancellationScope->token : nullptr;
+}
+
+}
@@ -0,0 +1,107 @@
+//
+//  JxlCancellation.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlCancellation_hpp
+#define JxlCancellation_hpp
+
+#ifdef __cplusplus
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace jxlcoder {
+
+/**
+ * Lets another thread stop a running encode or decode, or stops it once a deadline has passed.
+ * Checked between libjxl processing steps and before every task handed to the shared executor,
+ * so abandoned work ends within one task and the call returns failure.
+ */
+class JxlCancellationToken {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    JxlCancellationToken() = default;
+    explicit JxlCancellationToken(Clock::time_point deadline) {
+        setDeadline(deadline);
+    }
+
+    JxlCancellationToken(const JxlCancellationToken&) = delete;
+    JxlCancellationToken& operator=(const JxlCancellationToken&) = delete;
+
+    void cancel() {
+        cancelled.store(true, std::memory_order_release);
+    }
+
+    void setDeadline(Clock::time_point deadline) {
+        deadlineTicks.store(deadline.time_since_epoch().count(), std::memory_order_release);
+    }
+
+    bool isCancelled() const {
+        if (cancelled.load(std::memory_order_acquire)) {
+            return true;
+        }
+        const auto deadline = deadlineTicks.load(std::memory_order_acquire);
+        return deadline != noDeadline && Clock::now().time_since_epoch().count() >= deadline;
+    }
+
+private:
+    static constexpr Clock::rep noDeadline = 0;
+
+    std::atomic<bool> cancelled{false};
+    std::atomic<Clock::rep> deadlineTicks{noDeadline};
+};
+
+/**
+ * Makes the token apply to every codec call made on the calling thread while the scope is alive.
+ *
+ *     auto token = std::make_shared<jxlcoder::JxlCancellationToken>(deadline);
+ *     jxlcoder::JxlCancellationScope scope(token);
+ *     bool decoded = DecodeJpegXlStream(...);
+ */
+class JxlCancellationScope {
+public:
+    explicit JxlCancellationScope(std::shared_ptr<JxlCancellationToken> token);
+    ~JxlCancellationScope();
+
+    JxlCancellationScope(const JxlCancellationScope&) = delete;
+    JxlCancellationScope& operator=(const JxlCancellationScope&) = delete;
+
+    /**
+     * Token of the innermost scope of the calling thread, or nullptr
+     */
+    static std::shared_ptr<JxlCancellationToken> current();
+
+private:
+    std::shared_ptr<JxlCancellationToken> token;
+    JxlCancellationScope* previous;
+};
+
+}
+
+#endif
+
+#endif /* JxlCancellation_hpp */
@@ -34,7 +34,7 @@ public:
             return nullptr;
         }
         JxlConstructionDataWrapper<uint8_t>* dataWrapper = new JxlConstructionDataWrapper<uint8_t>();
-        dataWrapper->data = contruction.getCompressedData();
+        dataWrapper->data = std::move(contruction.getCompressedData());
         
         auto data = [[NSData alloc] initWithBytesNoCopy:dataWrapper->data.data()
                                                  length:dataWrapper->data.size()
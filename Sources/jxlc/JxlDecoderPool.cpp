@@ -0,0 +1,129 @@
+//
+//  JxlDecoderPool.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlDecoderPool.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace jxlcoder {
+
+JxlDecoderLease::JxlDecoderLease(JxlDecoderLease&& other) noexcept :
+pool(other.pool), context(std::move(other.context)) {
+    other.pool = nullptr;
+}
+
+JxlDecoderLease& JxlDecoderLease::operator=(JxlDecoderLease&& other) noexcept {
+    if (this != &other) {
+        if (pool && context) {
+            pool->recycle(std::move(context));
+        }
+        pool = other.pool;
+        context = std::move(other.context);
+        other.pool = nullptr;
+    }
+    return *this;
+}
+
+JxlDecoderLease::~JxlDecoderLease() {
+    if (pool && context) {
+        pool->recycle(std::move(context));
+    }
+}
+
+JxlDecoderPool::JxlDecoderPool(size_t capacity) : capacity(capacity) {
+
+}
+
+JxlDecoderPool& JxlDecoderPool::shared() {
+    static JxlDecoderPool pool(std::max(std::thread::hardware_concurrency(), 2u));
+    return pool;
+}
+
+bool JxlDecoderPool::prepare(JxlDecoderContext* context) {
+    static JxlSharedRunner defaultRunner(runnerNormal);
+    // Reset drops every setting including the parallel runner, so it must be attached again
+    JxlDecoderReset(context->decoder.get());
+    return JXL_DEC_SUCCESS == JxlDecoderSetParallelRunner(context->decoder.get(),
+                                                          JxlSharedParallelRunner,
+                                                          &defaultRunner);
+}
+
+JxlDecoderLease JxlDecoderPool::acquire() {
+    {
+        std::lock_guard guard(lock);
+        if (!idle.empty()) {
+            auto context = std::move(idle.back());
+            idle.pop_back();
+            JxlMemoryScope::begin(*context->arena);
+            return JxlDecoderLease(this, std::move(context));
+        }
+    }
+
+    auto context = std::make_unique<JxlDecoderContext>();
+    context->arena = std::make_unique<JxlMemoryArena>(decoderCacheLimit);
+    context->decoder = JxlDecoderMake(context->arena->manager());
+    if (!context->decoder) {
+        return JxlDecoderLease();
+    }
+    if (!prepare(context.get())) {
+        return JxlDecoderLease();
+    }
+    JxlMemoryScope::begin(*context->arena);
+    return JxlDecoderLease(this, std::move(context));
+}
+
+void JxlDecoderPool::recycle(std::unique_ptr<JxlDecoderContext> context) {
+    JxlMemoryScope::collect(*context->arena);
+    // Resetting here releases decoder internal buffers before the context goes idle
+    if (!prepare(context.get())) {
+        return;
+    }
+    std::lock_guard guard(lock);
+    if (idle.size() < capacity) {
+        idle.push_back(std::move(context));
+    }
+}
+
+void JxlDecoderPool::setCapacity(size_t newCapacity) {
+    std::vector<std::unique_ptr<JxlDecoderContext>> released;
+    {
+        std::lock_guard guard(lock);
+        capacity = newCapacity;
+        while (idle.size() > capacity) {
+            released.push_back(std::move(idle.back()));
+            idle.pop_back();
+        }
+    }
+}
+
+void JxlDecoderPool::drain() {
+    std::vector<std::unique_ptr<JxlDecoderContext>> released;
+    {
+        std::lock_guard guard(lock);
+        released.swap(idle);
+    }
+}
+
+}
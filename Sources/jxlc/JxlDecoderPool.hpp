@@ -0,0 +1,135 @@
+//
+//  JxlDecoderPool.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlDecoderPool_hpp
+#define JxlDecoderPool_hpp
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <jxl/decode.h>
+#include <jxl/decode_cxx.h>
+#include "JxlSharedRunner.hpp"
+#include "JxlMemoryArena.hpp"
+
+namespace jxlcoder {
+
+/**
+ * Decoder kept alive by JxlDecoderPool and reset between uses, together with the arena it allocates from.
+ */
+struct JxlDecoderContext {
+    // Declared first so it outlives the decoder
+    std::unique_ptr<JxlMemoryArena> arena;
+    JxlDecoderPtr decoder;
+};
+
+class JxlDecoderPool;
+
+/**
+ * Scoped ownership of a pooled decoder. The context is returned to its pool on destruction.
+ */
+class JxlDecoderLease {
+public:
+    JxlDecoderLease() : pool(nullptr) {}
+    JxlDecoderLease(JxlDecoderPool* pool, std::unique_ptr<JxlDecoderContext> context) :
+    pool(pool), context(std::move(context)) {}
+    JxlDecoderLease(JxlDecoderLease&& other) noexcept;
+    JxlDecoderLease& operator=(JxlDecoderLease&& other) noexcept;
+    JxlDecoderLease(const JxlDecoderLease&) = delete;
+    JxlDecoderLease& operator=(const JxlDecoderLease&) = delete;
+    ~JxlDecoderLease();
+
+    explicit operator bool() const {
+        return context != nullptr;
+    }
+
+    JxlDecoder* decoder() const {
+        return context->decoder.get();
+    }
+
+    /**
+     * Memory used by the decoder since it was leased
+     */
+    JxlMemoryStats memory() const {
+        return context->arena->stats();
+    }
+
+private:
+    JxlDecoderPool* pool;
+    std::unique_ptr<JxlDecoderContext> context;
+};
+
+/**
+ * Thread-safe pool of ready to use decoders.
+ * Every leased decoder is freshly reset with JxlDecoderReset and already has the shared parallel runner
+ * attached with normal priority, so callers only subscribe to events and set the input.
+ * Each decoder allocates from its own JxlMemoryArena, so buffers freed by one decoding are reused by the next
+ * one without touching the global allocator. Leases pick up the limit of the calling thread JxlMemoryScope
+ * and report into it when returned.
+ */
+class JxlDecoderPool {
+public:
+    // Freed blocks each pooled decoder keeps for reuse, there may be as many decoders as hardware threads
+    static constexpr size_t decoderCacheLimit = 4 * 1024 * 1024;
+
+    explicit JxlDecoderPool(size_t capacity);
+
+    static JxlDecoderPool& shared();
+
+    /**
+     * @return lease that evaluates to false if a decoder cannot be created
+     */
+    JxlDecoderLease acquire();
+
+    /**
+     * Sets how many idle decoders may be retained, extra ones are destroyed.
+     */
+    void setCapacity(size_t newCapacity);
+
+    /**
+     * Destroys all idle decoders, memory they cached goes back to the system.
+     * Meant for memory warnings, decoders are created again on demand.
+     */
+    void drain();
+
+private:
+    friend class JxlDecoderLease;
+
+    void recycle(std::unique_ptr<JxlDecoderContext> context);
+    static bool prepare(JxlDecoderContext* context);
+
+    std::mutex lock;
+    std::vector<std::unique_ptr<JxlDecoderContext>> idle;
+    size_t capacity;
+};
+
+}
+
+#endif
+
+#endif /* JxlDecoderPool_hpp */
@@ -39,7 +39,9 @@ enum JxlCompressionOption {
 enum JxlDecodingPixelFormat {
     optimal = 1,
     r8 = 2,
-    r16 = 3
+    r16 = 3,
+    f16 = 4,
+    f32 = 5
 };
 
 enum JxlEncodingPixelFormat {
@@ -47,6 +49,12 @@ enum JxlEncodingPixelFormat {
     efloat16 = 2
 };
 
+enum JxlRunnerPriority {
+    runnerLow = 1,
+    runnerNormal = 2,
+    runnerHigh = 3
+};
+
 enum JxlExposedOrientation {
     Identity = 1,
     FlipHorizontal = 2,
@@ -58,4 +66,17 @@ enum JxlExposedOrientation {
     Rotate90CCW = 8
 };
 
+enum JxlTargetColorSpace {
+    colorSpaceOriginal = 0,
+    colorSpaceSRGB = 1,
+    colorSpaceDisplayP3 = 2,
+    colorSpaceBT2020PQ = 3,
+    colorSpaceLinearSRGB = 4
+};
+
+enum JxlRateTarget {
+    rateTargetSize = 1,
+    rateTargetSSIM = 2
+};
+
 #endif /* JXL_DEFINITIONS_H */
@@ -0,0 +1,66 @@
+//
+//  JxlEncoderSession.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlEncoderSession.hpp"
+#include "JxlCancellation.hpp"
+
+JxlEncoderSession::JxlEncoderSession(const JxlEncoderProfile& profile, JxlRunnerPriority priority) :
+settings(profile), runner(priority), enc(JxlEncoderMake(arena.manager())) {
+    runner.maxThreads = kHDREncoderMaxThreads;
+    if (!enc) {
+        std::string str = "Cannot initialize encoder";
+        throw EncoderSessionError(str);
+    }
+}
+
+bool JxlEncoderSession::encode(const std::vector<uint8_t>& pixels, uint32_t xsize, uint32_t ysize,
+                               jxlcoder::JxlOutputSink& output,
+                               const std::vector<uint8_t>* exifData,
+                               const std::vector<uint8_t>* xmpData) {
+    // Reset drops every setting including the runner and the output processor,
+    // what stays is the encoder itself and the memory it allocated
+    JxlEncoderReset(enc.get());
+    // The session may outlive the cancellation scope it was created in
+    runner.cancellation = jxlcoder::JxlCancellationScope::current();
+    jxlcoder::JxlMemoryScope::begin(arena);
+
+    bool encoded = JXL_ENC_SUCCESS == JxlEncoderSetParallelRunner(enc.get(),
+                                                                  jxlcoder::JxlSharedParallelRunner,
+                                                                  &runner) &&
+    EncodeJxlHDRFrame(enc.get(), output, settings, xsize, ysize, &pixels, nullptr, exifData, xmpData) &&
+    !runner.cancelled();
+
+    jxlcoder::JxlMemoryScope::collect(arena);
+    return encoded;
+}
+
+bool JxlEncoderSession::encode(const std::vector<uint8_t>& pixels, uint32_t xsize, uint32_t ysize,
+                               std::vector<uint8_t>* compressed,
+                               const std::vector<uint8_t>* exifData,
+                               const std::vector<uint8_t>* xmpData) {
+    compressed->clear();
+    jxlcoder::JxlVectorOutputSink output(*compressed);
+    return encode(pixels, xsize, ysize, output, exifData, xmpData);
+}
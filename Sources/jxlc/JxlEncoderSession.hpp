@@ -0,0 +1,105 @@
+//
+//  JxlEncoderSession.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlEncoderSession_hpp
+#define JxlEncoderSession_hpp
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <jxl/encode.h>
+#include <jxl/encode_cxx.h>
+#include "JxlWorker.hpp"
+#include "JxlMemoryArena.hpp"
+#include "JxlOutputSink.hpp"
+#include "JxlSharedRunner.hpp"
+
+class EncoderSessionError : public std::exception {
+public:
+    EncoderSessionError(const std::string& message) : errorMessage(message) {}
+
+    const char* what() const noexcept override {
+        return errorMessage.c_str();
+    }
+
+private:
+    std::string errorMessage;
+};
+
+/**
+ * Encodes a series of images with the same profile on one encoder.
+ * The encoder, the memory arena it allocates from and the runner are created once, between images
+ * JxlEncoderReset drops only what belongs to the previous image, so blocks libjxl freed are reused
+ * for the next one instead of going back to the system.
+ * A session encodes one image at a time, use one session per thread.
+ */
+class JxlEncoderSession {
+public:
+    explicit JxlEncoderSession(const JxlEncoderProfile& profile,
+                               JxlRunnerPriority priority = runnerNormal);
+
+    JxlEncoderSession(const JxlEncoderSession&) = delete;
+    JxlEncoderSession& operator=(const JxlEncoderSession&) = delete;
+
+    /**
+     * Encodes interleaved pixels laid out as the profile describes
+     * @return false if encoding fails, the session stays usable
+     */
+    bool encode(const std::vector<uint8_t>& pixels, uint32_t xsize, uint32_t ysize,
+                jxlcoder::JxlOutputSink& output,
+                const std::vector<uint8_t>* exifData = nullptr,
+                const std::vector<uint8_t>* xmpData = nullptr);
+
+    bool encode(const std::vector<uint8_t>& pixels, uint32_t xsize, uint32_t ysize,
+                std::vector<uint8_t>* compressed,
+                const std::vector<uint8_t>* exifData = nullptr,
+                const std::vector<uint8_t>* xmpData = nullptr);
+
+    /**
+     * May be changed between images, e.g. when a source has a different bit depth than the one before
+     */
+    JxlEncoderProfile& profile() {
+        return settings;
+    }
+
+    /**
+     * Memory libjxl used for the last image
+     */
+    jxlcoder::JxlMemoryStats memoryStats() const {
+        return arena.stats();
+    }
+
+private:
+    JxlEncoderProfile settings;
+    jxlcoder::JxlSharedRunner runner;
+    jxlcoder::JxlMemoryArena arena;
+    JxlEncoderPtr enc;
+};
+
+#endif
+
+#endif /* JxlEncoderSession_hpp */
@@ -30,13 +30,95 @@
 #import "JXLSystemImage.hpp"
 #import "CJpegXLAnimatedEncoder.h"
 #import "CJpegXLAnimatedDecoder.h"
+#import "CJpegXLProgressiveDecoder.h"
+#import "CJpegXLEncoderSession.h"
+#import "JXLCancellationToken.h"
+
+/// Image properties read from the headers only
+@interface JXLImageDescriptor: NSObject
+/// Displayed size, orientation already applied
+@property (nonatomic, readonly) CGSize size;
+@property (nonatomic, readonly) int bitsPerSample;
+@property (nonatomic, readonly) bool isFloat;
+@property (nonatomic, readonly) int colorChannels;
+@property (nonatomic, readonly) bool hasAlpha;
+@property (nonatomic, readonly) bool alphaPremultiplied;
+/// EXIF style orientation 1...8
+@property (nonatomic, readonly) int orientation;
+@property (nonatomic, readonly) bool hasAnimation;
+/// 1 for still images, 0 when unknown
+@property (nonatomic, readonly) int frameCountHint;
+@property (nonatomic, readonly) int loopCount;
+/// Color is described by enumerated values, otherwise by an ICC profile
+@property (nonatomic, readonly) bool hasColorEncoding;
+@property (nonatomic, readonly) NSUInteger iccProfileSize;
+@property (nonatomic, readonly) bool hasPreview;
+@property (nonatomic, readonly) CGSize previewSize;
+@end
+
+/// Metadata box of the container, such as Exif, XMP ("xml ") or JUMBF ("jumb")
+@interface JXLMetadataBox: NSObject
+/// Type of the contents, Brotli compressed boxes report the type they were compressed from
+@property (nonatomic, readonly, nonnull) NSString *type;
+/// Stored compressed, data is already decompressed
+@property (nonatomic, readonly) bool compressed;
+@property (nonatomic, readonly, nonnull) NSData *data;
+@end
+
+typedef void (^JXLBatchCompletion)(NSInteger index, JXLSystemImage *_Nullable image, NSError *_Nullable error);
+typedef void (^JXLBatchEncodeCompletion)(NSInteger index, NSData *_Nullable data, NSError *_Nullable error);
 
 @interface JxlInternalCoder: NSObject
+/// Reads only the image headers, no pixels are decoded and no threads are used.
+/// Returns nil when data is not a JXL image, or sets neededBytes when data is cut before the headers end.
+- (nullable JXLImageDescriptor *)probe:(nonnull NSData *)data
+                           neededBytes:(nonnull NSInteger *)neededBytes;
+/// With premultiplied color comes out multiplied by alpha in the same pass it is decoded in,
+/// rescaled images keep straight alpha
 - (nullable JXLSystemImage *)decode:(nonnull NSInputStream *)inputStream
                              rescale:(CGSize)rescale
                              pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+                             premultiplied:(bool)premultiplied
+                             scale:(int)scale
+                             error:(NSError *_Nullable * _Nullable)error;
+/// Returns the embedded preview image when it covers minimumSize, otherwise the cheapest
+/// reduced resolution step that does. The result is never smaller than minimumSize and is not resampled.
+- (nullable JXLSystemImage *)preview:(nonnull NSInputStream *)inputStream
+                         minimumSize:(CGSize)minimumSize
+                         pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+                               scale:(int)scale
+                               error:(NSError *_Nullable * _Nullable)error;
+/// Decodes at full resolution with pixels converted into colorSpace by the bundled CMS in the same pass,
+/// the image is tagged with the target space instead of the one it was encoded in
+- (nullable JXLSystemImage *)decode:(nonnull NSInputStream *)inputStream
+                         colorSpace:(JXLTargetColorSpace)colorSpace
+                        pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+                      premultiplied:(bool)premultiplied
+                              scale:(int)scale
+                              error:(NSError *_Nullable * _Nullable)error;
+/// Decodes at full resolution and collects Exif, XMP and JUMBF boxes in the same pass
+- (nullable JXLSystemImage *)decode:(nonnull NSInputStream *)inputStream
+                        pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+                      premultiplied:(bool)premultiplied
+                              scale:(int)scale
+                              boxes:(NSArray<JXLMetadataBox *> *_Nullable * _Nonnull)boxes
+                              error:(NSError *_Nullable * _Nullable)error;
+/// Reads every metadata box without decoding pixels
+- (nullable NSArray<JXLMetadataBox *> *)boxes:(nonnull NSInputStream *)inputStream
+                                        error:(NSError *_Nullable * _Nullable)error;
+/// Decodes only the given rectangle in displayed coordinates, memory use is proportional to the region
+- (nullable JXLSystemImage *)decode:(nonnull NSInputStream *)inputStream
+                             region:(CGRect)region
+                             pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
                              scale:(int)scale
                              error:(NSError *_Nullable * _Nullable)error;
+/// Decodes every image on the shared executor and returns once all of them are done.
+/// completion is called once per image with its index, from worker threads and possibly concurrently.
+- (void)decodeBatch:(nonnull NSArray<NSData *> *)images
+        pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+      premultiplied:(bool)premultiplied
+              scale:(int)scale
+         completion:(nonnull JXLBatchCompletion)completion;
 - (CGSize)getSize:(nonnull NSInputStream *)inputStream error:(NSError *_Nullable * _Nullable)error;
 - (nullable NSData *)encode:(nonnull JXLSystemImage *)platformImage
                      colorSpace:(JXLColorSpace)colorSpace
@@ -64,6 +146,7 @@
 /// @param effort Compression effort 1-9
 /// @param distance Lossy distance 0.0-15.0 (0=lossless, 1=visually lossless, 15=max lossy)
 /// @param decodingSpeed Decode speed vs size tradeoff
+/// @param embedPreview Store low resolution steps first so previews decode from a small prefix
 /// @param error Error output
 - (nullable NSData *)encodeHDR:(nonnull JXLSystemImage *)platformImage
                       exifData:(nullable NSData *)exifData
@@ -72,7 +155,67 @@
                         effort:(int)effort
                       distance:(float)distance
                  decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+                  embedPreview:(bool)embedPreview
                          error:(NSError * _Nullable *_Nullable)error;
+
+/// Same as above, writing the file to outputStream while it is encoded instead of collecting it in memory.
+/// The stream is opened if needed and closed once encoding is done.
+- (BOOL)encodeHDR:(nonnull JXLSystemImage *)platformImage
+         exifData:(nullable NSData *)exifData
+          xmpData:(nullable NSData *)xmpData
+compressionOption:(JXLCompressionOption)compressionOption
+           effort:(int)effort
+         distance:(float)distance
+    decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+     embedPreview:(bool)embedPreview
+     outputStream:(nonnull NSOutputStream *)outputStream
+            error:(NSError * _Nullable *_Nullable)error;
+
+/// Encodes images too large to convert at once with bounded memory: pixels are converted a few groups
+/// at a time while libjxl streams the frame, and the file goes to outputStream as it is produced.
+/// Parameters are the same as in encodeHDR, low resolution steps cannot be put first in this mode.
+- (BOOL)encodeHDRChunked:(nonnull JXLSystemImage *)platformImage
+                exifData:(nullable NSData *)exifData
+                 xmpData:(nullable NSData *)xmpData
+       compressionOption:(JXLCompressionOption)compressionOption
+                  effort:(int)effort
+                distance:(float)distance
+           decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+            outputStream:(nonnull NSOutputStream *)outputStream
+                   error:(NSError * _Nullable *_Nullable)error;
+
+/// Lossy encoding that searches the distance meeting a file size in bytes or a minimum SSIM.
+/// Low effort probes run in parallel to predict the distance, then the image is encoded at effort;
+/// at most maxTrials encodes are made in total, the closest result is returned when the target is missed.
+/// @param targetValue Maximum file size in bytes, or minimum SSIM in 0...1
+- (nullable NSData *)encodeHDR:(nonnull JXLSystemImage *)platformImage
+                      exifData:(nullable NSData *)exifData
+                       xmpData:(nullable NSData *)xmpData
+                    rateTarget:(JXLRateTarget)rateTarget
+                   targetValue:(double)targetValue
+                        effort:(int)effort
+                 decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+                     maxTrials:(int)maxTrials
+                         error:(NSError * _Nullable *_Nullable)error;
+
+/// Encodes every image on the shared executor and returns once all of them are done.
+/// Pixels of one image are extracted while others are encoded, at most maxThreads images at a time
+/// (0 uses every executor thread) and with their pixels within maxInFlightBytes.
+/// exifData and xmpData are nil or hold one entry per image, empty data for none.
+/// completion is called once per image with its index, from worker threads and possibly concurrently.
+- (void)encodeHDRBatch:(nonnull NSArray<JXLSystemImage *> *)images
+              exifData:(nullable NSArray<NSData *> *)exifData
+               xmpData:(nullable NSArray<NSData *> *)xmpData
+     compressionOption:(JXLCompressionOption)compressionOption
+                effort:(int)effort
+              distance:(float)distance
+         decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+            maxThreads:(NSInteger)maxThreads
+      maxInFlightBytes:(uint64_t)maxInFlightBytes
+            completion:(nonnull JXLBatchEncodeCompletion)completion;
+/// Releases idle pooled decoders and the memory they keep for reuse, e.g. on a memory warning.
+/// Decoders in use are not affected.
++ (void)purgeCaches;
 @end
 
 #endif /* JXLCoder_h */
@@ -27,9 +27,17 @@
 #import "JxlInternalCoder.h"
 #import <vector>
 #import "JxlWorker.hpp"
+#import "JxlBatchDecoder.hpp"
+#import "JxlDecoderPool.hpp"
+#import "JxlBatchEncoder.hpp"
+#import "JxlBoxCollector.hpp"
+#import "JxlOutputSink.hpp"
+#import "JxlRateControl.hpp"
+#import <memory>
 #import <Accelerate/Accelerate.h>
 #import "RgbRgbaConverter.hpp"
 #import "RgbaScaler.h"
+#import "JXLBitmapFormat.h"
 #import <algorithm>
 
 static void JXLCGData8ProviderReleaseDataCallback(void *info, const void *data, size_t size) {
@@ -37,6 +45,71 @@ static void JXLCGData8ProviderReleaseDataCallback(void *info, const void *data,
     delete dataWrapper;
 }
 
+static void JXLCGDataMallocProviderReleaseDataCallback(void *info, const void *data, size_t size) {
+    free(info);
+}
+
+/**
+ * Pulls compressed bytes from NSInputStream only when libjxl asks for them.
+ * The first chunk is checked against the JXL signature so callers can tell a foreign file from a broken one.
+ */
+class JXLInputStreamByteSource : public jxlcoder::JxlByteSource {
+public:
+    explicit JXLInputStreamByteSource(NSInputStream *stream) : stream(stream), signatureChecked(false), notJXL(false) {}
+
+    bool read(uint8_t* destination, size_t maxLength, size_t* bytesRead) override {
+        NSInteger result = [stream read:destination maxLength:maxLength];
+        if (result < 0) {
+            return false;
+        }
+        if (!signatureChecked && result > 0) {
+            signatureChecked = true;
+            if (!isJXL(destination, static_cast<size_t>(result))) {
+                notJXL = true;
+                return false;
+            }
+        }
+        *bytesRead = static_cast<size_t>(result);
+        return true;
+    }
+
+    NSError* failure() {
+        if (notJXL) {
+            return [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Not an JXL image" }];
+        }
+        return [stream streamError];
+    }
+
+private:
+    NSInputStream *stream;
+    bool signatureChecked;
+    bool notJXL;
+};
+
+class JXLOutputStreamSink : public jxlcoder::JxlOutputSink {
+public:
+    explicit JXLOutputStreamSink(NSOutputStream *stream) : stream(stream) {}
+
+    bool write(uint64_t position, const uint8_t* data, size_t size) override {
+        while (size > 0) {
+            NSInteger result = [stream write:data maxLength:size];
+            if (result <= 0) {
+                return false;
+            }
+            data += result;
+            size -= static_cast<size_t>(result);
+        }
+        return true;
+    }
+
+    NSError* failure() {
+        return [stream streamError];
+    }
+
+private:
+    NSOutputStream *stream;
+};
+
 static inline float JXLGetDistance(int quality)
 {
     if (quality == 0)
@@ -53,7 +126,433 @@ static inline JxlCompressionOption toJxlCompressionOption(JXLCompressionOption o
     return (opt == kLossless) ? lossless : lossy;
 }
 
+/**
+ * Named CoreGraphics space for the enum based encodings JxlIsNamedColorEncoding accepts
+ */
+static CGColorSpaceRef _Nullable JXLCreateNamedColorSpace(const JxlColorEncoding& encoding) {
+    CFStringRef name = nullptr;
+    switch (encoding.primaries) {
+        case JXL_PRIMARIES_SRGB:
+            name = encoding.transfer_function == JXL_TRANSFER_FUNCTION_LINEAR ? kCGColorSpaceLinearSRGB : kCGColorSpaceSRGB;
+            break;
+        case JXL_PRIMARIES_P3:
+            if (encoding.transfer_function == JXL_TRANSFER_FUNCTION_SRGB) {
+                name = kCGColorSpaceDisplayP3;
+            } else if (encoding.transfer_function == JXL_TRANSFER_FUNCTION_LINEAR) {
+                name = kCGColorSpaceExtendedLinearDisplayP3;
+            } else if (encoding.transfer_function == JXL_TRANSFER_FUNCTION_HLG) {
+                name = kCGColorSpaceDisplayP3_HLG;
+            } else if (@available(iOS 14.0, macOS 11.0, *)) {
+                name = kCGColorSpaceDisplayP3_PQ;
+            } else {
+                name = kCGColorSpaceDisplayP3_PQ_EOTF;
+            }
+            break;
+        case JXL_PRIMARIES_2100:
+            if (encoding.transfer_function == JXL_TRANSFER_FUNCTION_LINEAR) {
+                name = kCGColorSpaceExtendedLinearITUR_2020;
+            } else if (@available(iOS 14.0, macOS 11.0, *)) {
+                name = encoding.transfer_function == JXL_TRANSFER_FUNCTION_PQ ? kCGColorSpaceITUR_2100_PQ : kCGColorSpaceITUR_2100_HLG;
+            } else {
+                name = encoding.transfer_function == JXL_TRANSFER_FUNCTION_PQ ? kCGColorSpaceITUR_2020_PQ_EOTF : kCGColorSpaceITUR_2020_HLG;
+            }
+            break;
+        default:
+            break;
+    }
+    return name ? CGColorSpaceCreateWithName(name) : nullptr;
+}
+
+static CGColorRenderingIntent JXLRenderingIntent(const JxlColorDescription& color) {
+    if (!color.parametric) {
+        return kCGRenderingIntentDefault;
+    }
+    switch (color.encoding.rendering_intent) {
+        case JXL_RENDERING_INTENT_PERCEPTUAL:
+            return kCGRenderingIntentPerceptual;
+        case JXL_RENDERING_INTENT_RELATIVE:
+            return kCGRenderingIntentRelativeColorimetric;
+        case JXL_RENDERING_INTENT_SATURATION:
+            return kCGRenderingIntentSaturation;
+        case JXL_RENDERING_INTENT_ABSOLUTE:
+            return kCGRenderingIntentAbsoluteColorimetric;
+    }
+    return kCGRenderingIntentDefault;
+}
+
+/**
+ * Wraps decoded interleaved pixels into a platform image, the provider is consumed
+ */
+static JXLSystemImage * _Nullable JXLCreatePlatformImage(CGDataProviderRef provider,
+                                                         size_t xSize, size_t ySize, size_t stride,
+                                                         int components, JxlDataType dataType,
+                                                         bool premultiplied,
+                                                         const JxlColorDescription& color,
+                                                         int scale,
+                                                         NSError * _Nullable * _Nullable error) {
+    CGColorSpaceRef colorSpace = nullptr;
+    if (color.parametric) {
+        colorSpace = JXLCreateNamedColorSpace(color.encoding);
+    } else if (color.iccProfile.size() > 0) {
+        CFDataRef iccData = CFDataCreate(kCFAllocatorDefault, color.iccProfile.data(), color.iccProfile.size());
+        colorSpace = CGColorSpaceCreateWithICCData(iccData);
+        CFRelease(iccData);
+    }
+
+    if (!colorSpace) {
+        if (components > 1) {
+            colorSpace = CGColorSpaceCreateDeviceRGB();
+        } else {
+            colorSpace = CGColorSpaceCreateDeviceGray();
+        }
+    }
+
+    CGBitmapInfo flags = JXLBitmapInfo(dataType, components, premultiplied);
+    size_t bitsPerComponent = JXLBitsPerComponent(dataType);
+    size_t bitsPerPixel = bitsPerComponent*components;
+
+    CGImageRef imageRef = CGImageCreate(xSize, ySize, bitsPerComponent,
+                                        bitsPerPixel,
+                                        stride,
+                                        colorSpace, flags, provider, NULL, false, JXLRenderingIntent(color));
+    CGDataProviderRelease(provider);
+    CGColorSpaceRelease(colorSpace);
+    if (!imageRef) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate CGImageRef" }];
+        return nullptr;
+    }
+    JXLSystemImage *image = nil;
+#if JXL_PLUGIN_MAC
+    image = [[NSImage alloc] initWithCGImage:imageRef size:CGSizeZero];
+#else
+    image = [UIImage imageWithCGImage:imageRef scale:scale orientation:UIImageOrientationUp];
+#endif
+    CGImageRelease(imageRef);
+
+    return image;
+}
+
+/**
+ * Moves tightly packed pixels into a data provider without copying them
+ */
+static JXLSystemImage * _Nullable JXLCreatePlatformImage(std::vector<uint8_t>& outputData,
+                                                         size_t xSize, size_t ySize,
+                                                         int components, JxlDataType dataType,
+                                                         bool premultiplied,
+                                                         const JxlColorDescription& color,
+                                                         int scale,
+                                                         NSError * _Nullable * _Nullable error) {
+    auto dataWrapper = new JXLDataWrapper<uint8_t>();
+    dataWrapper->data = std::move(outputData);
+
+    CGDataProviderRef provider = CGDataProviderCreateWithData(dataWrapper,
+                                                              dataWrapper->data.data(),
+                                                              dataWrapper->data.size(),
+                                                              JXLCGData8ProviderReleaseDataCallback);
+    if (!provider) {
+        delete dataWrapper;
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate required provider" }];
+        return nullptr;
+    }
+    size_t stride = components * xSize * JXLBitsPerComponent(dataType) / 8;
+    return JXLCreatePlatformImage(provider, xSize, ySize, stride, components, dataType, premultiplied,
+                                  color, scale, error);
+}
+
+static NSError * _Nonnull JXLDecodingError(JXLInputStreamByteSource& source, NSString * _Nonnull message) {
+    NSError* streamError = source.failure();
+    if (streamError) {
+        return streamError;
+    }
+    return [[NSError alloc] initWithDomain:@"JXLCoder"
+                                      code:500
+                                  userInfo:@{ NSLocalizedDescriptionKey: message }];
+}
+
+/**
+ * Decodes at full resolution straight into the memory CoreGraphics will own, without zero filling or copying it
+ */
+static JXLSystemImage * _Nullable JXLDecodeFullImage(JXLInputStreamByteSource& source,
+                                                     JxlDecodingPixelFormat pixelFormat,
+                                                     bool premultiplied,
+                                                     jxlcoder::JxlBoxCollector* boxes,
+                                                     JxlTargetColorSpace colorSpace,
+                                                     int scale,
+                                                     NSError * _Nullable * _Nullable error) {
+    JxlColorDescription color;
+    size_t xSize, ySize;
+    bool use16BitImage;
+    int depth;
+    int components;
+    uint8_t* pixels = nullptr;
+    size_t pixelsStride = 0;
+    auto provider = [&pixels, &pixelsStride](size_t width, size_t height, size_t rowBytes,
+                                             size_t* rowStride, size_t* bufferSize) -> uint8_t* {
+        // CoreGraphics and Accelerate work faster on 64 byte aligned rows
+        *rowStride = (rowBytes + 63) & ~size_t(63);
+        *bufferSize = *rowStride * height;
+        pixels = static_cast<uint8_t*>(malloc(*bufferSize));
+        pixelsStride = *rowStride;
+        return pixels;
+    };
+    JxlDecodeOptions options;
+    options.premultiplyAlpha = premultiplied;
+    options.boxes = boxes;
+    options.colorSpace = colorSpace;
+    bool decoded = DecodeJpegXlIntoBuffer(source, provider, &xSize, &ySize,
+                                          &color, &depth, &components,
+                                          &use16BitImage, pixelFormat, options);
+    if (!decoded) {
+        free(pixels);
+        *error = JXLDecodingError(source, @"Failed to decode JXL image");
+        return nil;
+    }
+    CGDataProviderRef dataProvider = CGDataProviderCreateWithData(pixels, pixels,
+                                                                  pixelsStride * ySize,
+                                                                  JXLCGDataMallocProviderReleaseDataCallback);
+    if (!dataProvider) {
+        free(pixels);
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate required provider" }];
+        return nil;
+    }
+    return JXLCreatePlatformImage(dataProvider, xSize, ySize, pixelsStride,
+                                  components, JXLOutputDataType(pixelFormat, use16BitImage),
+                                  premultiplied, color, scale, error);
+}
+
+@interface JXLMetadataBox ()
+- (nonnull instancetype)initWith:(jxlcoder::JxlMetadataBox&)box;
+@end
+
+@implementation JXLMetadataBox
+- (nonnull instancetype)initWith:(jxlcoder::JxlMetadataBox&)box {
+    self = [super init];
+    if (self) {
+        _type = [[NSString alloc] initWithBytes:box.type.data() length:box.type.size() encoding:NSASCIIStringEncoding];
+        _compressed = box.compressed;
+        // The vector is handed over to NSData without copying
+        auto wrapper = new JXLDataWrapper<uint8_t>();
+        wrapper->data = std::move(box.data);
+        _data = [[NSData alloc] initWithBytesNoCopy:wrapper->data.data()
+                                             length:wrapper->data.size()
+                                        deallocator:^(void * _Nonnull bytes, NSUInteger length) {
+            delete wrapper;
+        }];
+    }
+    return self;
+}
+@end
+
+static NSArray<JXLMetadataBox *> * _Nonnull JXLMetadataBoxes(jxlcoder::JxlBoxCollector& collector) {
+    NSMutableArray<JXLMetadataBox *>* boxes = [[NSMutableArray alloc] initWithCapacity:collector.boxes().size()];
+    for (auto& box : collector.boxes()) {
+        [boxes addObject:[[JXLMetadataBox alloc] initWith:box]];
+    }
+    return boxes;
+}
+
+@interface JXLImageDescriptor ()
+- (nonnull instancetype)initWith:(const JxlImageDescriptor&)descriptor;
+@end
+
+@implementation JXLImageDescriptor
+- (nonnull instancetype)initWith:(const JxlImageDescriptor&)descriptor {
+    self = [super init];
+    if (self) {
+        _size = CGSizeMake(descriptor.width, descriptor.height);
+        _bitsPerSample = (int)descriptor.bitsPerSample;
+        _isFloat = descriptor.isFloat;
+        _colorChannels = (int)descriptor.colorChannels;
+        _hasAlpha = descriptor.hasAlpha;
+        _alphaPremultiplied = descriptor.alphaPremultiplied;
+        _orientation = (int)descriptor.orientation;
+        _hasAnimation = descriptor.hasAnimation;
+        _frameCountHint = (int)descriptor.frameCountHint;
+        _loopCount = (int)descriptor.animationLoops;
+        _hasColorEncoding = descriptor.hasColorEncoding;
+        _iccProfileSize = descriptor.iccProfileSize;
+        _hasPreview = descriptor.hasPreview;
+        _previewSize = CGSizeMake(descriptor.previewWidth, descriptor.previewHeight);
+    }
+    return self;
+}
+@end
+
+/**
+ * Extracts pixels with full fidelity and encodes them with metadata into the sink
+ */
+static bool JXLEncodeHDRImage(JXLSystemImage * _Nonnull platformImage,
+                              NSData * _Nullable exifData,
+                              NSData * _Nullable xmpData,
+                              JXLCompressionOption compressionOption,
+                              int effort,
+                              float distance,
+                              JXLEncoderDecodingSpeed decodingSpeed,
+                              bool embedPreview,
+                              bool chunked,
+                              jxlcoder::JxlOutputSink& output,
+                              NSError * _Nullable * _Nullable error) {
+    if (distance < 0.0f || distance > 25.0f) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+            userInfo:@{ NSLocalizedDescriptionKey: @"Distance must be in range 0.0...25.0" }];
+        return false;
+    }
+
+    if (effort < 1 || effort > 9) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+            userInfo:@{ NSLocalizedDescriptionKey: @"Effort must be clamped in 1...9" }];
+        return false;
+    }
+
+    std::vector<uint8_t> pixels;
+    std::unique_ptr<jxlcoder::JxlPixelSource> source;
+    std::vector<uint8_t> iccProfile;
+    JXLImageInfo info;
+
+    // Extract pixels with full fidelity - preserves HDR data.
+    // Chunked encoding converts them only as the encoder reaches each group
+    bool extracted = chunked ?
+        [platformImage jxlPixelSource:source iccProfile:iccProfile info:&info] :
+        [platformImage jxlExtractPixels:pixels iccProfile:iccProfile info:&info];
+    if (!extracted) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+            userInfo:@{ NSLocalizedDescriptionKey: @"Failed to extract pixel data from image" }];
+        return false;
+    }
+
+    if (info.width <= 0 || info.height <= 0) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+            userInfo:@{ NSLocalizedDescriptionKey: @"Width and height must be > 0" }];
+        return false;
+    }
+
+    // Convert NSData to std::vector for metadata
+    std::vector<uint8_t> exifVector;
+    std::vector<uint8_t> xmpVector;
+
+    if (exifData && exifData.length > 0) {
+        const uint8_t* exifBytes = static_cast<const uint8_t*>(exifData.bytes);
+        exifVector.assign(exifBytes, exifBytes + exifData.length);
+    }
+
+    if (xmpData && xmpData.length > 0) {
+        const uint8_t* xmpBytes = static_cast<const uint8_t*>(xmpData.bytes);
+        xmpVector.assign(xmpBytes, xmpBytes + xmpData.length);
+    }
+
+    // Determine number of channels from bits per pixel / bits per component
+    int numChannels = info.bitsPerPixel / info.bitsPerComponent;
+
+    bool success;
+    if (chunked) {
+        success = EncodeJxlHDRChunked(
+            *source,
+            info.width, info.height,
+            output,
+            numChannels,
+            info.bitsPerComponent,
+            info.originalBitsPerComponent,
+            info.isFloat,
+            iccProfile.empty() ? nullptr : &iccProfile,
+            static_cast<JxlTransferFunctionType>(info.transferFunction),
+            static_cast<JxlColorPrimariesType>(info.colorPrimaries),
+            toJxlCompressionOption(compressionOption),
+            distance,
+            effort,
+            (int)decodingSpeed,
+            exifVector.empty() ? nullptr : &exifVector,
+            xmpVector.empty() ? nullptr : &xmpVector
+        );
+    } else {
+        success = EncodeJxlHDR(
+            pixels,
+            info.width, info.height,
+            output,
+            numChannels,
+            info.bitsPerComponent,         // Container size (8, 16, 32)
+            info.originalBitsPerComponent, // Original precision (e.g., 10 for better compression)
+            info.isFloat,
+            iccProfile.empty() ? nullptr : &iccProfile,
+            static_cast<JxlTransferFunctionType>(info.transferFunction),
+            static_cast<JxlColorPrimariesType>(info.colorPrimaries),
+            toJxlCompressionOption(compressionOption),
+            distance,
+            effort,
+            (int)decodingSpeed,
+            exifVector.empty() ? nullptr : &exifVector,
+            xmpVector.empty() ? nullptr : &xmpVector,
+            runnerNormal,
+            embedPreview
+        );
+    }
+
+    if (!success) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+            userInfo:@{ NSLocalizedDescriptionKey: @"JXL HDR encoding failed" }];
+        return false;
+    }
+    return true;
+}
+
+static bool JXLEncodeHDRImage(JXLSystemImage * _Nonnull platformImage,
+                              NSData * _Nullable exifData,
+                              NSData * _Nullable xmpData,
+                              JXLCompressionOption compressionOption,
+                              int effort,
+                              float distance,
+                              JXLEncoderDecodingSpeed decodingSpeed,
+                              bool embedPreview,
+                              bool chunked,
+                              NSOutputStream * _Nonnull outputStream,
+                              NSError * _Nullable * _Nullable error) {
+    try {
+        [outputStream open];
+        if ([outputStream streamStatus] != NSStreamStatusOpen) {
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot open output stream" }];
+            return false;
+        }
+        // Compressed bytes are written out while they are produced, the file is never held in memory
+        JXLOutputStreamSink output(outputStream);
+        bool encoded = JXLEncodeHDRImage(platformImage, exifData, xmpData, compressionOption, effort, distance,
+                                         decodingSpeed, embedPreview, chunked, output, error);
+        [outputStream close];
+        if (!encoded) {
+            NSError* streamError = output.failure();
+            if (streamError) {
+                *error = streamError;
+            }
+            return false;
+        }
+        return true;
+    } catch (std::bad_alloc &err) {
+        [outputStream close];
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey:
+                    [NSString stringWithFormat:@"Encoding HDR image memory error: %s", err.what()] }];
+        return false;
+    }
+}
+
 @implementation JxlInternalCoder
+- (nullable JXLImageDescriptor *)probe:(nonnull NSData *)data
+                           neededBytes:(nonnull NSInteger *)neededBytes {
+    JxlImageDescriptor descriptor;
+    size_t needed = 0;
+    if (!ProbeJpegXl(reinterpret_cast<const uint8_t*>(data.bytes), data.length, &descriptor, &needed)) {
+        *neededBytes = (NSInteger)needed;
+        return nil;
+    }
+    *neededBytes = 0;
+    return [[JXLImageDescriptor alloc] initWith:descriptor];
+}
+
 - (nullable NSData *)encode:(nonnull JXLSystemImage *)platformImage
                  colorSpace:(JXLColorSpace)colorSpace
           compressionOption:(JXLCompressionOption)compressionOption
@@ -143,43 +642,23 @@ static inline JxlCompressionOption toJxlCompressionOption(JXLCompressionOption o
 
 - (CGSize)getSize:(nonnull NSInputStream *)inputStream error:(NSError *_Nullable * _Nullable)error {
     try {
-        int bufferLength = 30196;
-        std::vector<uint8_t> buffer;
-        buffer.resize(bufferLength);
-        std::vector<uint8_t> imageData;
         [inputStream open];
-        if ([inputStream streamStatus] == NSStreamStatusOpen) {
-
-            while ([inputStream hasBytesAvailable]) {
-                NSInteger bytesRead = [inputStream read:buffer.data() maxLength:bufferLength];
-                if (bytesRead > 0) {
-                    imageData.insert(imageData.end(), buffer.begin(), buffer.begin() + bytesRead);
-                } else if (bytesRead < 0) {
-                    auto streamError = [inputStream streamError];
-                    if (streamError) {
-                        *error = [inputStream streamError];
-                    } else {
-                        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
-                                                            code:500
-                                                        userInfo:@{ NSLocalizedDescriptionKey: @"Stream reading has failed" }];
-                    }
-                    [inputStream close];
-                    return CGSizeZero;
-                } else {
-                    // End of stream
-                    break;
-                }
-            }
-
-            [inputStream close];
-        } else {
+        if ([inputStream streamStatus] != NSStreamStatusOpen) {
             *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot open input stream" }];
             return CGSizeZero;
         }
 
+        JXLInputStreamByteSource source(inputStream);
         size_t width, height;
-        if (!DecodeBasicInfo(imageData.data(), imageData.size(), &width, &height)) {
-            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot decode image info" }];
+        bool decoded = DecodeBasicInfo(source, &width, &height);
+        [inputStream close];
+        if (!decoded) {
+            NSError* streamError = source.failure();
+            if (streamError) {
+                *error = streamError;
+            } else {
+                *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot decode image info" }];
+            }
             return CGSizeZero;
         }
 
@@ -193,95 +672,49 @@ static inline JxlCompressionOption toJxlCompressionOption(JXLCompressionOption o
 - (nullable JXLSystemImage *)decode:(nonnull NSInputStream *)inputStream
                             rescale:(CGSize)rescale
                         pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+                      premultiplied:(bool)premultiplied
                               scale:(int)scale
                               error:(NSError *_Nullable * _Nullable)error {
     try {
-        int bufferLength = 30196;
-        std::vector<uint8_t> buffer;
-        buffer.resize(bufferLength);
-        std::vector<uint8_t> imageData;
         [inputStream open];
-        if ([inputStream streamStatus] == NSStreamStatusOpen) {
-
-            while ([inputStream hasBytesAvailable]) {
-                NSInteger bytesRead = [inputStream read:buffer.data() maxLength:bufferLength];
-                if (bytesRead > 0) {
-                    imageData.insert(imageData.end(), buffer.begin(), buffer.begin() + bytesRead);
-                } else if (bytesRead < 0) {
-                    auto streamError = [inputStream streamError];
-                    if (streamError) {
-                        *error = [inputStream streamError];
-                    } else {
-                        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
-                                                            code:500
-                                                        userInfo:@{ NSLocalizedDescriptionKey: @"Stream reading has failed" }];
-                    }
-                    [inputStream close];
-                    return nil;
-                } else {
-                    // End of stream
-                    break;
-                }
-            }
-
-            [inputStream close];
-
-            // Now you have the contents in the 'buffer' vector
-        } else {
+        if ([inputStream streamStatus] != NSStreamStatusOpen) {
             *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot open input stream" }];
             return nil;
         }
 
-        if (!isJXL(imageData)) {
-            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Not an JXL image" }];
-            return nil;
-        }
-
-        std::vector<uint8_t> iccProfile;
+        JxlColorDescription color;
         size_t xSize, ySize;
         bool use16BitImage;
         int depth;
         std::vector<uint8_t> outputData;
         int components;
-        JxlExposedOrientation jxlExposedOrientation = Identity;
-        JxlDecodingPixelFormat pixelFormat;
-        switch (preferredPixelFormat) {
-            case kOptimal:
-                pixelFormat = optimal;
-                break;
-            case kR8:
-                pixelFormat = r8;
-                break;
-            case kR16:
-                pixelFormat = r16;
-                break;
+        JxlDecodingPixelFormat pixelFormat = JXLDecodingPixelFormat(preferredPixelFormat);
+        // Compressed bytes are streamed into the decoder, so the file is never held in memory as a whole
+        JXLInputStreamByteSource source(inputStream);
+        bool rescaling = rescale.width > 0 && rescale.height > 0;
+        if (!rescaling) {
+            JXLSystemImage* image = JXLDecodeFullImage(source, pixelFormat, premultiplied, nullptr,
+                                                       colorSpaceOriginal, scale, error);
+            [inputStream close];
+            return image;
         }
-        auto decoded = DecodeJpegXlOneShot(imageData.data(), imageData.size(),
-                                           &outputData, &xSize, &ySize,
-                                           &iccProfile, &depth, &components,
-                                           &use16BitImage, &jxlExposedOrientation,
-                                           pixelFormat);
+        // Stops at the DC or pass level that still covers the requested size, dimensions come out oriented
+        bool decoded = DecodeJpegXlThumbnail(source, (size_t)rescale.width, (size_t)rescale.height,
+                                             &outputData, &xSize, &ySize,
+                                             &color, &depth, &components,
+                                             &use16BitImage, pixelFormat);
+        [inputStream close];
         if (!decoded) {
-            *error = [[NSError alloc] initWithDomain:@"JXLCoder" 
-                                                code:500
-                                            userInfo:@{ NSLocalizedDescriptionKey: @"Failed to decode JXL image" }];
+            *error = JXLDecodingError(source, @"Failed to decode JXL image");
             return nil;
         }
 
-        imageData.clear();
-
-        if (jxlExposedOrientation == Rotate90CW || jxlExposedOrientation == Rotate90CCW
-            || jxlExposedOrientation == AntiTranspose
-            || jxlExposedOrientation == OrientTranspose) {
-            size_t xz = xSize;
-            xSize = ySize;
-            ySize = xz;
-        }
-
-        if (rescale.width > 0 && rescale.height > 0) {
+        // Finish the remaining small resample
+        if (xSize != (size_t)rescale.width || ySize != (size_t)rescale.height) {
             auto scaleResult = [RgbaScaler scaleData:outputData width:(int)xSize height:(int)ySize
                                             newWidth:(int)rescale.width newHeight:(int)rescale.height
-                                          components:components pixelFormat:use16BitImage ? kF16 : kU8];
+                                          components:components
+                                         pixelFormat:JXLScalerPixelFormat(JXLOutputDataType(pixelFormat, use16BitImage))];
             if (!scaleResult) {
                 *error = [[NSError alloc] initWithDomain:@"JXLCoder" 
                                                     code:500
@@ -292,90 +725,233 @@ static inline JxlCompressionOption toJxlCompressionOption(JXLCompressionOption o
             ySize = rescale.height;
         }
 
-        CGColorSpaceRef colorSpace;
-        if (iccProfile.size() > 0) {
-            CFDataRef iccData = CFDataCreate(kCFAllocatorDefault, iccProfile.data(), iccProfile.size());
-            colorSpace = CGColorSpaceCreateWithICCData(iccData);
-            CFRelease(iccData);
-        } else {
-            if (components > 1) {
-                colorSpace = CGColorSpaceCreateDeviceRGB();
-            } else {
-                colorSpace = CGColorSpaceCreateDeviceGray();
-            }
+        // Thumbnails keep straight alpha, the image is flagged accordingly
+        return JXLCreatePlatformImage(outputData, xSize, ySize, components,
+                                      JXLOutputDataType(pixelFormat, use16BitImage), false,
+                                      color, scale, error);
+    } catch (std::bad_alloc &err) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Decoding image memory error: %s", err.what()] }];
+        return nullptr;
+    }
+}
+
+- (nullable JXLSystemImage *)preview:(nonnull NSInputStream *)inputStream
+                         minimumSize:(CGSize)minimumSize
+                         pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+                               scale:(int)scale
+                               error:(NSError *_Nullable * _Nullable)error {
+    try {
+        [inputStream open];
+        if ([inputStream streamStatus] != NSStreamStatusOpen) {
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot open input stream" }];
+            return nil;
         }
 
-        if (!colorSpace) {
-            if (components > 1) {
-                colorSpace = CGColorSpaceCreateDeviceRGB();
-            } else {
-                colorSpace = CGColorSpaceCreateDeviceGray();
-            }
+        JxlColorDescription color;
+        size_t xSize, ySize;
+        bool use16BitImage;
+        int depth;
+        std::vector<uint8_t> outputData;
+        int components;
+        JxlDecodingPixelFormat pixelFormat = JXLDecodingPixelFormat(preferredPixelFormat);
+        JXLInputStreamByteSource source(inputStream);
+        JxlDecodeOptions options;
+        options.preferPreview = true;
+        bool decoded = DecodeJpegXlThumbnail(source,
+                                             (size_t)std::max(minimumSize.width, 0.0),
+                                             (size_t)std::max(minimumSize.height, 0.0),
+                                             &outputData, &xSize, &ySize,
+                                             &color, &depth, &components,
+                                             &use16BitImage, pixelFormat, options);
+        [inputStream close];
+        if (!decoded) {
+            *error = JXLDecodingError(source, @"Failed to decode JXL image");
+            return nil;
         }
 
-        int stride = components*(int)xSize * (int)(use16BitImage ? sizeof(uint16_t) : sizeof(uint8_t));
+        return JXLCreatePlatformImage(outputData, xSize, ySize, components,
+                                      JXLOutputDataType(pixelFormat, use16BitImage), false,
+                                      color, scale, error);
+    } catch (std::bad_alloc &err) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Decoding image memory error: %s", err.what()] }];
+        return nil;
+    }
+}
 
-        int flags;
-        if (use16BitImage) {
-            flags = (int)kCGBitmapByteOrder16Host;
-            if (components == 4) {
-                flags |= (int)kCGImageAlphaLast;
-            } else {
-                flags |= (int)kCGImageAlphaNone;
-            }
-        } else {
-            flags = (int)kCGImageByteOrderDefault;
-            if (components == 4) {
-                flags |= (int)kCGImageAlphaLast;
-            } else {
-                flags |= (int)kCGImageAlphaNone;
-            }
+- (nullable JXLSystemImage *)decode:(nonnull NSInputStream *)inputStream
+                             region:(CGRect)region
+                        pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+                              scale:(int)scale
+                              error:(NSError *_Nullable * _Nullable)error {
+    try {
+        if (region.origin.x < 0 || region.origin.y < 0 || region.size.width < 1 || region.size.height < 1) {
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Region must be non-empty and start inside the image" }];
+            return nil;
         }
 
-        auto dataWrapper = new JXLDataWrapper<uint8_t>();
-        dataWrapper->data = outputData;
+        [inputStream open];
+        if ([inputStream streamStatus] != NSStreamStatusOpen) {
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot open input stream" }];
+            return nil;
+        }
 
-        CGDataProviderRef provider = CGDataProviderCreateWithData(dataWrapper,
-                                                                  dataWrapper->data.data(),
-                                                                  dataWrapper->data.size(),
-                                                                  JXLCGData8ProviderReleaseDataCallback);
-        if (!provider) {
-            delete dataWrapper;
-            *error = [[NSError alloc] initWithDomain:@"JXLCoder"
-                                                code:500
-                                            userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate required provider" }];
-            return nullptr;
+        JxlColorDescription color;
+        bool use16BitImage;
+        int depth;
+        std::vector<uint8_t> outputData;
+        int components;
+        JxlDecodingPixelFormat pixelFormat = JXLDecodingPixelFormat(preferredPixelFormat);
+        size_t regionX = (size_t)region.origin.x;
+        size_t regionY = (size_t)region.origin.y;
+        size_t regionWidth = (size_t)region.size.width;
+        size_t regionHeight = (size_t)region.size.height;
+
+        JXLInputStreamByteSource source(inputStream);
+        auto decoded = DecodeJpegXlRegion(source, regionX, regionY, regionWidth, regionHeight,
+                                          &outputData, &color, &depth, &components,
+                                          &use16BitImage, pixelFormat);
+        [inputStream close];
+        if (!decoded) {
+            NSError* streamError = source.failure();
+            if (streamError) {
+                *error = streamError;
+            } else {
+                *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                                    code:500
+                                                userInfo:@{ NSLocalizedDescriptionKey: @"Failed to decode JXL image region, check that it fits into the image" }];
+            }
+            return nil;
         }
 
-        int bitsPerComponent = (use16BitImage ? sizeof(uint16_t) : sizeof(uint8_t)) * 8;
-        int bitsPerPixel = bitsPerComponent*components;
+        return JXLCreatePlatformImage(outputData, regionWidth, regionHeight, components,
+                                      JXLOutputDataType(pixelFormat, use16BitImage), false,
+                                      color, scale, error);
+    } catch (std::bad_alloc &err) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Decoding image memory error: %s", err.what()] }];
+        return nullptr;
+    }
+}
 
-        CGImageRef imageRef = CGImageCreate(xSize, ySize, bitsPerComponent,
-                                            bitsPerPixel,
-                                            stride,
-                                            colorSpace, flags, provider, NULL, false, kCGRenderingIntentDefault);
-        if (!imageRef) {
-            *error = [[NSError alloc] initWithDomain:@"JXLCoder"
-                                                code:500
-                                            userInfo:@{ NSLocalizedDescriptionKey: @"CoreGraphics cannot allocate CGImageRef" }];
-            return nullptr;
+- (nullable JXLSystemImage *)decode:(nonnull NSInputStream *)inputStream
+                         colorSpace:(JXLTargetColorSpace)colorSpace
+                        pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+                      premultiplied:(bool)premultiplied
+                              scale:(int)scale
+                              error:(NSError *_Nullable * _Nullable)error {
+    try {
+        [inputStream open];
+        if ([inputStream streamStatus] != NSStreamStatusOpen) {
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot open input stream" }];
+            return nil;
         }
-        JXLSystemImage *image = nil;
-#if JXL_PLUGIN_MAC
-        image = [[NSImage alloc] initWithCGImage:imageRef size:CGSizeZero];
-#else
-        image = [UIImage imageWithCGImage:imageRef scale:scale orientation:UIImageOrientationUp];
-#endif
+        JXLInputStreamByteSource source(inputStream);
+        JXLSystemImage* image = JXLDecodeFullImage(source, JXLDecodingPixelFormat(preferredPixelFormat),
+                                                   premultiplied, nullptr, JXLOutputColorSpace(colorSpace),
+                                                   scale, error);
+        [inputStream close];
+        return image;
+    } catch (std::bad_alloc &err) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Decoding image memory error: %s", err.what()] }];
+        return nil;
+    }
+}
 
+- (nullable JXLSystemImage *)decode:(nonnull NSInputStream *)inputStream
+                        pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+                      premultiplied:(bool)premultiplied
+                              scale:(int)scale
+                              boxes:(NSArray<JXLMetadataBox *> *_Nullable * _Nonnull)boxes
+                              error:(NSError *_Nullable * _Nullable)error {
+    try {
+        [inputStream open];
+        if ([inputStream streamStatus] != NSStreamStatusOpen) {
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot open input stream" }];
+            return nil;
+        }
+        JXLInputStreamByteSource source(inputStream);
+        jxlcoder::JxlBoxCollector collector;
+        JXLSystemImage* image = JXLDecodeFullImage(source, JXLDecodingPixelFormat(preferredPixelFormat),
+                                                   premultiplied, &collector, colorSpaceOriginal, scale, error);
+        [inputStream close];
+        if (image) {
+            *boxes = JXLMetadataBoxes(collector);
+        }
         return image;
     } catch (std::bad_alloc &err) {
         *error = [[NSError alloc] initWithDomain:@"JXLCoder"
                                             code:500
                                         userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Decoding image memory error: %s", err.what()] }];
-        return nullptr;
+        return nil;
     }
 }
 
+- (nullable NSArray<JXLMetadataBox *> *)boxes:(nonnull NSInputStream *)inputStream
+                                        error:(NSError *_Nullable * _Nullable)error {
+    try {
+        [inputStream open];
+        if ([inputStream streamStatus] != NSStreamStatusOpen) {
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500 userInfo:@{ NSLocalizedDescriptionKey: @"Cannot open input stream" }];
+            return nil;
+        }
+        JXLInputStreamByteSource source(inputStream);
+        jxlcoder::JxlBoxCollector collector(jxlcoder::JxlBoxCollector::all);
+        bool decoded = DecodeJpegXlBoxes(source, collector);
+        [inputStream close];
+        if (!decoded) {
+            *error = JXLDecodingError(source, @"Failed to read JXL boxes");
+            return nil;
+        }
+        return JXLMetadataBoxes(collector);
+    } catch (std::bad_alloc &err) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Reading boxes memory error: %s", err.what()] }];
+        return nil;
+    }
+}
+
+- (void)decodeBatch:(nonnull NSArray<NSData *> *)images
+        pixelFormat:(JXLPreferredPixelFormat)preferredPixelFormat
+      premultiplied:(bool)premultiplied
+              scale:(int)scale
+         completion:(nonnull JXLBatchCompletion)completion {
+    std::vector<jxlcoder::JxlBatchInput> inputs;
+    inputs.reserve([images count]);
+    for (NSData* data in images) {
+        inputs.push_back({ reinterpret_cast<const uint8_t*>([data bytes]), (size_t)[data length] });
+    }
+    jxlcoder::JxlBatchOptions options;
+    options.pixelFormat = JXLDecodingPixelFormat(preferredPixelFormat);
+    options.premultiplyAlpha = premultiplied;
+
+    // NSData keeps the bytes alive, images is retained until this returns
+    jxlcoder::DecodeJpegXlBatch(inputs, options, [&](jxlcoder::JxlBatchResult& result) {
+        @autoreleasepool {
+            if (!result.success) {
+                NSError* error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                                            code:500
+                                                        userInfo:@{ NSLocalizedDescriptionKey: @"Failed to decode JXL image" }];
+                completion((NSInteger)result.index, nil, error);
+                return;
+            }
+            NSError* error = nil;
+            JXLSystemImage* image = JXLCreatePlatformImage(result.pixels, result.xsize, result.ysize,
+                                                           result.components,
+                                                           JXLOutputDataType(options.pixelFormat, result.useFloats),
+                                                           premultiplied, result.color, scale, &error);
+            completion((NSInteger)result.index, image, image ? nil : error);
+        }
+    });
+}
+
 - (nullable NSData *)encodeHDR:(nonnull JXLSystemImage *)platformImage
              compressionOption:(JXLCompressionOption)compressionOption
                         effort:(int)effort
@@ -468,25 +1044,106 @@ static inline JxlCompressionOption toJxlCompressionOption(JXLCompressionOption o
                         effort:(int)effort
                       distance:(float)distance
                  decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+                  embedPreview:(bool)embedPreview
                          error:(NSError * _Nullable *_Nullable)error {
     try {
-        if (distance < 0.0f || distance > 25.0f) {
-            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
-                userInfo:@{ NSLocalizedDescriptionKey: @"Distance must be in range 0.0...25.0" }];
+        std::unique_ptr<JXLDataWrapper<uint8_t>> wrapper = std::make_unique<JXLDataWrapper<uint8_t>>();
+        jxlcoder::JxlVectorOutputSink output(wrapper->data);
+        if (!JXLEncodeHDRImage(platformImage, exifData, xmpData, compressionOption, effort, distance,
+                               decodingSpeed, embedPreview, false, output, error)) {
             return nil;
         }
 
-        if (effort < 1 || effort > 9) {
+        JXLDataWrapper<uint8_t>* owner = wrapper.release();
+        auto data = [[NSData alloc] initWithBytesNoCopy:owner->data.data()
+                                                 length:owner->data.size()
+                                            deallocator:^(void * _Nonnull bytes, NSUInteger length) {
+            delete owner;
+        }];
+
+        return data;
+
+    } catch (std::bad_alloc &err) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                            code:500
+                                        userInfo:@{ NSLocalizedDescriptionKey:
+                    [NSString stringWithFormat:@"Encoding HDR image memory error: %s", err.what()] }];
+        return nil;
+    }
+}
+
+- (BOOL)encodeHDR:(nonnull JXLSystemImage *)platformImage
+         exifData:(nullable NSData *)exifData
+          xmpData:(nullable NSData *)xmpData
+compressionOption:(JXLCompressionOption)compressionOption
+           effort:(int)effort
+         distance:(float)distance
+    decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+     embedPreview:(bool)embedPreview
+     outputStream:(nonnull NSOutputStream *)outputStream
+            error:(NSError * _Nullable *_Nullable)error {
+    return JXLEncodeHDRImage(platformImage, exifData, xmpData, compressionOption, effort, distance,
+                             decodingSpeed, embedPreview, false, outputStream, error);
+}
+
+- (BOOL)encodeHDRChunked:(nonnull JXLSystemImage *)platformImage
+                exifData:(nullable NSData *)exifData
+                 xmpData:(nullable NSData *)xmpData
+       compressionOption:(JXLCompressionOption)compressionOption
+                  effort:(int)effort
+                distance:(float)distance
+           decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+            outputStream:(nonnull NSOutputStream *)outputStream
+                   error:(NSError * _Nullable *_Nullable)error {
+    return JXLEncodeHDRImage(platformImage, exifData, xmpData, compressionOption, effort, distance,
+                             decodingSpeed, false, true, outputStream, error);
+}
+
+- (nullable NSData *)encodeHDR:(nonnull JXLSystemImage *)platformImage
+                      exifData:(nullable NSData *)exifData
+                       xmpData:(nullable NSData *)xmpData
+                    rateTarget:(JXLRateTarget)rateTarget
+                   targetValue:(double)targetValue
+                        effort:(int)effort
+                 decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+                     maxTrials:(int)maxTrials
+                         error:(NSError * _Nullable *_Nullable)error {
+    if (effort < 1 || effort > 9) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+            userInfo:@{ NSLocalizedDescriptionKey: @"Effort must be clamped in 1...9" }];
+        return nil;
+    }
+
+    if (maxTrials < 2) {
+        *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+            userInfo:@{ NSLocalizedDescriptionKey: @"Rate control needs at least 2 trials" }];
+        return nil;
+    }
+
+    jxlcoder::JxlRateControl control;
+    control.maxTrials = maxTrials;
+    if (rateTarget == kRateTargetFileSize) {
+        if (targetValue < 1) {
             *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
-                userInfo:@{ NSLocalizedDescriptionKey: @"Effort must be clamped in 1...9" }];
+                userInfo:@{ NSLocalizedDescriptionKey: @"Target file size must be at least 1 byte" }];
             return nil;
         }
+        control.target = rateTargetSize;
+        control.targetBytes = static_cast<uint64_t>(targetValue);
+    } else {
+        if (targetValue <= 0 || targetValue > 1) {
+            *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+                userInfo:@{ NSLocalizedDescriptionKey: @"Target SSIM must be in range 0...1" }];
+            return nil;
+        }
+        control.target = rateTargetSSIM;
+        control.targetScore = static_cast<float>(targetValue);
+    }
 
+    try {
         std::vector<uint8_t> pixels;
         std::vector<uint8_t> iccProfile;
         JXLImageInfo info;
-
-        // Extract pixels with full fidelity - preserves HDR data
         if (![platformImage jxlExtractPixels:pixels iccProfile:iccProfile info:&info]) {
             *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
                 userInfo:@{ NSLocalizedDescriptionKey: @"Failed to extract pixel data from image" }];
@@ -499,62 +1156,46 @@ static inline JxlCompressionOption toJxlCompressionOption(JXLCompressionOption o
             return nil;
         }
 
-        // Convert NSData to std::vector for metadata
         std::vector<uint8_t> exifVector;
         std::vector<uint8_t> xmpVector;
-
         if (exifData && exifData.length > 0) {
             const uint8_t* exifBytes = static_cast<const uint8_t*>(exifData.bytes);
             exifVector.assign(exifBytes, exifBytes + exifData.length);
         }
-
         if (xmpData && xmpData.length > 0) {
             const uint8_t* xmpBytes = static_cast<const uint8_t*>(xmpData.bytes);
             xmpVector.assign(xmpBytes, xmpBytes + xmpData.length);
         }
 
-        // Determine number of channels from bits per pixel / bits per component
-        int numChannels = info.bitsPerPixel / info.bitsPerComponent;
-
-        JXLDataWrapper<uint8_t>* wrapper = new JXLDataWrapper<uint8_t>();
-
-        bool success = EncodeJxlHDR(
-            pixels,
-            info.width, info.height,
-            &wrapper->data,
-            numChannels,
-            info.bitsPerComponent,         // Container size (8, 16, 32)
-            info.originalBitsPerComponent, // Original precision (e.g., 10 for better compression)
-            info.isFloat,
-            iccProfile.empty() ? nullptr : &iccProfile,
-            static_cast<JxlTransferFunctionType>(info.transferFunction),
-            static_cast<JxlColorPrimariesType>(info.colorPrimaries),
-            toJxlCompressionOption(compressionOption),
-            distance,
-            effort,
-            (int)decodingSpeed,
-            exifVector.empty() ? nullptr : &exifVector,
-            xmpVector.empty() ? nullptr : &xmpVector
-        );
-
-        if (!success) {
-            delete wrapper;
+        JxlEncoderProfile profile;
+        profile.numChannels = info.bitsPerPixel / info.bitsPerComponent;
+        profile.containerBitsPerSample = info.bitsPerComponent;
+        profile.originalBitsPerSample = info.originalBitsPerComponent;
+        profile.isFloat = info.isFloat;
+        profile.iccProfile = std::move(iccProfile);
+        profile.transferFunction = static_cast<JxlTransferFunctionType>(info.transferFunction);
+        profile.colorPrimaries = static_cast<JxlColorPrimariesType>(info.colorPrimaries);
+        profile.compressionOption = lossy;
+        profile.effort = effort;
+        profile.decodingSpeed = (int)decodingSpeed;
+
+        std::unique_ptr<JXLDataWrapper<uint8_t>> wrapper = std::make_unique<JXLDataWrapper<uint8_t>>();
+        jxlcoder::JxlVectorOutputSink output(wrapper->data);
+        jxlcoder::JxlRateControlResult result;
+        if (!jxlcoder::EncodeJxlHDRRateControlled(pixels, info.width, info.height, output, profile, control, &result,
+                                                  exifVector.empty() ? nullptr : &exifVector,
+                                                  xmpVector.empty() ? nullptr : &xmpVector)) {
             *error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
-                userInfo:@{ NSLocalizedDescriptionKey: @"JXL HDR encoding failed" }];
+                userInfo:@{ NSLocalizedDescriptionKey: @"JXL rate controlled encoding failed" }];
             return nil;
         }
 
-        pixels.clear();
-        pixels.shrink_to_fit();
-
-        auto data = [[NSData alloc] initWithBytesNoCopy:wrapper->data.data()
-                                                 length:wrapper->data.size()
-                                            deallocator:^(void * _Nonnull bytes, NSUInteger length) {
-            delete wrapper;
+        JXLDataWrapper<uint8_t>* owner = wrapper.release();
+        return [[NSData alloc] initWithBytesNoCopy:owner->data.data()
+                                            length:owner->data.size()
+                                       deallocator:^(void * _Nonnull bytes, NSUInteger length) {
+            delete owner;
         }];
-
-        return data;
-
     } catch (std::bad_alloc &err) {
         *error = [[NSError alloc] initWithDomain:@"JXLCoder"
                                             code:500
@@ -563,4 +1204,113 @@ static inline JxlCompressionOption toJxlCompressionOption(JXLCompressionOption o
         return nil;
     }
 }
+
+- (void)encodeHDRBatch:(nonnull NSArray<JXLSystemImage *> *)images
+              exifData:(nullable NSArray<NSData *> *)exifData
+               xmpData:(nullable NSArray<NSData *> *)xmpData
+     compressionOption:(JXLCompressionOption)compressionOption
+                effort:(int)effort
+              distance:(float)distance
+         decodingSpeed:(JXLEncoderDecodingSpeed)decodingSpeed
+            maxThreads:(NSInteger)maxThreads
+      maxInFlightBytes:(uint64_t)maxInFlightBytes
+            completion:(nonnull JXLBatchEncodeCompletion)completion {
+    NSString* invalid = nil;
+    if (distance < 0.0f || distance > 25.0f) {
+        invalid = @"Distance must be in range 0.0...25.0";
+    } else if (effort < 1 || effort > 9) {
+        invalid = @"Effort must be clamped in 1...9";
+    } else if ((exifData && [exifData count] != [images count]) || (xmpData && [xmpData count] != [images count])) {
+        invalid = @"Metadata must have one entry per image";
+    }
+    if (invalid) {
+        NSError* error = [[NSError alloc] initWithDomain:@"JXLCoder" code:500
+                                                userInfo:@{ NSLocalizedDescriptionKey: invalid }];
+        for (NSUInteger i = 0; i < [images count]; ++i) {
+            completion((NSInteger)i, nil, error);
+        }
+        return;
+    }
+
+    jxlcoder::JxlBatchEncodeOptions options;
+    options.maxThreads = maxThreads > 0 ? (size_t)maxThreads : 0;
+    if (maxInFlightBytes > 0) {
+        options.maxInFlightBytes = maxInFlightBytes;
+    }
+
+    // The copied source data and the extracted pixels are alive at the same time
+    auto estimate = [&](size_t index) -> uint64_t {
+        @autoreleasepool {
+            JXLImageInfo info;
+            if (![images[index] jxlGetImageInfo:&info]) {
+                return 0;
+            }
+            uint64_t pixels = (uint64_t)info.width * info.height;
+            uint64_t outputBytesPerPixel = info.isPacked10Bit ? 6 : info.bitsPerPixel / 8;
+            return pixels * (info.bitsPerPixel / 8 + outputBytesPerPixel);
+        }
+    };
+
+    auto prepare = [&](size_t index, jxlcoder::JxlBatchEncodeImage& image) -> bool {
+        @autoreleasepool {
+            std::vector<uint8_t> iccProfile;
+            JXLImageInfo info;
+            if (![images[index] jxlExtractPixels:image.pixels iccProfile:iccProfile info:&info] ||
+                info.width <= 0 || info.height <= 0) {
+                return false;
+            }
+            image.xsize = info.width;
+            image.ysize = info.height;
+
+            JxlEncoderProfile& profile = image.profile;
+            profile.numChannels = info.bitsPerPixel / info.bitsPerComponent;
+            profile.containerBitsPerSample = info.bitsPerComponent;
+            profile.originalBitsPerSample = info.originalBitsPerComponent;
+            profile.isFloat = info.isFloat;
+            profile.iccProfile = std::move(iccProfile);
+            profile.transferFunction = static_cast<JxlTransferFunctionType>(info.transferFunction);
+            profile.colorPrimaries = static_cast<JxlColorPrimariesType>(info.colorPrimaries);
+            profile.compressionOption = toJxlCompressionOption(compressionOption);
+            profile.distance = distance;
+            profile.effort = effort;
+            profile.decodingSpeed = (int)decodingSpeed;
+
+            if (exifData && exifData[index].length > 0) {
+                const uint8_t* exifBytes = static_cast<const uint8_t*>(exifData[index].bytes);
+                image.exif.assign(exifBytes, exifBytes + exifData[index].length);
+            }
+            if (xmpData && xmpData[index].length > 0) {
+                const uint8_t* xmpBytes = static_cast<const uint8_t*>(xmpData[index].bytes);
+                image.xmp.assign(xmpBytes, xmpBytes + xmpData[index].length);
+            }
+            return true;
+        }
+    };
+
+    // images and the metadata arrays are retained until this returns
+    jxlcoder::EncodeJxlHDRBatch([images count], options, estimate, prepare,
+                                [&](jxlcoder::JxlBatchEncodeResult& result) {
+        @autoreleasepool {
+            if (!result.success) {
+                NSError* error = [[NSError alloc] initWithDomain:@"JXLCoder"
+                                                            code:500
+                                                        userInfo:@{ NSLocalizedDescriptionKey: @"JXL HDR encoding failed" }];
+                completion((NSInteger)result.index, nil, error);
+                return;
+            }
+            JXLDataWrapper<uint8_t>* owner = new JXLDataWrapper<uint8_t>();
+            owner->data = std::move(result.compressed);
+            NSData* data = [[NSData alloc] initWithBytesNoCopy:owner->data.data()
+                                                        length:owner->data.size()
+                                                   deallocator:^(void * _Nonnull bytes, NSUInteger length) {
+                delete owner;
+            }];
+            completion((NSInteger)result.index, data, nil);
+        }
+    });
+}
+
++ (void)purgeCaches {
+    jxlcoder::JxlDecoderPool::shared().drain();
+}
 @end
@@ -30,20 +30,25 @@
 
 #include "jxl/decode.h"
 #include "jxl/decode_cxx.h"
-#include "jxl/resizable_parallel_runner.h"
-#include "jxl/resizable_parallel_runner_cxx.h"
+#include "JxlSharedRunner.hpp"
+#include "JxlMemoryArena.hpp"
 
 namespace jxlcoder {
 class JxlInverse {
 public:
-    JxlInverse(std::vector<uint8_t> &data) : jxlData(data) {
+    JxlInverse(std::vector<uint8_t> &data, JxlRunnerPriority priority = runnerNormal) : jxlData(data),
+    runner(priority) {
         
     }
     
     bool inverse() {
-        auto runner = JxlResizableParallelRunnerMake(nullptr);
-        
-        auto dec = JxlDecoderMake(nullptr);
+        // The object may be created long before it is used, cancellation is taken from whoever calls
+        runner.cancellation = JxlCancellationScope::current();
+        JxlScopedMemoryArena arena;
+        auto dec = JxlDecoderMake(arena.manager());
+        if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec.get(), JxlSharedParallelRunner, &runner)) {
+            return false;
+        }
         if (JXL_DEC_SUCCESS !=
             JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_JPEG_RECONSTRUCTION | JXL_DEC_FULL_IMAGE)) {
             return false;
@@ -67,6 +72,9 @@ public:
         size_t used = 0;
         JxlDecoderStatus decProcessResult = JXL_DEC_JPEG_NEED_MORE_OUTPUT;
         while (decProcessResult == JXL_DEC_JPEG_NEED_MORE_OUTPUT) {
+            if (runner.cancelled()) {
+                return false;
+            }
             size_t us = JxlDecoderReleaseJPEGBuffer(dec.get());
             used = jpegData.size() - us;
             jpegData.resize(jpegData.size() * 2);
@@ -93,6 +101,7 @@ public:
 private:
     std::vector<uint8_t> jxlData;
     std::vector<uint8_t> jpegData;
+    JxlSharedRunner runner;
 };
 }
 #endif
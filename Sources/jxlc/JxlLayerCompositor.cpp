@@ -0,0 +1,108 @@
+//
+//  JxlLayerCompositor.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#include "JxlLayerCompositor.hpp"
+#include "algo/blend.hpp"
+#include <algorithm>
+
+namespace jxlcoder {
+
+JxlLayerCompositor::JxlLayerCompositor(uint32_t width, uint32_t height, bool premultiplied)
+: width(width), height(height), premultiplied(premultiplied),
+  pixels(static_cast<size_t>(width) * height * 4, 0), canvasSlots(0), blank(true) {
+}
+
+JxlLayerRect JxlLayerCompositor::apply(const JxlLayer& layer) {
+    if (layer.blendSource > 3 || layer.saveAsReference > 3) {
+        std::string str = "Reference slot is out of range";
+        throw JxlCompositorError(str);
+    }
+    if (layer.pixels.size() != static_cast<size_t>(layer.width) * layer.height * 4) {
+        std::string str = "Layer pixels do not match its size";
+        throw JxlCompositorError(str);
+    }
+
+    JxlLayerRect dirty = { 0, 0, 0, 0 };
+    const uint32_t source = 1u << layer.blendSource;
+    if (blank && references[layer.blendSource].empty()) {
+        // Nothing was blended yet, the transparent canvas already is the empty reference
+        canvasSlots = source;
+    } else if (!(canvasSlots & source)) {
+        for (uint32_t slot = 0; slot < 4; ++slot) {
+            if (canvasSlots & (1u << slot)) {
+                references[slot] = pixels;
+            }
+        }
+        if (references[layer.blendSource].empty()) {
+            std::fill(pixels.begin(), pixels.end(), 0);
+        } else {
+            pixels.swap(references[layer.blendSource]);
+            references[layer.blendSource].clear();
+        }
+        canvasSlots = source;
+        dirty = { 0, 0, width, height };
+    }
+
+    // References the canvas holds keep the content from before blending, except the one being overwritten.
+    // A blank canvas holds only transparent ones, which stay empty.
+    const uint32_t saved = layer.saveAsReference >= 0 ? 1u << layer.saveAsReference : 0;
+    for (uint32_t slot = 0; slot < 4 && !blank; ++slot) {
+        if (canvasSlots & ~saved & (1u << slot)) {
+            references[slot] = pixels;
+        }
+    }
+    if (saved) {
+        references[layer.saveAsReference].clear();
+    }
+    canvasSlots = saved;
+    blank = false;
+
+    const int64_t left = std::max<int64_t>(layer.x, 0);
+    const int64_t top = std::max<int64_t>(layer.y, 0);
+    const int64_t right = std::min<int64_t>(static_cast<int64_t>(layer.x) + layer.width, width);
+    const int64_t bottom = std::min<int64_t>(static_cast<int64_t>(layer.y) + layer.height, height);
+    if (left >= right || top >= bottom) {
+        return dirty;
+    }
+
+    const size_t canvasStride = static_cast<size_t>(width) * 4;
+    const size_t layerStride = static_cast<size_t>(layer.width) * 4;
+    const uint8_t* layerOrigin = layer.pixels.data() + (top - layer.y) * layerStride + (left - layer.x) * 4;
+    if (!BlendRgba8(pixels.data() + top * canvasStride + left * 4, canvasStride,
+                    layerOrigin, layerStride, right - left, bottom - top,
+                    layer.blendMode, premultiplied)) {
+        std::string str = "Unsupported blend mode";
+        throw JxlCompositorError(str);
+    }
+
+    if (dirty.width == 0) {
+        return { static_cast<uint32_t>(left), static_cast<uint32_t>(top),
+            static_cast<uint32_t>(right - left), static_cast<uint32_t>(bottom - top) };
+    }
+    return dirty;
+}
+
+}
@@ -0,0 +1,102 @@
+//
+//  JxlLayerCompositor.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#ifndef JxlLayerCompositor_hpp
+#define JxlLayerCompositor_hpp
+
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+#include "JxlAnimatedDecoder.hpp"
+
+namespace jxlcoder {
+
+class JxlCompositorError : public std::exception {
+public:
+    JxlCompositorError(const std::string& message) : errorMessage(message) {}
+
+    const char* what() const noexcept override {
+        return errorMessage.c_str();
+    }
+
+private:
+    std::string errorMessage;
+};
+
+struct JxlLayerRect {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+/**
+ * Keeps an RGBA8 canvas across layers from JxlAnimatedDecoder::getLayer and blends each of them
+ * onto it, touching only the layer rectangle.
+ * The four reference slots of the format are tracked lazily: as long as layers blend onto the slot
+ * the previous layer was saved to, which is what animations normally do, the canvas is updated in place
+ * and nothing is copied. Other references are copied out only when a layer is about to overwrite them.
+ */
+class JxlLayerCompositor {
+public:
+    JxlLayerCompositor(uint32_t width, uint32_t height, bool premultiplied);
+
+    /**
+     * Blends the layer onto its source reference, the result becomes the canvas.
+     * @return canvas rectangle that changed, the whole canvas when a different reference had to be restored
+     */
+    JxlLayerRect apply(const JxlLayer& layer);
+
+    const std::vector<uint8_t>& canvas() const {
+        return pixels;
+    }
+
+    uint32_t getWidth() const {
+        return width;
+    }
+
+    uint32_t getHeight() const {
+        return height;
+    }
+
+private:
+    uint32_t width;
+    uint32_t height;
+    bool premultiplied;
+    std::vector<uint8_t> pixels;
+    // Stored references, empty ones are transparent
+    std::array<std::vector<uint8_t>, 4> references;
+    // Bit i is set while reference i is held by the canvas instead of references[i]
+    uint32_t canvasSlots;
+    // Set until the first layer is blended, the canvas is still transparent
+    bool blank;
+};
+
+}
+
+#endif /* JxlLayerCompositor_hpp */
@@ -0,0 +1,207 @@
+//
+//  JxlMemoryArena.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlMemoryArena.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace jxlcoder {
+
+namespace {
+
+/**
+ * Precedes every block, keeps the user pointer aligned as malloc would
+ */
+struct alignas(16) JxlBlockHeader {
+    size_t size;
+    uint32_t sizeClass;
+};
+
+constexpr uint32_t uncachedClass = UINT32_MAX;
+constexpr size_t minimumClassSize = 64;
+
+/**
+ * Rounds size up to the class it belongs to, 4 classes per power of two above 64 bytes
+ */
+uint32_t JxlSizeClass(size_t size, size_t* classSize) {
+    if (size <= minimumClassSize) {
+        *classSize = minimumClassSize;
+        return 0;
+    }
+    size_t value = size - 1;
+    uint32_t power = 0;
+    while ((value >> power) > 1) {
+        ++power;
+    }
+    size_t quarter = value >> (power - 2);
+    *classSize = (quarter + 1) << (power - 2);
+    return 1 + (power - 6) * 4 + static_cast<uint32_t>(quarter - 4);
+}
+
+thread_local JxlMemoryScope* currentScope = nullptr;
+
+}
+
+JxlMemoryArena::JxlMemoryArena(size_t cacheLimit) : cacheLimit(cacheLimit) {
+    memoryManager.opaque = this;
+    memoryManager.alloc = allocate;
+    memoryManager.free = release;
+}
+
+JxlMemoryArena::~JxlMemoryArena() {
+    trim();
+}
+
+void JxlMemoryArena::setLimit(size_t bytes) {
+    std::lock_guard guard(lock);
+    limit = bytes;
+}
+
+JxlMemoryStats JxlMemoryArena::stats() const {
+    std::lock_guard guard(lock);
+    return current;
+}
+
+void JxlMemoryArena::resetStats() {
+    std::lock_guard guard(lock);
+    size_t inUse = current.bytesInUse;
+    current = JxlMemoryStats();
+    current.bytesInUse = inUse;
+    current.peakBytes = inUse;
+}
+
+void JxlMemoryArena::trim() {
+    std::lock_guard guard(lock);
+    for (auto& blocks : freeBlocks) {
+        for (void* block : blocks) {
+            std::free(block);
+        }
+        blocks.clear();
+        blocks.shrink_to_fit();
+    }
+    cachedBytes = 0;
+}
+
+void* JxlMemoryArena::allocate(void* opaque, size_t size) {
+    auto arena = static_cast<JxlMemoryArena*>(opaque);
+    size_t classSize;
+    uint32_t sizeClass = JxlSizeClass(size, &classSize);
+    if (sizeClass >= classesCount) {
+        sizeClass = uncachedClass;
+        classSize = size;
+    }
+    if (classSize > SIZE_MAX - sizeof(JxlBlockHeader)) {
+        return nullptr;
+    }
+
+    void* block = nullptr;
+    {
+        std::lock_guard guard(arena->lock);
+        JxlMemoryStats& stats = arena->current;
+        if (arena->limit != 0 && (classSize > arena->limit || stats.bytesInUse > arena->limit - classSize)) {
+            stats.limitExceeded = true;
+            return nullptr;
+        }
+        // Accounted before the system allocation, so concurrent callers cannot overshoot the limit together
+        stats.bytesInUse += classSize;
+        stats.peakBytes = std::max(stats.peakBytes, stats.bytesInUse);
+        stats.bytesAllocated += classSize;
+        stats.allocationCount += 1;
+        if (sizeClass != uncachedClass && !arena->freeBlocks[sizeClass].empty()) {
+            block = arena->freeBlocks[sizeClass].back();
+            arena->freeBlocks[sizeClass].pop_back();
+            arena->cachedBytes -= classSize;
+        }
+    }
+
+    if (!block) {
+        block = std::malloc(sizeof(JxlBlockHeader) + classSize);
+        if (!block) {
+            std::lock_guard guard(arena->lock);
+            arena->current.bytesInUse -= classSize;
+            return nullptr;
+        }
+    }
+    auto header = static_cast<JxlBlockHeader*>(block);
+    header->size = classSize;
+    header->sizeClass = sizeClass;
+    return header + 1;
+}
+
+void JxlMemoryArena::release(void* opaque, void* address) {
+    if (!address) {
+        return;
+    }
+    auto arena = static_cast<JxlMemoryArena*>(opaque);
+    auto header = static_cast<JxlBlockHeader*>(address) - 1;
+    const size_t size = header->size;
+    const uint32_t sizeClass = header->sizeClass;
+    {
+        std::lock_guard guard(arena->lock);
+        arena->current.bytesInUse -= size;
+        if (sizeClass != uncachedClass && arena->cachedBytes + size <= arena->cacheLimit) {
+            // push_back may throw, in which case the block simply goes back to the system
+            try {
+                arena->freeBlocks[sizeClass].push_back(header);
+                arena->cachedBytes += size;
+                return;
+            } catch (std::bad_alloc&) {
+            }
+        }
+    }
+    std::free(header);
+}
+
+JxlMemoryScope::JxlMemoryScope(size_t limit) : limit(limit), previous(currentScope) {
+    currentScope = this;
+}
+
+JxlMemoryScope::~JxlMemoryScope() {
+    currentScope = previous;
+}
+
+JxlMemoryScope* JxlMemoryScope::current() {
+    return currentScope;
+}
+
+void JxlMemoryScope::begin(JxlMemoryArena& arena) {
+    arena.setLimit(currentScope ? currentScope->limit : 0);
+    arena.resetStats();
+}
+
+void JxlMemoryScope::collect(const JxlMemoryArena& arena) {
+    if (!currentScope) {
+        return;
+    }
+    JxlMemoryStats stats = arena.stats();
+    JxlMemoryStats& total = currentScope->total;
+    total.peakBytes = std::max(total.peakBytes, stats.peakBytes);
+    total.bytesAllocated += stats.bytesAllocated;
+    total.allocationCount += stats.allocationCount;
+    total.limitExceeded = total.limitExceeded || stats.limitExceeded;
+}
+
+}
@@ -0,0 +1,206 @@
+//
+//  JxlMemoryArena.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlMemoryArena_hpp
+#define JxlMemoryArena_hpp
+
+#ifdef __cplusplus
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <jxl/memory_manager.h>
+
+namespace jxlcoder {
+
+/**
+ * Memory used by libjxl during one operation, sizes are in bytes
+ */
+struct JxlMemoryStats {
+    // Currently held by libjxl
+    size_t bytesInUse = 0;
+    // Highest bytesInUse seen
+    size_t peakBytes = 0;
+    // Sum of every allocation, including memory freed since
+    size_t bytesAllocated = 0;
+    size_t allocationCount = 0;
+    // Set when an allocation was refused because of the limit
+    bool limitExceeded = false;
+};
+
+/**
+ * JxlMemoryManager backed by size class free lists.
+ * Blocks freed by libjxl are kept for the next allocation of the same class, so a decoder or encoder
+ * created with manager() reuses its own memory between calls instead of going through the global allocator.
+ * Classes are 4 per power of two, so no more than 25% of a block is wasted.
+ * Allocation is thread-safe, libjxl allocates from its worker threads too.
+ */
+class JxlMemoryArena {
+public:
+    static constexpr size_t defaultCacheLimit = 64 * 1024 * 1024;
+
+    /**
+     * @param cacheLimit bytes of freed blocks to keep for reuse, anything beyond goes back to the system
+     */
+    explicit JxlMemoryArena(size_t cacheLimit = defaultCacheLimit);
+    ~JxlMemoryArena();
+
+    JxlMemoryArena(const JxlMemoryArena&) = delete;
+    JxlMemoryArena& operator=(const JxlMemoryArena&) = delete;
+
+    /**
+     * To be passed to JxlDecoderCreate or JxlEncoderCreate, the arena must outlive the decoder or encoder
+     */
+    const JxlMemoryManager* manager() const {
+        return &memoryManager;
+    }
+
+    /**
+     * Allocations that would bring bytesInUse over the limit fail, which makes libjxl stop with an error
+     * instead of growing further. 0 means unlimited.
+     */
+    void setLimit(size_t bytes);
+
+    JxlMemoryStats stats() const;
+
+    /**
+     * Starts accounting a new operation, bytesInUse is kept since memory held by libjxl stays in use
+     */
+    void resetStats();
+
+    /**
+     * Returns every cached block to the system
+     */
+    void trim();
+
+private:
+    // 64 bytes and up to 64 MB, larger blocks are never cached
+    static constexpr size_t classesCount = 81;
+
+    static void* allocate(void* opaque, size_t size);
+    static void release(void* opaque, void* address);
+
+    mutable std::mutex lock;
+    JxlMemoryManager memoryManager;
+    std::array<std::vector<void*>, classesCount> freeBlocks;
+    size_t cachedBytes = 0;
+    size_t cacheLimit;
+    size_t limit = 0;
+    JxlMemoryStats current;
+};
+
+/**
+ * Per operation memory budget for the calling thread.
+ * Decoders leased from JxlDecoderPool and encoders created by this library while the scope is alive
+ * get its limit, and report what they used into it once they are done. Animation and progressive
+ * coders apply it to every call made within the scope.
+ *
+ *     jxlcoder::JxlMemoryScope scope(256 * 1024 * 1024);
+ *     bool decoded = DecodeJpegXlStream(...);
+ *     if (!decoded && scope.stats().limitExceeded) { ... }
+ */
+class JxlMemoryScope {
+public:
+    /**
+     * @param limit bytes libjxl may hold at once, 0 means unlimited
+     */
+    explicit JxlMemoryScope(size_t limit = 0);
+    ~JxlMemoryScope();
+
+    JxlMemoryScope(const JxlMemoryScope&) = delete;
+    JxlMemoryScope& operator=(const JxlMemoryScope&) = delete;
+
+    /**
+     * Innermost scope of the calling thread, or nullptr
+     */
+    static JxlMemoryScope* current();
+
+    /**
+     * Applies the current scope limit, or no limit without a scope, and starts a new operation
+     */
+    static void begin(JxlMemoryArena& arena);
+
+    /**
+     * Adds stats of a finished operation to the current scope, if any
+     */
+    static void collect(const JxlMemoryArena& arena);
+
+    /**
+     * Totals of every operation finished in this scope, peakBytes is the highest of them.
+     * bytesInUse is not tracked here since nothing is in use once an operation is finished.
+     */
+    JxlMemoryStats stats() const {
+        return total;
+    }
+
+private:
+    size_t limit;
+    JxlMemoryStats total;
+    JxlMemoryScope* previous;
+};
+
+/**
+ * Arena for a single operation on the calling thread, takes the scope limit when created
+ * and reports into the scope when destroyed. Must be declared before the decoder or encoder using it.
+ */
+class JxlScopedMemoryArena : public JxlMemoryArena {
+public:
+    JxlScopedMemoryArena() : JxlMemoryArena(0) {
+        JxlMemoryScope::begin(*this);
+    }
+
+    ~JxlScopedMemoryArena() {
+        JxlMemoryScope::collect(*this);
+    }
+};
+
+/**
+ * One call into a decoder or encoder that lives across calls, such as an animation or progressive decoder.
+ * Takes the scope limit of the calling thread for the arena when created and reports into the scope
+ * when destroyed, also when the call throws.
+ */
+class JxlMemoryOperation {
+public:
+    explicit JxlMemoryOperation(JxlMemoryArena& arena) : arena(arena) {
+        JxlMemoryScope::begin(arena);
+    }
+
+    ~JxlMemoryOperation() {
+        JxlMemoryScope::collect(arena);
+    }
+
+    JxlMemoryOperation(const JxlMemoryOperation&) = delete;
+    JxlMemoryOperation& operator=(const JxlMemoryOperation&) = delete;
+
+private:
+    JxlMemoryArena& arena;
+};
+
+}
+
+#endif
+
+#endif /* JxlMemoryArena_hpp */
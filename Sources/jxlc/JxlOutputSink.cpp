@@ -0,0 +1,124 @@
+//
+//  JxlOutputSink.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlOutputSink.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace jxlcoder {
+
+bool JxlVectorOutputSink::write(uint64_t position, const uint8_t* data, size_t size) {
+    if (position > destination.size()) {
+        return false;
+    }
+    size_t offset = static_cast<size_t>(position);
+    size_t overwritten = std::min(size, destination.size() - offset);
+    std::memcpy(destination.data() + offset, data, overwritten);
+    // insert grows the capacity geometrically and does not zero fill what is about to be copied
+    destination.insert(destination.end(), data + overwritten, data + size);
+    return true;
+}
+
+JxlFileDescriptorOutputSink::JxlFileDescriptorOutputSink(int fd) : fd(fd) {
+    off_t current = ::lseek(fd, 0, SEEK_CUR);
+    origin = current < 0 ? -1 : static_cast<int64_t>(current);
+}
+
+bool JxlFileDescriptorOutputSink::write(uint64_t position, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t result = origin >= 0 ?
+        ::pwrite(fd, data, size, static_cast<off_t>(origin + position)) : ::write(fd, data, size);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += result;
+        size -= static_cast<size_t>(result);
+        position += static_cast<uint64_t>(result);
+    }
+    return true;
+}
+
+bool JxlOutputWriter::attach(JxlEncoder* encoder) {
+    JxlEncoderOutputProcessor processor = {
+        this,
+        &JxlOutputWriter::getBuffer,
+        &JxlOutputWriter::releaseBuffer,
+        sink.seekable() ? &JxlOutputWriter::seek : nullptr,
+        &JxlOutputWriter::setFinalizedPosition
+    };
+    return JXL_ENC_SUCCESS == JxlEncoderSetOutputProcessor(encoder, processor);
+}
+
+bool JxlOutputWriter::finish(JxlEncoder* encoder) {
+    JxlEncoderCloseInput(encoder);
+    if (JXL_ENC_SUCCESS != JxlEncoderFlushInput(encoder)) {
+        return false;
+    }
+    return !sinkFailed;
+}
+
+void* JxlOutputWriter::getBuffer(void* opaque, size_t* size) {
+    auto writer = static_cast<JxlOutputWriter*>(opaque);
+    if (writer->sinkFailed) {
+        // A null buffer of size 0 makes libjxl stop with an error
+        *size = 0;
+        return nullptr;
+    }
+    // Handing out less than suggested makes libjxl fall back to buffering on its own side
+    size_t required = std::max(*size, writer->chunkSize);
+    if (writer->chunk.size() < required) {
+        writer->chunk.resize(required);
+    }
+    *size = writer->chunk.size();
+    return writer->chunk.data();
+}
+
+void JxlOutputWriter::releaseBuffer(void* opaque, size_t writtenBytes) {
+    auto writer = static_cast<JxlOutputWriter*>(opaque);
+    if (writtenBytes == 0 || writer->sinkFailed) {
+        return;
+    }
+    if (!writer->sink.write(writer->position, writer->chunk.data(), writtenBytes)) {
+        writer->sinkFailed = true;
+        return;
+    }
+    writer->position += writtenBytes;
+    writer->end = std::max(writer->end, writer->position);
+}
+
+void JxlOutputWriter::seek(void* opaque, uint64_t position) {
+    static_cast<JxlOutputWriter*>(opaque)->position = position;
+}
+
+void JxlOutputWriter::setFinalizedPosition(void*, uint64_t) {
+    // Sinks write through right away, there is nothing held back to release
+}
+
+}
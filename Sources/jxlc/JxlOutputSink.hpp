@@ -0,0 +1,161 @@
+//
+//  JxlOutputSink.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlOutputSink_hpp
+#define JxlOutputSink_hpp
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <jxl/encode.h>
+
+namespace jxlcoder {
+
+/**
+ * Abstract writer the encoders push compressed bytes into as libjxl produces them.
+ */
+class JxlOutputSink {
+public:
+    virtual ~JxlOutputSink() = default;
+
+    /**
+     * Writes every byte at position, counted from where the encoder started writing.
+     * Unless the sink is seekable position is always the end of what was written before.
+     * @return false on I/O error, which stops the encoder
+     */
+    virtual bool write(uint64_t position, const uint8_t* data, size_t size) = 0;
+
+    /**
+     * Seekable sinks let libjxl go back and patch box sizes, others make it hold those bytes until they are final.
+     */
+    virtual bool seekable() const {
+        return false;
+    }
+};
+
+/**
+ * Appends to a vector owned by the caller, capacity grows geometrically so bytes are moved O(1) times on average.
+ */
+class JxlVectorOutputSink : public JxlOutputSink {
+public:
+    explicit JxlVectorOutputSink(std::vector<uint8_t>& destination) : destination(destination) {}
+
+    bool write(uint64_t position, const uint8_t* data, size_t size) override;
+    bool seekable() const override {
+        return true;
+    }
+
+private:
+    std::vector<uint8_t>& destination;
+};
+
+/**
+ * Writes to a file descriptor that stays owned by the caller, starting at its current offset.
+ * Regular files are seekable, pipes and sockets are written strictly in order.
+ */
+class JxlFileDescriptorOutputSink : public JxlOutputSink {
+public:
+    explicit JxlFileDescriptorOutputSink(int fd);
+
+    bool write(uint64_t position, const uint8_t* data, size_t size) override;
+    bool seekable() const override {
+        return origin >= 0;
+    }
+
+private:
+    int fd;
+    // Offset of the first byte, -1 when the descriptor cannot seek
+    int64_t origin;
+};
+
+class JxlCallbackOutputSink : public JxlOutputSink {
+public:
+    typedef std::function<bool(const uint8_t* data, size_t size)> Writer;
+
+    explicit JxlCallbackOutputSink(Writer writer) : writer(std::move(writer)) {}
+
+    bool write(uint64_t, const uint8_t* data, size_t size) override {
+        return writer(data, size);
+    }
+
+private:
+    Writer writer;
+};
+
+/**
+ * Connects a sink to an encoder through JxlEncoderSetOutputProcessor, so nothing but one chunk
+ * of compressed data is buffered on this side.
+ */
+class JxlOutputWriter {
+public:
+    explicit JxlOutputWriter(JxlOutputSink& sink, size_t chunkSize = 64 * 1024) :
+    sink(sink), chunkSize(chunkSize) {}
+
+    JxlOutputWriter(const JxlOutputWriter&) = delete;
+    JxlOutputWriter& operator=(const JxlOutputWriter&) = delete;
+
+    /**
+     * Must be called before the first frame or box is added, the writer must outlive the encoder's use of it.
+     */
+    bool attach(JxlEncoder* encoder);
+
+    /**
+     * Closes the input and makes libjxl write out everything still pending.
+     * @return false if encoding or the sink failed
+     */
+    bool finish(JxlEncoder* encoder);
+
+    bool failed() const {
+        return sinkFailed;
+    }
+
+    /**
+     * Size of the output so far
+     */
+    uint64_t size() const {
+        return end;
+    }
+
+private:
+    static void* getBuffer(void* opaque, size_t* size);
+    static void releaseBuffer(void* opaque, size_t writtenBytes);
+    static void seek(void* opaque, uint64_t position);
+    static void setFinalizedPosition(void* opaque, uint64_t finalizedPosition);
+
+    JxlOutputSink& sink;
+    size_t chunkSize;
+    std::vector<uint8_t> chunk;
+    uint64_t position = 0;
+    uint64_t end = 0;
+    bool sinkFailed = false;
+};
+
+}
+
+#endif
+
+#endif /* JxlOutputSink_hpp */
@@ -0,0 +1,201 @@
+//
+//  JxlPixelSource.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlPixelSource.hpp"
+#include <cstring>
+
+namespace jxlcoder {
+
+static size_t JxlSampleSize(JxlDataType dataType) {
+    switch (dataType) {
+        case JXL_TYPE_UINT8:
+            return 1;
+        case JXL_TYPE_UINT16:
+        case JXL_TYPE_FLOAT16:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+JxlChunkedFrameInput::JxlChunkedFrameInput(JxlPixelSource& source, const JxlPixelFormat& format) :
+source(source), format(format), sampleSize(JxlSampleSize(format.data_type)) {
+}
+
+JxlChunkedFrameInputSource JxlChunkedFrameInput::inputSource() {
+    return JxlChunkedFrameInputSource {
+        this,
+        &JxlChunkedFrameInput::getColorChannelsPixelFormat,
+        &JxlChunkedFrameInput::getColorChannelDataAt,
+        &JxlChunkedFrameInput::getExtraChannelPixelFormat,
+        &JxlChunkedFrameInput::getExtraChannelDataAt,
+        &JxlChunkedFrameInput::releaseBuffer
+    };
+}
+
+std::vector<uint8_t> JxlChunkedFrameInput::acquire(size_t size) {
+    std::vector<uint8_t> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!spare.empty()) {
+            buffer = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+const void* JxlChunkedFrameInput::lend(std::vector<uint8_t> buffer, const Rectangle& rectangle, bool color) {
+    // Moving the vector into the map keeps its storage, so the pointer stays valid until released
+    const void* data = buffer.data();
+    std::lock_guard<std::mutex> lock(mutex);
+    lent.emplace(data, LentBuffer { std::move(buffer), rectangle, color });
+    return data;
+}
+
+void JxlChunkedFrameInput::keepRecent(const Rectangle& rectangle, std::vector<uint8_t> color) {
+    // Called with the mutex held
+    recent.emplace_back(rectangle, std::move(color));
+    while (recent.size() > recentLimit) {
+        spare.push_back(std::move(recent.front().second));
+        recent.pop_front();
+    }
+}
+
+std::vector<uint8_t> JxlChunkedFrameInput::read(size_t xpos, size_t ypos, size_t xsize, size_t ysize) {
+    size_t stride = xsize * format.num_channels * sampleSize;
+    std::vector<uint8_t> buffer = acquire(stride * ysize);
+    if (!sourceFailed.load(std::memory_order_relaxed) &&
+        !source.read(xpos, ypos, xsize, ysize, buffer.data(), stride)) {
+        sourceFailed.store(true, std::memory_order_relaxed);
+    }
+    if (sourceFailed.load(std::memory_order_relaxed)) {
+        // libjxl has no way to fail a rectangle, it gets zeros and the encode is discarded afterwards
+        std::memset(buffer.data(), 0, buffer.size());
+    }
+    return buffer;
+}
+
+void JxlChunkedFrameInput::extractAlpha(const uint8_t* color, size_t pixelCount, uint8_t* alpha) const {
+    // The only extra channel is alpha, interleaved last in the color pixels
+    size_t pixelSize = format.num_channels * sampleSize;
+    const uint8_t* src = color + (format.num_channels - 1) * sampleSize;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        std::memcpy(alpha, src, sampleSize);
+        src += pixelSize;
+        alpha += sampleSize;
+    }
+}
+
+const void* JxlChunkedFrameInput::readColor(size_t xpos, size_t ypos, size_t xsize, size_t ysize, size_t* rowOffset) {
+    *rowOffset = xsize * format.num_channels * sampleSize;
+    const Rectangle rectangle(xpos, ypos, xsize, ysize);
+    std::vector<uint8_t> color;
+    {
+        // Read already when alpha was asked for first
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = recent.begin(); it != recent.end(); ++it) {
+            if (it->first == rectangle) {
+                color = std::move(it->second);
+                recent.erase(it);
+                break;
+            }
+        }
+    }
+    if (color.empty()) {
+        color = read(xpos, ypos, xsize, ysize);
+    }
+    return lend(std::move(color), rectangle, true);
+}
+
+const void* JxlChunkedFrameInput::readAlpha(size_t xpos, size_t ypos, size_t xsize, size_t ysize, size_t* rowOffset) {
+    *rowOffset = xsize * sampleSize;
+    const Rectangle rectangle(xpos, ypos, xsize, ysize);
+    const size_t pixelCount = xsize * ysize;
+    std::vector<uint8_t> alpha = acquire(pixelCount * sampleSize);
+    bool extracted = false;
+    {
+        // Copied under the mutex, a released color buffer could otherwise be reused meanwhile
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& entry : lent) {
+            if (entry.second.color && entry.second.rectangle == rectangle) {
+                extractAlpha(entry.second.pixels.data(), pixelCount, alpha.data());
+                extracted = true;
+                break;
+            }
+        }
+        for (auto it = recent.begin(); !extracted && it != recent.end(); ++it) {
+            if (it->first == rectangle) {
+                extractAlpha(it->second.data(), pixelCount, alpha.data());
+                extracted = true;
+            }
+        }
+    }
+    if (!extracted) {
+        std::vector<uint8_t> color = read(xpos, ypos, xsize, ysize);
+        extractAlpha(color.data(), pixelCount, alpha.data());
+        std::lock_guard<std::mutex> lock(mutex);
+        keepRecent(rectangle, std::move(color));
+    }
+    return lend(std::move(alpha), rectangle, false);
+}
+
+void JxlChunkedFrameInput::getColorChannelsPixelFormat(void* opaque, JxlPixelFormat* pixelFormat) {
+    *pixelFormat = static_cast<JxlChunkedFrameInput*>(opaque)->format;
+}
+
+const void* JxlChunkedFrameInput::getColorChannelDataAt(void* opaque, size_t xpos, size_t ypos,
+                                                        size_t xsize, size_t ysize, size_t* rowOffset) {
+    return static_cast<JxlChunkedFrameInput*>(opaque)->readColor(xpos, ypos, xsize, ysize, rowOffset);
+}
+
+void JxlChunkedFrameInput::getExtraChannelPixelFormat(void* opaque, size_t, JxlPixelFormat* pixelFormat) {
+    auto input = static_cast<JxlChunkedFrameInput*>(opaque);
+    *pixelFormat = input->format;
+    pixelFormat->num_channels = 1;
+}
+
+const void* JxlChunkedFrameInput::getExtraChannelDataAt(void* opaque, size_t, size_t xpos, size_t ypos,
+                                                        size_t xsize, size_t ysize, size_t* rowOffset) {
+    return static_cast<JxlChunkedFrameInput*>(opaque)->readAlpha(xpos, ypos, xsize, ysize, rowOffset);
+}
+
+void JxlChunkedFrameInput::releaseBuffer(void* opaque, const void* buffer) {
+    auto input = static_cast<JxlChunkedFrameInput*>(opaque);
+    std::lock_guard<std::mutex> lock(input->mutex);
+    auto it = input->lent.find(buffer);
+    if (it == input->lent.end()) {
+        return;
+    }
+    if (it->second.color) {
+        input->keepRecent(it->second.rectangle, std::move(it->second.pixels));
+    } else {
+        input->spare.push_back(std::move(it->second.pixels));
+    }
+    input->lent.erase(it);
+}
+
+}
@@ -0,0 +1,123 @@
+//
+//  JxlPixelSource.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlPixelSource_hpp
+#define JxlPixelSource_hpp
+
+#ifdef __cplusplus
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <jxl/encode.h>
+
+namespace jxlcoder {
+
+/**
+ * Produces the pixels of a frame on demand, one rectangle at a time, so a frame is never held as a whole.
+ */
+class JxlPixelSource {
+public:
+    virtual ~JxlPixelSource() = default;
+
+    /**
+     * Writes width x height interleaved pixels starting at x, y in the pixel format the frame is encoded with,
+     * rows stride bytes apart. May be called from several threads at once for different rectangles.
+     * @return false on failure, which fails the encoding
+     */
+    virtual bool read(size_t x, size_t y, size_t width, size_t height, uint8_t* destination, size_t stride) = 0;
+};
+
+/**
+ * Feeds a pixel source into JxlEncoderAddChunkedFrame. libjxl asks for rectangles of at most 2048 x 2048
+ * as it goes through the groups, each one is read into a buffer that lives until libjxl releases it,
+ * and released buffers are reused for the next rectangles.
+ * Alpha is interleaved in the color pixels, which libjxl takes it from. Should it still ask for alpha
+ * as an extra channel, it is copied out of the color rectangle when that is lent or among the few
+ * released last, and only otherwise read again. Nothing is kept for requests that may never come.
+ */
+class JxlChunkedFrameInput {
+public:
+    JxlChunkedFrameInput(JxlPixelSource& source, const JxlPixelFormat& format);
+
+    JxlChunkedFrameInput(const JxlChunkedFrameInput&) = delete;
+    JxlChunkedFrameInput& operator=(const JxlChunkedFrameInput&) = delete;
+
+    /**
+     * Callbacks for JxlEncoderAddChunkedFrame, the input must outlive that call.
+     */
+    JxlChunkedFrameInputSource inputSource();
+
+    bool failed() const {
+        return sourceFailed.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void getColorChannelsPixelFormat(void* opaque, JxlPixelFormat* pixelFormat);
+    static const void* getColorChannelDataAt(void* opaque, size_t xpos, size_t ypos,
+                                             size_t xsize, size_t ysize, size_t* rowOffset);
+    static void getExtraChannelPixelFormat(void* opaque, size_t ecIndex, JxlPixelFormat* pixelFormat);
+    static const void* getExtraChannelDataAt(void* opaque, size_t ecIndex, size_t xpos, size_t ypos,
+                                             size_t xsize, size_t ysize, size_t* rowOffset);
+    static void releaseBuffer(void* opaque, const void* buffer);
+
+    typedef std::tuple<size_t, size_t, size_t, size_t> Rectangle;
+
+    struct LentBuffer {
+        std::vector<uint8_t> pixels;
+        Rectangle rectangle;
+        bool color;
+    };
+
+    // Released color rectangles kept for an alpha request of the same rectangle
+    static constexpr size_t recentLimit = 2;
+
+    std::vector<uint8_t> acquire(size_t size);
+    const void* lend(std::vector<uint8_t> buffer, const Rectangle& rectangle, bool color);
+    const void* readColor(size_t xpos, size_t ypos, size_t xsize, size_t ysize, size_t* rowOffset);
+    const void* readAlpha(size_t xpos, size_t ypos, size_t xsize, size_t ysize, size_t* rowOffset);
+    std::vector<uint8_t> read(size_t xpos, size_t ypos, size_t xsize, size_t ysize);
+    void extractAlpha(const uint8_t* color, size_t pixelCount, uint8_t* alpha) const;
+    void keepRecent(const Rectangle& rectangle, std::vector<uint8_t> color);
+
+    JxlPixelSource& source;
+    JxlPixelFormat format;
+    size_t sampleSize;
+    std::mutex mutex;
+    std::unordered_map<const void*, LentBuffer> lent;
+    std::vector<std::vector<uint8_t>> spare;
+    std::deque<std::pair<Rectangle, std::vector<uint8_t>>> recent;
+    std::atomic<bool> sourceFailed{false};
+};
+
+}
+
+#endif
+
+#endif /* JxlPixelSource_hpp */
@@ -0,0 +1,163 @@
+//
+//  JxlProgressiveDecoder.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlProgressiveDecoder.hpp"
+#include "JxlWorker.hpp"
+
+JxlProgressiveDecoder::JxlProgressiveDecoder(JxlDecodingPixelFormat pixelFormat,
+                                             JxlRunnerPriority priority) : pixelFormat(pixelFormat), runner(priority) {
+    dec = JxlDecoderMake(arena.manager());
+    if (!dec) {
+        std::string str = "Cannot create decoder";
+        throw ProgressiveDecoderError(str);
+    }
+
+    if (JXL_DEC_SUCCESS !=
+        JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_BASIC_INFO |
+                                  JXL_DEC_COLOR_ENCODING |
+                                  JXL_DEC_FRAME_PROGRESSION |
+                                  JXL_DEC_FULL_IMAGE)) {
+        std::string str = "Cannot subscribe to decoder events";
+        throw ProgressiveDecoderError(str);
+    }
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec.get(),
+                                                       jxlcoder::JxlSharedParallelRunner,
+                                                       &runner)) {
+        std::string str = "Cannot attach parallel runner to decoder";
+        throw ProgressiveDecoderError(str);
+    }
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetUnpremultiplyAlpha(dec.get(), JXL_TRUE)) {
+        std::string str = "Cannot initialize decoder";
+        throw ProgressiveDecoderError(str);
+    }
+
+    // Report the DC image and then every refinement pass
+    if (JXL_DEC_SUCCESS != JxlDecoderSetProgressiveDetail(dec.get(), kPasses)) {
+        std::string str = "Cannot set progressive detail";
+        throw ProgressiveDecoderError(str);
+    }
+}
+
+JxlProgressiveStatus JxlProgressiveDecoder::append(const uint8_t* data, size_t size) {
+    if (complete) {
+        return progressiveFullImage;
+    }
+    if (inputClosed) {
+        std::string str = "Input was already closed";
+        throw ProgressiveDecoderError(str);
+    }
+
+    // Bytes not consumed by the previous call must be handed over again together with the new ones
+    size_t remaining = JxlDecoderReleaseInput(dec.get());
+    if (remaining < pending.size()) {
+        pending.erase(pending.begin(), pending.end() - remaining);
+    }
+    pending.insert(pending.end(), data, data + size);
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetInput(dec.get(), pending.data(), pending.size())) {
+        std::string str = "Set input has failed";
+        throw ProgressiveDecoderError(str);
+    }
+    return process();
+}
+
+JxlProgressiveStatus JxlProgressiveDecoder::close() {
+    if (complete) {
+        return progressiveFullImage;
+    }
+    inputClosed = true;
+    JxlDecoderCloseInput(dec.get());
+    return process();
+}
+
+JxlProgressiveStatus JxlProgressiveDecoder::process() {
+    // Input arrives over time, cancellation is taken from whoever feeds this chunk
+    runner.cancellation = jxlcoder::JxlCancellationScope::current();
+    // Likewise the memory limit, what libjxl holds between chunks counts against every call
+    jxlcoder::JxlMemoryOperation operation(arena);
+    JxlProgressiveStatus result = progressiveNeedMoreInput;
+    for (;;) {
+        if (runner.cancelled()) {
+            std::string str = "Decoding was cancelled";
+            throw ProgressiveDecoderError(str);
+        }
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec.get());
+        if (status == JXL_DEC_ERROR) {
+            std::string str = "Error event has received";
+            throw ProgressiveDecoderError(str);
+        } else if (status == JXL_DEC_NEED_MORE_INPUT) {
+            if (inputClosed) {
+                std::string str = "Image data is truncated";
+                throw ProgressiveDecoderError(str);
+            }
+            return result;
+        } else if (status == JXL_DEC_BASIC_INFO) {
+            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec.get(), &info)) {
+                std::string str = "Cannot retreive basic info";
+                throw ProgressiveDecoderError(str);
+            }
+            JxlResolveOutputFormat(info, pixelFormat, &format, &depth, &components, &useFloats);
+        } else if (status == JXL_DEC_COLOR_ENCODING) {
+            if (!JxlReadOutputColorProfile(dec.get(), format, &iccProfile)) {
+                std::string str = "Cannot retreive color icc profile";
+                throw ProgressiveDecoderError(str);
+            }
+        } else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
+            size_t bufferSize;
+            if (JXL_DEC_SUCCESS != JxlDecoderImageOutBufferSize(dec.get(), &format, &bufferSize)) {
+                std::string str = "Cannot retreive buffer info size";
+                throw ProgressiveDecoderError(str);
+            }
+            pixels.resize(bufferSize);
+            if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutBuffer(dec.get(), &format,
+                                                               pixels.data(), pixels.size())) {
+                std::string str = "Cannot set image out buffer";
+                throw ProgressiveDecoderError(str);
+            }
+        } else if (status == JXL_DEC_FRAME_PROGRESSION) {
+            // Render what was decoded so far, the pixel buffer keeps being refined in place
+            if (JXL_DEC_SUCCESS == JxlDecoderFlushImage(dec.get())) {
+                imageAvailable = true;
+                result = progressivePartialImage;
+            }
+        } else if (status == JXL_DEC_FULL_IMAGE) {
+            // Only the first frame is of interest, animations are handled by JxlAnimatedDecoder
+            imageAvailable = true;
+            complete = true;
+            JxlDecoderReleaseInput(dec.get());
+            pending.clear();
+            pending.shrink_to_fit();
+            return progressiveFullImage;
+        } else if (status == JXL_DEC_SUCCESS) {
+            complete = true;
+            return imageAvailable ? progressiveFullImage : result;
+        } else {
+            std::string str = "Unexpected decoder event has received";
+            throw ProgressiveDecoderError(str);
+        }
+    }
+}
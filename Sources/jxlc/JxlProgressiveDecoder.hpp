@@ -0,0 +1,149 @@
+//
+//  JxlProgressiveDecoder.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlProgressiveDecoder_hpp
+#define JxlProgressiveDecoder_hpp
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <jxl/decode.h>
+#include <jxl/decode_cxx.h>
+#include "JxlDefinitions.h"
+#include "JxlSharedRunner.hpp"
+#include "JxlMemoryArena.hpp"
+
+class ProgressiveDecoderError : public std::exception {
+public:
+    ProgressiveDecoderError(const std::string& message) : errorMessage(message) {}
+
+    const char* what() const noexcept override {
+        return errorMessage.c_str();
+    }
+
+private:
+    std::string errorMessage;
+};
+
+enum JxlProgressiveStatus {
+    progressiveNeedMoreInput = 1,
+    progressivePartialImage = 2,
+    progressiveFullImage = 3
+};
+
+/**
+ * Decodes a JXL image while its bytes are still arriving.
+ * Every time the decoder reaches a DC or pass boundary the intermediate image is flushed
+ * into the pixel buffer, so something can be shown long before the last byte is received.
+ */
+class JxlProgressiveDecoder {
+public:
+    JxlProgressiveDecoder(JxlDecodingPixelFormat pixelFormat = optimal,
+                          JxlRunnerPriority priority = runnerNormal);
+
+    /**
+     * Appends the next chunk of the file and decodes as far as the data allows.
+     * @return progressivePartialImage or progressiveFullImage when pixels() has been refreshed
+     */
+    JxlProgressiveStatus append(const uint8_t* data, size_t size);
+
+    /**
+     * Signals there is no more data. Throws if the image is still incomplete.
+     */
+    JxlProgressiveStatus close();
+
+    bool hasImage() const {
+        return imageAvailable;
+    }
+
+    bool isComplete() const {
+        return complete;
+    }
+
+    /**
+     * Latest rendered pixels, valid once hasImage() returns true
+     */
+    const std::vector<uint8_t>& getPixels() const {
+        return pixels;
+    }
+
+    const std::vector<uint8_t>& getIccProfile() const {
+        return iccProfile;
+    }
+
+    uint32_t getWidth() const {
+        return info.xsize;
+    }
+
+    uint32_t getHeight() const {
+        return info.ysize;
+    }
+
+    int getComponents() const {
+        return components;
+    }
+
+    int getDepth() const {
+        return depth;
+    }
+
+    bool isUsingFloats() const {
+        return useFloats;
+    }
+
+    JxlDataType getDataType() const {
+        return format.data_type;
+    }
+
+    JxlExposedOrientation getOrientation() const {
+        return static_cast<JxlExposedOrientation>(info.orientation);
+    }
+
+private:
+    JxlProgressiveStatus process();
+
+    const JxlDecodingPixelFormat pixelFormat;
+    jxlcoder::JxlSharedRunner runner;
+    // Declared before the decoder, which allocates from it
+    jxlcoder::JxlMemoryArena arena;
+    JxlDecoderPtr dec;
+    std::vector<uint8_t> pending;
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> iccProfile;
+    JxlBasicInfo info = {};
+    JxlPixelFormat format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+    int components = 4;
+    int depth = 8;
+    bool useFloats = false;
+    bool inputClosed = false;
+    bool imageAvailable = false;
+    bool complete = false;
+};
+
+#endif
+
+#endif /* JxlProgressiveDecoder_hpp */
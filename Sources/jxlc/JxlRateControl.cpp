@@ -0,0 +1,407 @@
+//
+//  JxlRateControl.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlRateControl.hpp"
+#include "JxlSharedRunner.hpp"
+#include "JxlMemoryArena.hpp"
+#include "JxlCancellation.hpp"
+#include "half.hpp"
+#include <jxl/encode_cxx.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace jxlcoder {
+
+struct JxlRateSample {
+    float distance;
+    double value;
+};
+
+static float JxlReadSample(const uint8_t* sample, int containerBitsPerSample, bool isFloat) {
+    if (isFloat) {
+        if (containerBitsPerSample == 16) {
+            half_float::half value;
+            std::memcpy(&value, sample, sizeof(value));
+            return float(value);
+        }
+        float value;
+        std::memcpy(&value, sample, sizeof(value));
+        return value;
+    }
+    if (containerBitsPerSample <= 8) {
+        return sample[0] / 255.0f;
+    }
+    uint16_t value;
+    std::memcpy(&value, sample, sizeof(value));
+    return value / 65535.0f;
+}
+
+// Rec. 709 luma of the source pixels laid out as the profile describes
+static std::vector<float> JxlSourceLuma(const std::vector<uint8_t>& pixels, size_t pixelCount,
+                                        const JxlEncoderProfile& profile) {
+    const size_t sampleSize = profile.containerBitsPerSample <= 8 ? 1 : profile.containerBitsPerSample <= 16 ? 2 : 4;
+    const size_t pixelSize = sampleSize * profile.numChannels;
+    std::vector<float> luma(pixelCount);
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const uint8_t* pixel = pixels.data() + i * pixelSize;
+        float r = JxlReadSample(pixel, profile.containerBitsPerSample, profile.isFloat);
+        if (profile.numChannels < 3) {
+            luma[i] = r;
+            continue;
+        }
+        float g = JxlReadSample(pixel + sampleSize, profile.containerBitsPerSample, profile.isFloat);
+        float b = JxlReadSample(pixel + 2 * sampleSize, profile.containerBitsPerSample, profile.isFloat);
+        luma[i] = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+    }
+    return luma;
+}
+
+// Mean SSIM over 8x8 windows placed 4 pixels apart, values are expected in 0...1
+static double JxlMeanSSIM(const std::vector<float>& reference, const std::vector<float>& distorted,
+                          size_t xsize, size_t ysize) {
+    const double c1 = 0.01 * 0.01;
+    const double c2 = 0.03 * 0.03;
+    const size_t windowWidth = std::min<size_t>(8, xsize);
+    const size_t windowHeight = std::min<size_t>(8, ysize);
+    const double count = static_cast<double>(windowWidth * windowHeight);
+    double total = 0;
+    size_t windows = 0;
+    for (size_t y = 0; y + windowHeight <= ysize; y += 4) {
+        for (size_t x = 0; x + windowWidth <= xsize; x += 4) {
+            double sumA = 0, sumB = 0, sumAA = 0, sumBB = 0, sumAB = 0;
+            for (size_t j = 0; j < windowHeight; ++j) {
+                const float* a = reference.data() + (y + j) * xsize + x;
+                const float* b = distorted.data() + (y + j) * xsize + x;
+                for (size_t i = 0; i < windowWidth; ++i) {
+                    sumA += a[i];
+                    sumB += b[i];
+                    sumAA += a[i] * a[i];
+                    sumBB += b[i] * b[i];
+                    sumAB += a[i] * b[i];
+                }
+            }
+            const double meanA = sumA / count;
+            const double meanB = sumB / count;
+            const double varianceA = sumAA / count - meanA * meanA;
+            const double varianceB = sumBB / count - meanB * meanB;
+            const double covariance = sumAB / count - meanA * meanB;
+            total += ((2 * meanA * meanB + c1) * (2 * covariance + c2)) /
+            ((meanA * meanA + meanB * meanB + c1) * (varianceA + varianceB + c2));
+            windows++;
+        }
+    }
+    return windows > 0 ? total / windows : 1.0;
+}
+
+static bool JxlEncodeCandidate(const std::vector<uint8_t>& pixels, uint32_t xsize, uint32_t ysize,
+                               const JxlEncoderProfile& profile, float distance, int effort, bool serial,
+                               const std::vector<uint8_t>* exifData, const std::vector<uint8_t>* xmpData,
+                               JxlRunnerPriority priority, std::vector<uint8_t>* compressed) {
+    JxlEncoderProfile candidate = profile;
+    candidate.compressionOption = lossy;
+    candidate.distance = distance;
+    candidate.effort = effort;
+
+    JxlSharedRunner runner(priority, serial);
+    runner.maxThreads = kHDREncoderMaxThreads;
+    JxlScopedMemoryArena arena;
+    auto enc = JxlEncoderMake(arena.manager());
+    if (!enc || JXL_ENC_SUCCESS != JxlEncoderSetParallelRunner(enc.get(), JxlSharedParallelRunner, &runner)) {
+        return false;
+    }
+    compressed->clear();
+    JxlVectorOutputSink output(*compressed);
+    return EncodeJxlHDRFrame(enc.get(), output, candidate, xsize, ysize, &pixels, nullptr,
+                             exifData, xmpData) && !runner.cancelled();
+}
+
+// File size for rateTargetSize, SSIM of the decoded luma for rateTargetSSIM
+static bool JxlMeasureCandidate(const std::vector<uint8_t>& compressed, const JxlRateControl& control,
+                                const std::vector<float>& sourceLuma, uint32_t xsize, uint32_t ysize,
+                                double* value) {
+    if (control.target == rateTargetSize) {
+        *value = static_cast<double>(compressed.size());
+        return true;
+    }
+    std::vector<uint8_t> decoded;
+    size_t decodedWidth = 0, decodedHeight = 0;
+    JxlColorDescription color;
+    int depth = 0, components = 0;
+    bool useFloats = false;
+    JxlExposedOrientation orientation = Identity;
+    if (!DecodeJpegXlOneShot(compressed.data(), compressed.size(), &decoded, &decodedWidth, &decodedHeight,
+                             &color, &depth, &components, &useFloats, &orientation, f32) ||
+        decodedWidth != xsize || decodedHeight != ysize) {
+        return false;
+    }
+    const size_t pixelCount = static_cast<size_t>(xsize) * ysize;
+    std::vector<float> luma(pixelCount);
+    for (size_t i = 0; i < pixelCount; ++i) {
+        float pixel[4];
+        std::memcpy(pixel, decoded.data() + i * components * sizeof(float), components * sizeof(float));
+        luma[i] = components < 3 ? pixel[0] : 0.2126f * pixel[0] + 0.7152f * pixel[1] + 0.0722f * pixel[2];
+    }
+    *value = JxlMeanSSIM(sourceLuma, luma, xsize, ysize);
+    return true;
+}
+
+static bool JxlRatePasses(const JxlRateControl& control, double value, double target) {
+    return control.target == rateTargetSize ? value <= target : value >= target;
+}
+
+// Both size and SSIM fall with distance, log size and SSIM are close to linear in log distance
+static double JxlRateAxis(const JxlRateControl& control, double value) {
+    return control.target == rateTargetSize ? std::log(std::max(value, 1.0)) : value;
+}
+
+static float JxlClampDistance(const JxlRateControl& control, double distance) {
+    return static_cast<float>(std::clamp(distance, static_cast<double>(control.minDistance),
+                                         static_cast<double>(control.maxDistance)));
+}
+
+/**
+ * Distance range still containing the target: between the two neighbouring samples on either side of it,
+ * or between the last sample and the end of the allowed range when every sample is on the same side
+ */
+static void JxlRateBracket(const JxlRateControl& control, const std::vector<JxlRateSample>& samples,
+                           double target, size_t* lower, size_t* upper) {
+    *lower = samples.size();
+    *upper = samples.size();
+    for (size_t i = 0; i + 1 < samples.size(); ++i) {
+        if (JxlRatePasses(control, samples[i].value, target) != JxlRatePasses(control, samples[i + 1].value, target)) {
+            *lower = i;
+            *upper = i + 1;
+            return;
+        }
+    }
+    if (samples.empty()) {
+        return;
+    }
+    // Size passes at large distances and SSIM at small ones, so the target lies beyond one end
+    bool passes = JxlRatePasses(control, samples.front().value, target);
+    bool belowSmallest = control.target == rateTargetSize ? passes : !passes;
+    if (belowSmallest) {
+        *upper = 0;
+    } else {
+        *lower = samples.size() - 1;
+    }
+}
+
+static float JxlPredictDistance(const JxlRateControl& control, std::vector<JxlRateSample> samples, double target) {
+    std::sort(samples.begin(), samples.end(), [](const JxlRateSample& lhs, const JxlRateSample& rhs) {
+        return lhs.distance < rhs.distance;
+    });
+    if (samples.empty()) {
+        return JxlClampDistance(control, std::sqrt(control.minDistance * control.maxDistance));
+    }
+    if (samples.size() == 1) {
+        const JxlRateSample& sample = samples.front();
+        // Bytes are roughly inversely proportional to distance, SSIM has no useful rule of thumb
+        if (control.target == rateTargetSize) {
+            return JxlClampDistance(control, sample.distance * sample.value / target);
+        }
+        bool passes = JxlRatePasses(control, sample.value, target);
+        return JxlClampDistance(control, passes ? sample.distance * 1.5 : sample.distance / 1.5);
+    }
+
+    size_t lower, upper;
+    JxlRateBracket(control, samples, target, &lower, &upper);
+    size_t first, second;
+    float fallback;
+    if (lower < samples.size() && upper < samples.size()) {
+        first = lower;
+        second = upper;
+        fallback = std::sqrt(samples[lower].distance * samples[upper].distance);
+    } else if (upper == 0) {
+        // Extrapolate below the smallest distance, which is known to pass for size and fail for SSIM
+        first = 0;
+        second = 1;
+        fallback = control.target == rateTargetSize ? samples.front().distance : control.minDistance;
+    } else {
+        first = samples.size() - 2;
+        second = samples.size() - 1;
+        fallback = control.target == rateTargetSize ? control.maxDistance : samples.back().distance;
+    }
+
+    const double x0 = std::log(samples[first].distance);
+    const double x1 = std::log(samples[second].distance);
+    const double y0 = JxlRateAxis(control, samples[first].value);
+    const double y1 = JxlRateAxis(control, samples[second].value);
+    const double slope = (y1 - y0) / (x1 - x0);
+    if (!std::isfinite(slope) || slope >= 0) {
+        return JxlClampDistance(control, fallback);
+    }
+    double distance = std::exp(x0 + (JxlRateAxis(control, target) - y0) / slope);
+    if (lower < samples.size() && upper < samples.size()) {
+        distance = std::clamp(distance, static_cast<double>(samples[lower].distance),
+                              static_cast<double>(samples[upper].distance));
+    }
+    return JxlClampDistance(control, distance);
+}
+
+static std::vector<float> JxlProbeDistances(const JxlRateControl& control, const std::vector<JxlRateSample>& samples,
+                                            double target, size_t count) {
+    std::vector<float> distances(count);
+    if (samples.empty()) {
+        // The first round spans the whole range, ends included
+        for (size_t i = 0; i < count; ++i) {
+            double position = count > 1 ? static_cast<double>(i) / (count - 1) : 0.5;
+            distances[i] = static_cast<float>(control.minDistance * std::pow(control.maxDistance / control.minDistance, position));
+        }
+        return distances;
+    }
+    std::vector<JxlRateSample> sorted = samples;
+    std::sort(sorted.begin(), sorted.end(), [](const JxlRateSample& lhs, const JxlRateSample& rhs) {
+        return lhs.distance < rhs.distance;
+    });
+    size_t lower, upper;
+    JxlRateBracket(control, sorted, target, &lower, &upper);
+    double low = lower < sorted.size() ? sorted[lower].distance : control.minDistance;
+    double high = upper < sorted.size() ? sorted[upper].distance : control.maxDistance;
+    // Later rounds split the bracket without repeating its ends
+    for (size_t i = 0; i < count; ++i) {
+        double position = static_cast<double>(i + 1) / (count + 1);
+        distances[i] = static_cast<float>(low * std::pow(high / low, position));
+    }
+    return distances;
+}
+
+bool EncodeJxlHDRRateControlled(const std::vector<uint8_t>& pixels,
+                                uint32_t xsize, uint32_t ysize,
+                                JxlOutputSink& output,
+                                const JxlEncoderProfile& profile,
+                                const JxlRateControl& control,
+                                JxlRateControlResult* result,
+                                const std::vector<uint8_t>* exifData,
+                                const std::vector<uint8_t>* xmpData,
+                                JxlRunnerPriority priority) {
+    *result = JxlRateControlResult();
+    if (control.minDistance <= 0 || control.maxDistance < control.minDistance ||
+        (control.target == rateTargetSize && control.targetBytes == 0)) {
+        return false;
+    }
+    const double target = control.target == rateTargetSize ?
+    static_cast<double>(control.targetBytes) : static_cast<double>(control.targetScore);
+    const size_t pixelCount = static_cast<size_t>(xsize) * ysize;
+    std::vector<float> sourceLuma;
+    if (control.target == rateTargetSSIM) {
+        sourceLuma = JxlSourceLuma(pixels, pixelCount, profile);
+    }
+
+    // Probes run on executor threads, the caller's cancellation is carried over to them explicitly
+    auto cancellation = JxlCancellationScope::current();
+    JxlSharedExecutor& executor = JxlSharedExecutor::shared();
+    int remaining = std::max(control.maxTrials, 2);
+
+    // One trial is kept for the final encode and one for correcting it
+    std::vector<JxlRateSample> samples;
+    while (remaining > 2 || samples.empty()) {
+        size_t count = static_cast<size_t>(std::clamp(remaining - 2, 1, 4));
+        std::vector<float> distances = JxlProbeDistances(control, samples, target, count);
+        std::vector<double> values(count);
+        std::vector<char> measured(count, 0);
+        executor.parallelFor(static_cast<uint32_t>(count), priority, [&](uint32_t index, size_t) {
+            JxlCancellationScope scope(cancellation);
+            std::vector<uint8_t> compressed;
+            // Several probes at once share the threads between them, a single one gets all of them
+            measured[index] = JxlEncodeCandidate(pixels, xsize, ysize, profile, distances[index],
+                                                 control.probeEffort, count > 1, exifData, xmpData,
+                                                 priority, &compressed) &&
+            JxlMeasureCandidate(compressed, control, sourceLuma, xsize, ysize, &values[index]);
+        });
+        if (cancellation && cancellation->isCancelled()) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (measured[i]) {
+                samples.push_back({ distances[i], values[i] });
+            }
+        }
+        remaining -= static_cast<int>(count);
+        result->trials += static_cast<int>(count);
+        if (samples.empty()) {
+            return false;
+        }
+
+        std::vector<JxlRateSample> sorted = samples;
+        std::sort(sorted.begin(), sorted.end(), [](const JxlRateSample& lhs, const JxlRateSample& rhs) {
+            return lhs.distance < rhs.distance;
+        });
+        size_t lower, upper;
+        JxlRateBracket(control, sorted, target, &lower, &upper);
+        // Another round cannot improve on a bracket this narrow
+        if (lower < sorted.size() && upper < sorted.size() &&
+            sorted[upper].distance / sorted[lower].distance < 1.05f) {
+            break;
+        }
+    }
+
+    std::vector<uint8_t> best;
+    double bestValue = 0;
+    float bestDistance = 0;
+    double probeTarget = target;
+    while (remaining > 0) {
+        float distance = JxlPredictDistance(control, samples, probeTarget);
+        std::vector<uint8_t> compressed;
+        double value = 0;
+        if (!JxlEncodeCandidate(pixels, xsize, ysize, profile, distance, profile.effort, false,
+                                exifData, xmpData, priority, &compressed) ||
+            !JxlMeasureCandidate(compressed, control, sourceLuma, xsize, ysize, &value)) {
+            return false;
+        }
+        remaining--;
+        result->trials++;
+
+        bool passes = JxlRatePasses(control, value, target);
+        bool better = best.empty() || (control.target == rateTargetSize ? value < bestValue : value > bestValue);
+        if (passes || better) {
+            best = std::move(compressed);
+            bestValue = value;
+            bestDistance = distance;
+        }
+        if (passes) {
+            result->targetMet = true;
+            break;
+        }
+        // The final effort lands off the probes by a similar amount at nearby distances,
+        // so the probe target is moved by the miss and the distance predicted again
+        if (control.target == rateTargetSize) {
+            probeTarget *= 0.98 * target / value;
+        } else {
+            probeTarget += target - value;
+        }
+    }
+
+    if (best.empty() || !output.write(0, best.data(), best.size())) {
+        return false;
+    }
+    result->distance = bestDistance;
+    result->bytes = best.size();
+    result->score = control.target == rateTargetSSIM ? static_cast<float>(bestValue) : 0;
+    return true;
+}
+
+}
@@ -0,0 +1,91 @@
+//
+//  JxlRateControl.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlRateControl_hpp
+#define JxlRateControl_hpp
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <vector>
+#include "JxlDefinitions.h"
+#include "JxlWorker.hpp"
+#include "JxlOutputSink.hpp"
+
+namespace jxlcoder {
+
+struct JxlRateControl {
+    JxlRateTarget target = rateTargetSize;
+    // Largest acceptable file for rateTargetSize, must be set
+    uint64_t targetBytes = 0;
+    // Smallest acceptable mean SSIM of the luma against the source for rateTargetSSIM, 0...1
+    float targetScore = 0.95f;
+    // Distances the search stays in
+    float minDistance = 0.1f;
+    float maxDistance = 15.0f;
+    // Effort of the probe encodes, the final encode uses the profile's effort
+    int probeEffort = 3;
+    // Every encode counts, probes and final ones, at least 2
+    int maxTrials = 6;
+};
+
+struct JxlRateControlResult {
+    // Distance of the encode that was written out
+    float distance = 0;
+    uint64_t bytes = 0;
+    // Mean SSIM of the written encode, only measured for rateTargetSSIM
+    float score = 0;
+    int trials = 0;
+    // False if no encode within maxTrials met the target, the closest one was written then
+    bool targetMet = false;
+};
+
+/**
+ * Encodes with the distance searched to meet a file size or a quality target instead of a fixed one.
+ * Rounds of probes at probeEffort run in parallel on the shared executor, each round narrows the distance range
+ * around the target. The final distance is interpolated from the probes that bracket the target: log size
+ * or SSIM against log distance. The final encode then uses the profile's effort. If it misses the target
+ * while trials remain, the difference between final and probe effort is folded into the target and the
+ * distance is predicted again.
+ * Rate control is always lossy, the profile's compression option and distance are ignored.
+ * The accepted encode is buffered and written to output at the end.
+ * @return false for invalid control settings or if encoding failed or was cancelled,
+ * a missed target is reported in result
+ */
+bool EncodeJxlHDRRateControlled(const std::vector<uint8_t>& pixels,
+                                uint32_t xsize, uint32_t ysize,
+                                JxlOutputSink& output,
+                                const JxlEncoderProfile& profile,
+                                const JxlRateControl& control,
+                                JxlRateControlResult* result,
+                                const std::vector<uint8_t>* exifData = nullptr,
+                                const std::vector<uint8_t>* xmpData = nullptr,
+                                JxlRunnerPriority priority = runnerNormal);
+
+}
+
+#endif
+
+#endif /* JxlRateControl_hpp */
@@ -0,0 +1,186 @@
+//
+//  JxlRowPipeline.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlRowPipeline.hpp"
+#include <algorithm>
+#include <cstring>
+#include "half.hpp"
+#include "algo/premultiply.hpp"
+
+namespace jxlcoder {
+
+size_t JxlSampleSize(JxlDataType type) {
+    switch (type) {
+        case JXL_TYPE_UINT8:
+            return sizeof(uint8_t);
+        case JXL_TYPE_UINT16:
+        case JXL_TYPE_FLOAT16:
+            return sizeof(uint16_t);
+        case JXL_TYPE_FLOAT:
+            return sizeof(float);
+    }
+    return sizeof(uint8_t);
+}
+
+uint32_t JxlDropAlphaStage::outputComponents(uint32_t inputComponents) const {
+    return (inputComponents == 4 || inputComponents == 2) ? inputComponents - 1 : inputComponents;
+}
+
+void JxlDropAlphaStage::process(const uint8_t* src, uint8_t* dst, size_t numPixels,
+                                uint32_t inputComponents, JxlDataType type) const {
+    const size_t sampleSize = JxlSampleSize(type);
+    const size_t inputPixelSize = inputComponents * sampleSize;
+    const size_t outputPixelSize = outputComponents(inputComponents) * sampleSize;
+    for (size_t i = 0; i < numPixels; ++i) {
+        std::memcpy(dst, src, outputPixelSize);
+        src += inputPixelSize;
+        dst += outputPixelSize;
+    }
+}
+
+void JxlPremultiplyStage::process(const uint8_t* src, uint8_t* dst, size_t numPixels,
+                                  uint32_t inputComponents, JxlDataType type) const {
+    if (inputComponents != 4) {
+        std::memcpy(dst, src, numPixels * inputComponents * JxlSampleSize(type));
+        return;
+    }
+    switch (type) {
+        case JXL_TYPE_UINT8:
+            PremultiplyRgba8(src, dst, numPixels);
+            break;
+        case JXL_TYPE_UINT16:
+            PremultiplyRgba16(reinterpret_cast<const uint16_t*>(src),
+                              reinterpret_cast<uint16_t*>(dst), numPixels);
+            break;
+        case JXL_TYPE_FLOAT: {
+            auto s = reinterpret_cast<const float*>(src);
+            auto d = reinterpret_cast<float*>(dst);
+            for (size_t i = 0; i < numPixels; ++i) {
+                const float alpha = s[3];
+                d[0] = s[0] * alpha;
+                d[1] = s[1] * alpha;
+                d[2] = s[2] * alpha;
+                d[3] = alpha;
+                s += 4;
+                d += 4;
+            }
+        }
+            break;
+        case JXL_TYPE_FLOAT16: {
+            auto s = reinterpret_cast<const half_float::half*>(src);
+            auto d = reinterpret_cast<half_float::half*>(dst);
+            for (size_t i = 0; i < numPixels; ++i) {
+                const float alpha = s[3];
+                d[0] = half_float::half(float(s[0]) * alpha);
+                d[1] = half_float::half(float(s[1]) * alpha);
+                d[2] = half_float::half(float(s[2]) * alpha);
+                d[3] = s[3];
+                s += 4;
+                d += 4;
+            }
+        }
+            break;
+    }
+}
+
+void JxlSwizzleStage::process(const uint8_t* src, uint8_t* dst, size_t numPixels,
+                              uint32_t inputComponents, JxlDataType type) const {
+    const size_t sampleSize = JxlSampleSize(type);
+    if (inputComponents != 4) {
+        std::memcpy(dst, src, numPixels * inputComponents * sampleSize);
+        return;
+    }
+    const size_t pixelSize = 4 * sampleSize;
+    for (size_t i = 0; i < numPixels; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            std::memcpy(dst + c * sampleSize, src + order[c] * sampleSize, sampleSize);
+        }
+        src += pixelSize;
+        dst += pixelSize;
+    }
+}
+
+uint32_t JxlRowPipeline::outputComponents(uint32_t inputComponents) const {
+    uint32_t components = inputComponents;
+    for (const auto& stage : stages) {
+        components = stage->outputComponents(components);
+    }
+    return components;
+}
+
+void JxlRowPipeline::run(const uint8_t* src, uint8_t* dst, size_t numPixels, uint32_t inputComponents,
+                         JxlDataType type, uint8_t* scratch, size_t scratchHalf) const {
+    if (stages.empty()) {
+        std::memcpy(dst, src, numPixels * inputComponents * JxlSampleSize(type));
+        return;
+    }
+    uint32_t components = inputComponents;
+    const uint8_t* current = src;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        // The last stage writes straight into the destination, the others ping-pong between scratch halves
+        uint8_t* target = i + 1 == stages.size() ? dst : scratch + (i % 2) * scratchHalf;
+        stages[i]->process(current, target, numPixels, components, type);
+        components = stages[i]->outputComponents(components);
+        current = target;
+    }
+}
+
+JxlDecoderStatus JxlPipelineOutput::attach(JxlDecoder* dec, const JxlPixelFormat& format,
+                                           uint8_t* destination, size_t rowStride) {
+    this->inputComponents = format.num_channels;
+    this->outputComponents = pipeline.outputComponents(format.num_channels);
+    this->type = format.data_type;
+    this->destination = destination;
+    this->rowStride = rowStride;
+    JxlPixelFormat callbackFormat = format;
+    callbackFormat.align = 0;
+    return JxlDecoderSetMultithreadedImageOutCallback(dec, &callbackFormat, init, run, destroy, this);
+}
+
+void* JxlPipelineOutput::init(void *opaque, size_t numThreads, size_t numPixelsPerThread) {
+    auto output = static_cast<JxlPipelineOutput*>(opaque);
+    // Stages never widen pixels past 4 components, so two halves of that size cover any intermediate
+    output->scratchHalf = numPixelsPerThread * std::max<uint32_t>(output->inputComponents, 4)
+    * JxlSampleSize(output->type);
+    output->scratch.resize(numThreads);
+    for (auto& threadScratch : output->scratch) {
+        threadScratch.resize(output->scratchHalf * 2);
+    }
+    return opaque;
+}
+
+void JxlPipelineOutput::run(void *opaque, size_t threadId, size_t x, size_t y, size_t numPixels, const void *pixels) {
+    auto output = static_cast<JxlPipelineOutput*>(opaque);
+    uint8_t* dst = output->destination + y * output->rowStride
+    + x * output->outputComponents * JxlSampleSize(output->type);
+    output->pipeline.run(static_cast<const uint8_t*>(pixels), dst, numPixels,
+                         output->inputComponents, output->type,
+                         output->scratch[threadId].data(), output->scratchHalf);
+}
+
+void JxlPipelineOutput::destroy(void *) {
+}
+
+}
@@ -0,0 +1,162 @@
+//
+//  JxlRowPipeline.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlRowPipeline_hpp
+#define JxlRowPipeline_hpp
+
+#ifdef __cplusplus
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <jxl/decode.h>
+#include <jxl/types.h>
+
+namespace jxlcoder {
+
+/**
+ * One transform applied to decoded pixels while the row is still hot in cache.
+ * Stages only see runs of pixels of a single row, so they must not depend on neighbouring rows.
+ */
+class JxlRowStage {
+public:
+    virtual ~JxlRowStage() = default;
+
+    /**
+     * Components per pixel this stage produces out of inputComponents
+     */
+    virtual uint32_t outputComponents(uint32_t inputComponents) const {
+        return inputComponents;
+    }
+
+    /**
+     * Transforms numPixels pixels from src into dst, they never alias.
+     */
+    virtual void process(const uint8_t* src, uint8_t* dst, size_t numPixels,
+                         uint32_t inputComponents, JxlDataType type) const = 0;
+};
+
+/**
+ * RGBA to RGB, GA to G
+ */
+class JxlDropAlphaStage : public JxlRowStage {
+public:
+    uint32_t outputComponents(uint32_t inputComponents) const override;
+    void process(const uint8_t* src, uint8_t* dst, size_t numPixels,
+                 uint32_t inputComponents, JxlDataType type) const override;
+};
+
+/**
+ * Multiplies color by alpha, for 4 component images only. Integer samples go through the SIMD kernel
+ * in algo/premultiply, rounded exactly without dividing
+ */
+class JxlPremultiplyStage : public JxlRowStage {
+public:
+    void process(const uint8_t* src, uint8_t* dst, size_t numPixels,
+                 uint32_t inputComponents, JxlDataType type) const override;
+};
+
+/**
+ * Reorders 4 component pixels, output component i takes input component order[i], e.g. {2, 1, 0, 3} for BGRA
+ */
+class JxlSwizzleStage : public JxlRowStage {
+public:
+    explicit JxlSwizzleStage(std::array<uint8_t, 4> order) : order(order) {}
+
+    void process(const uint8_t* src, uint8_t* dst, size_t numPixels,
+                 uint32_t inputComponents, JxlDataType type) const override;
+
+private:
+    std::array<uint8_t, 4> order;
+};
+
+/**
+ * Chain of stages run from libjxl's multithreaded image out callback.
+ * Rows go through every stage in per thread scratch buffers and are written once, at their oriented
+ * position, into the destination, so memory traffic is a single pass over the image however many stages there are.
+ */
+class JxlRowPipeline {
+public:
+    JxlRowPipeline& add(std::shared_ptr<JxlRowStage> stage) {
+        stages.push_back(std::move(stage));
+        return *this;
+    }
+
+    JxlRowPipeline& append(const JxlRowPipeline& other) {
+        stages.insert(stages.end(), other.stages.begin(), other.stages.end());
+        return *this;
+    }
+
+    bool empty() const {
+        return stages.empty();
+    }
+
+    uint32_t outputComponents(uint32_t inputComponents) const;
+
+    /**
+     * Runs every stage on a run of pixels, writing the result to dst.
+     * scratch must hold numPixels pixels of the widest intermediate format twice.
+     */
+    void run(const uint8_t* src, uint8_t* dst, size_t numPixels, uint32_t inputComponents,
+             JxlDataType type, uint8_t* scratch, size_t scratchHalf) const;
+
+private:
+    std::vector<std::shared_ptr<JxlRowStage>> stages;
+};
+
+/**
+ * Routes a decoder's output through a pipeline into a destination buffer with the given row stride.
+ * Must outlive the decoding it is attached to.
+ */
+class JxlPipelineOutput {
+public:
+    explicit JxlPipelineOutput(const JxlRowPipeline& pipeline) : pipeline(pipeline) {}
+
+    JxlDecoderStatus attach(JxlDecoder* dec, const JxlPixelFormat& format,
+                            uint8_t* destination, size_t rowStride);
+
+private:
+    static void* init(void *opaque, size_t numThreads, size_t numPixelsPerThread);
+    static void run(void *opaque, size_t threadId, size_t x, size_t y, size_t numPixels, const void *pixels);
+    static void destroy(void *opaque);
+
+    const JxlRowPipeline& pipeline;
+    uint32_t inputComponents = 0;
+    uint32_t outputComponents = 0;
+    JxlDataType type = JXL_TYPE_UINT8;
+    uint8_t* destination = nullptr;
+    size_t rowStride = 0;
+    size_t scratchHalf = 0;
+    std::vector<std::vector<uint8_t>> scratch;
+};
+
+size_t JxlSampleSize(JxlDataType type);
+
+}
+
+#endif
+
+#endif /* JxlRowPipeline_hpp */
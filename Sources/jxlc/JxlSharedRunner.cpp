@@ -0,0 +1,270 @@
+//
+//  JxlSharedRunner.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#include "JxlSharedRunner.hpp"
+#include <algorithm>
+
+namespace jxlcoder {
+
+static thread_local bool isExecutorThread = false;
+
+JxlSharedExecutor& JxlSharedExecutor::shared() {
+    static JxlSharedExecutor executor(std::max(std::thread::hardware_concurrency(), 1u));
+    return executor;
+}
+
+JxlSharedExecutor::JxlSharedExecutor(size_t threads) : targetThreads(std::max(threads, size_t(1))) {
+    for (size_t i = 0; i < targetThreads; ++i) {
+        workers.emplace_back(&JxlSharedExecutor::workerLoop, this, i);
+    }
+}
+
+JxlSharedExecutor::~JxlSharedExecutor() {
+    {
+        std::lock_guard guard(lock);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& worker: workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void JxlSharedExecutor::setMaxThreads(size_t threads) {
+    threads = std::max(threads, size_t(1));
+    std::vector<std::thread> retired;
+    {
+        std::lock_guard guard(lock);
+        targetThreads = threads;
+        while (workers.size() < targetThreads) {
+            workers.emplace_back(&JxlSharedExecutor::workerLoop, this, workers.size());
+        }
+        while (workers.size() > targetThreads) {
+            retired.push_back(std::move(workers.back()));
+            workers.pop_back();
+        }
+    }
+    available.notify_all();
+    for (auto& worker: retired) {
+        worker.join();
+    }
+}
+
+size_t JxlSharedExecutor::getMaxThreads() {
+    std::lock_guard guard(lock);
+    return targetThreads;
+}
+
+JxlSharedExecutor::Job* JxlSharedExecutor::pickJob() {
+    // Queue is kept ordered by priority, then by submission order
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        Job* job = *it;
+        if (job->claimedSlots < job->maxSlots && job->next.load(std::memory_order_relaxed) < job->end) {
+            job->claimedSlots += 1;
+            if (job->claimedSlots == job->maxSlots) {
+                queue.erase(it);
+            }
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JxlSharedExecutor::workerLoop(size_t id) {
+    isExecutorThread = true;
+    for (;;) {
+        Job* job = nullptr;
+        size_t slot = 0;
+        {
+            std::unique_lock guard(lock);
+            available.wait(guard, [&] {
+                return stopping || id >= targetThreads || (job = pickJob()) != nullptr;
+            });
+            if (!job) {
+                return;
+            }
+            slot = job->claimedSlots - 1;
+            std::lock_guard jobGuard(job->lock);
+            job->active += 1;
+        }
+        execute(job, slot);
+    }
+}
+
+void JxlSharedExecutor::execute(Job* job, size_t slot) {
+    uint32_t done = 0;
+    for (;;) {
+        if (job->cancellation && job->cancellation->isCancelled()) {
+            // Claim everything that is left, so the job completes without running it
+            uint32_t value = job->next.exchange(job->end, std::memory_order_relaxed);
+            if (value < job->end) {
+                done += job->end - value;
+            }
+            job->cancelled.store(true, std::memory_order_relaxed);
+            break;
+        }
+        uint32_t value = job->next.fetch_add(1, std::memory_order_relaxed);
+        if (value >= job->end) {
+            break;
+        }
+        job->func(job->opaque, value, slot);
+        done += 1;
+    }
+    std::lock_guard jobGuard(job->lock);
+    job->active -= 1;
+    job->completed.fetch_add(done, std::memory_order_acq_rel);
+    job->finished.notify_all();
+}
+
+JxlParallelRetCode JxlSharedExecutor::run(void* opaque, JxlParallelRunInit init, JxlParallelRunFunction func,
+                                          uint32_t start, uint32_t end, JxlRunnerPriority priority,
+                                          const JxlCancellationToken* cancellation,
+                                          size_t maxThreads) {
+    if (cancellation && cancellation->isCancelled()) {
+        return JXL_PARALLEL_RET_RUNNER_ERROR;
+    }
+    if (end <= start) {
+        if (init) {
+            return init(opaque, 1);
+        }
+        return 0;
+    }
+    const uint32_t count = end - start;
+    size_t slots = std::min(static_cast<size_t>(count), getMaxThreads());
+    if (maxThreads > 0) {
+        slots = std::min(slots, maxThreads);
+    }
+
+    if (init) {
+        JxlParallelRetCode initResult = init(opaque, slots);
+        if (initResult != 0) {
+            return initResult;
+        }
+    }
+
+    // Single item jobs are cheaper to run in place than to hand over to another thread
+    if (count == 1 || slots == 1) {
+        for (uint32_t value = start; value < end; ++value) {
+            if (cancellation && cancellation->isCancelled()) {
+                return JXL_PARALLEL_RET_RUNNER_ERROR;
+            }
+            func(opaque, value, 0);
+        }
+        return 0;
+    }
+
+    Job job;
+    job.opaque = opaque;
+    job.func = func;
+    job.end = end;
+    job.count = count;
+    job.maxSlots = slots;
+    job.priority = static_cast<int>(priority);
+    job.next.store(start, std::memory_order_relaxed);
+    job.completed.store(0, std::memory_order_relaxed);
+    job.cancellation = cancellation;
+
+    const bool participate = isExecutorThread;
+    {
+        std::lock_guard guard(lock);
+        job.sequence = sequence++;
+        if (participate) {
+            job.claimedSlots = 1;
+            job.active = 1;
+        }
+        auto position = std::find_if(queue.begin(), queue.end(), [&](Job* other) {
+            return other->priority < job.priority;
+        });
+        queue.insert(position, &job);
+    }
+    available.notify_all();
+
+    if (participate) {
+        execute(&job, 0);
+    }
+
+    {
+        std::unique_lock jobGuard(job.lock);
+        job.finished.wait(jobGuard, [&] {
+            return job.completed.load(std::memory_order_acquire) == job.count;
+        });
+    }
+
+    // No new participant can join after the job has left the queue,
+    // then wait for the ones that are still running out of the loop
+    {
+        std::lock_guard guard(lock);
+        auto position = std::find(queue.begin(), queue.end(), &job);
+        if (position != queue.end()) {
+            queue.erase(position);
+        }
+    }
+    std::unique_lock jobGuard(job.lock);
+    job.finished.wait(jobGuard, [&] {
+        return job.active == 0;
+    });
+    return job.cancelled.load(std::memory_order_relaxed) ? JXL_PARALLEL_RET_RUNNER_ERROR : 0;
+}
+
+static void JxlExecutorFunctionTrampoline(void* opaque, uint32_t value, size_t threadId) {
+    auto func = static_cast<const std::function<void(uint32_t, size_t)>*>(opaque);
+    (*func)(value, threadId);
+}
+
+void JxlSharedExecutor::parallelFor(uint32_t count, JxlRunnerPriority priority,
+                                    const std::function<void(uint32_t, size_t)>& func) {
+    run(const_cast<std::function<void(uint32_t, size_t)>*>(&func), nullptr,
+        JxlExecutorFunctionTrampoline, 0, count, priority);
+}
+
+JxlParallelRetCode JxlSharedParallelRunner(void* runnerOpaque, void* jpegxlOpaque,
+                                           JxlParallelRunInit init, JxlParallelRunFunction func,
+                                           uint32_t startRange, uint32_t endRange) {
+    auto runner = static_cast<JxlSharedRunner*>(runnerOpaque);
+    if (runner && runner->serial) {
+        if (init) {
+            JxlParallelRetCode initResult = init(jpegxlOpaque, 1);
+            if (initResult != 0) {
+                return initResult;
+            }
+        }
+        for (uint32_t value = startRange; value < endRange; ++value) {
+            if (runner->cancelled()) {
+                return JXL_PARALLEL_RET_RUNNER_ERROR;
+            }
+            func(jpegxlOpaque, value, 0);
+        }
+        return 0;
+    }
+    JxlRunnerPriority priority = runner ? runner->priority : runnerNormal;
+    const JxlCancellationToken* cancellation = runner ? runner->cancellation.get() : nullptr;
+    size_t maxThreads = runner ? runner->maxThreads : 0;
+    return JxlSharedExecutor::shared().run(jpegxlOpaque, init, func, startRange, endRange, priority,
+                                           cancellation, maxThreads);
+}
+
+}
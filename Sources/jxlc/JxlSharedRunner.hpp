@@ -0,0 +1,150 @@
+//
+//  JxlSharedRunner.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#ifndef JxlSharedRunner_hpp
+#define JxlSharedRunner_hpp
+
+#ifdef __cplusplus
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <jxl/parallel_runner.h>
+#include "JxlDefinitions.h"
+#include "JxlCancellation.hpp"
+
+namespace jxlcoder {
+
+/**
+ * Process-wide thread pool shared by every encoder and decoder.
+ * The amount of worker threads is capped globally, so concurrent codec calls queue their work
+ * by priority instead of each spawning a thread per core.
+ */
+class JxlSharedExecutor {
+public:
+    static JxlSharedExecutor& shared();
+
+    /**
+     * Changes the global thread cap. Must not be called from a task running on the executor.
+     */
+    void setMaxThreads(size_t threads);
+    size_t getMaxThreads();
+
+    /**
+     * Calls func for every value in [start, end) on the executor threads and blocks until all of them are done.
+     * The caller thread only takes part in the work when it is an executor thread itself,
+     * so the total amount of busy threads never exceeds the cap.
+     *
+     * @param init same contract as JxlParallelRunInit, may be nullptr
+     * @param cancellation checked before every value, once cancelled the remaining values are skipped
+     * @param maxThreads threads working on this call at most, 0 for the executor cap
+     * @return 0 on success, the error code returned by init, or JXL_PARALLEL_RET_RUNNER_ERROR if cancelled
+     */
+    JxlParallelRetCode run(void* opaque, JxlParallelRunInit init, JxlParallelRunFunction func,
+                           uint32_t start, uint32_t end, JxlRunnerPriority priority,
+                           const JxlCancellationToken* cancellation = nullptr,
+                           size_t maxThreads = 0);
+
+    /**
+     * Convenience wrapper over run for plain C++ tasks, func receives index and thread slot
+     */
+    void parallelFor(uint32_t count, JxlRunnerPriority priority,
+                     const std::function<void(uint32_t, size_t)>& func);
+
+    ~JxlSharedExecutor();
+
+private:
+    struct Job {
+        void* opaque;
+        JxlParallelRunFunction func;
+        uint32_t end;
+        uint32_t count;
+        size_t maxSlots;
+        size_t claimedSlots = 0;
+        int priority;
+        uint64_t sequence;
+        std::atomic<uint32_t> next;
+        std::atomic<uint32_t> completed;
+        const JxlCancellationToken* cancellation = nullptr;
+        std::atomic<bool> cancelled{false};
+        int active = 0;
+        std::mutex lock;
+        std::condition_variable finished;
+    };
+
+    explicit JxlSharedExecutor(size_t threads);
+
+    void workerLoop(size_t id);
+    Job* pickJob();
+    void execute(Job* job, size_t slot);
+
+    std::mutex lock;
+    std::condition_variable available;
+    std::vector<Job*> queue;
+    std::vector<std::thread> workers;
+    size_t targetThreads;
+    uint64_t sequence = 0;
+    bool stopping = false;
+};
+
+/**
+ * Runner opaque that carries the per-call options into JxlSharedParallelRunner.
+ * Must outlive the encoder or decoder it was attached to.
+ */
+struct JxlSharedRunner {
+    JxlSharedRunner() : priority(runnerNormal) {}
+    explicit JxlSharedRunner(JxlRunnerPriority priority) : priority(priority) {}
+    JxlSharedRunner(JxlRunnerPriority priority, bool serial) : priority(priority), serial(serial) {}
+    JxlRunnerPriority priority;
+    // Runs every parallel section on the calling thread, for callers that already parallelize across images
+    bool serial = false;
+    // Threads a single parallel section may use, 0 for the executor cap
+    size_t maxThreads = 0;
+    // Taken from the JxlCancellationScope of the thread creating the runner
+    std::shared_ptr<JxlCancellationToken> cancellation = JxlCancellationScope::current();
+
+    bool cancelled() const {
+        return cancellation && cancellation->isCancelled();
+    }
+};
+
+/**
+ * JxlParallelRunner implementation backed by JxlSharedExecutor,
+ * runner_opaque must point to JxlSharedRunner.
+ */
+JxlParallelRetCode JxlSharedParallelRunner(void* runnerOpaque, void* jpegxlOpaque,
+                                           JxlParallelRunInit init, JxlParallelRunFunction func,
+                                           uint32_t startRange, uint32_t endRange);
+
+}
+
+#endif
+
+#endif /* JxlSharedRunner_hpp */
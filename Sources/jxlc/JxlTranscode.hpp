@@ -29,24 +29,41 @@
 
 #include "jxl/encode.h"
 #include "jxl/encode_cxx.h"
-#include "jxl/thread_parallel_runner.h"
-#include "jxl/thread_parallel_runner_cxx.h"
+#include "JxlSharedRunner.hpp"
+#include "JxlMemoryArena.hpp"
+#include "JxlOutputSink.hpp"
 #include <vector>
 
 namespace jxlcoder {
 class JxlConstruction {
  public:
-  JxlConstruction(std::vector<uint8_t> &data) : jpegData(data) {
+  JxlConstruction(std::vector<uint8_t> &data, JxlRunnerPriority priority = runnerNormal) : jpegData(data),
+  runner(priority) {
 
   }
 
   bool construct() {
-    auto enc = JxlEncoderMake(nullptr);
-    auto runner = JxlThreadParallelRunnerMake(nullptr,
-                                              JxlThreadParallelRunnerDefaultNumWorkerThreads());
+    compressed.clear();
+    JxlVectorOutputSink output(compressed);
+    return construct(output);
+  }
+
+  /**
+   * Writes the transcoded file to the sink while it is produced, getCompressedData stays empty
+   */
+  bool construct(JxlOutputSink& output) {
+    // The object may be created long before it is used, cancellation is taken from whoever calls
+    runner.cancellation = JxlCancellationScope::current();
+    JxlScopedMemoryArena arena;
+    JxlOutputWriter writer(output);
+    auto enc = JxlEncoderMake(arena.manager());
     if (JXL_ENC_SUCCESS != JxlEncoderSetParallelRunner(enc.get(),
-                                                       JxlThreadParallelRunner,
-                                                       runner.get())) {
+                                                       JxlSharedParallelRunner,
+                                                       &runner)) {
+      return false;
+    }
+
+    if (!writer.attach(enc.get())) {
       return false;
     }
 
@@ -76,23 +93,7 @@ class JxlConstruction {
       return false;
     }
 
-    JxlEncoderCloseInput(enc.get());
-
-    compressed.resize(64);
-    uint8_t *next_out = compressed.data();
-    size_t avail_out = compressed.size() - (next_out - compressed.data());
-    JxlEncoderStatus process_result = JXL_ENC_NEED_MORE_OUTPUT;
-    while (process_result == JXL_ENC_NEED_MORE_OUTPUT) {
-      process_result = JxlEncoderProcessOutput(enc.get(), &next_out, &avail_out);
-      if (process_result == JXL_ENC_NEED_MORE_OUTPUT) {
-        size_t offset = next_out - compressed.data();
-        compressed.resize(compressed.size() * 2);
-        next_out = compressed.data() + offset;
-        avail_out = compressed.size() - offset;
-      }
-    }
-    compressed.resize(next_out - compressed.data());
-    if (JXL_ENC_SUCCESS != process_result) {
+    if (!writer.finish(enc.get()) || runner.cancelled()) {
       return false;
     }
 
@@ -105,6 +106,7 @@ class JxlConstruction {
 
  private:
   const std::vector<uint8_t> jpegData;
+  JxlSharedRunner runner;
   std::vector<uint8_t> compressed;
 };
 }
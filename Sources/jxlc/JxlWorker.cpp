@@ -24,134 +24,145 @@
 //
 
 #include "JxlWorker.hpp"
+#include "JxlDecoderPool.hpp"
 #include <jxl/decode.h>
 #include <jxl/decode_cxx.h>
-#include <jxl/resizable_parallel_runner.h>
-#include <jxl/resizable_parallel_runner_cxx.h>
+#include <jxl/cms.h>
 #include <jxl/encode.h>
 #include <jxl/encode_cxx.h>
-#include <jxl/thread_parallel_runner_cxx.h>
+#include "JxlSharedRunner.hpp"
+#include "JxlRowPipeline.hpp"
+#include "JxlMemoryArena.hpp"
+#include "JxlBoxCollector.hpp"
+#include "JxlOutputSink.hpp"
+#include "JxlPixelSource.hpp"
+#include "algo/orientation.hpp"
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 bool DecodeJpegXlOneShot(const uint8_t *jxl, size_t size,
                          std::vector<uint8_t> *pixels, size_t *xsize,
                          size_t *ysize,
-                         std::vector<uint8_t> *iccProfile,
+                         JxlColorDescription *color,
                          int* depth,
                          int* components,
                          bool* useFloats,
                          JxlExposedOrientation* exposedOrientation,
-                         JxlDecodingPixelFormat pixelFormat) {
-    // Multi-threaded parallel runner.
-    auto runner = JxlResizableParallelRunnerMake(nullptr);
+                         JxlDecodingPixelFormat pixelFormat,
+                         const JxlDecodeOptions& options) {
+    jxlcoder::JxlMemoryByteSource source(jxl, size);
+    return DecodeJpegXlStream(source, pixels, xsize, ysize, color,
+                              depth, components, useFloats, exposedOrientation,
+                              pixelFormat, options);
+}
 
-    auto dec = JxlDecoderMake(nullptr);
+bool DecodeJpegXlStream(jxlcoder::JxlByteSource& source,
+                        std::vector<uint8_t> *pixels, size_t *xsize,
+                        size_t *ysize,
+                        JxlColorDescription *color,
+                        int* depth,
+                        int* components,
+                        bool* useFloats,
+                        JxlExposedOrientation* exposedOrientation,
+                        JxlDecodingPixelFormat pixelFormat,
+                        const JxlDecodeOptions& options) {
+    const bool premultiplyAlpha = options.premultiplyAlpha;
+    jxlcoder::JxlBoxCollector* boxes = options.boxes;
+    jxlcoder::JxlSharedRunner runner(options.priority);
+    auto lease = jxlcoder::JxlDecoderPool::shared().acquire();
+    if (!lease) {
+        return false;
+    }
+    JxlDecoder* dec = lease.decoder();
     if (JXL_DEC_SUCCESS !=
-        JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_BASIC_INFO |
+        JxlDecoderSubscribeEvents(dec, JXL_DEC_BASIC_INFO |
                                   JXL_DEC_COLOR_ENCODING |
-                                  JXL_DEC_FULL_IMAGE)) {
+                                  JXL_DEC_FULL_IMAGE |
+                                  (boxes ? JXL_DEC_BOX : 0))) {
+        return false;
+    }
+    // Metadata boxes are collected in the same pass as the pixels
+    if (boxes && !boxes->attach(dec)) {
         return false;
     }
 
-    if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec.get(),
-                                                       JxlResizableParallelRunner,
-                                                       runner.get())) {
+    // Multi-threaded work goes to the process-wide executor
+    if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec,
+                                                       jxlcoder::JxlSharedParallelRunner,
+                                                       &runner)) {
         return false;
     }
-    
-    if (JXL_DEC_SUCCESS != JxlDecoderSetUnpremultiplyAlpha(dec.get(), JXL_TRUE)) {
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetUnpremultiplyAlpha(dec, premultiplyAlpha ? JXL_FALSE : JXL_TRUE)) {
         return false;
     }
 
     JxlBasicInfo info;
-    JxlPixelFormat format;
-    if (pixelFormat == optimal) {
-        format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
-    } else {
-        if (pixelFormat == r16) {
-            format = {4, JXL_TYPE_UINT16, JXL_NATIVE_ENDIAN, 0};
-        } else if (pixelFormat == r8) {
-            format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
-        }
-    }
+    JxlPixelFormat format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+    jxlcoder::JxlRowPipeline premultiply;
+    jxlcoder::JxlPipelineOutput output(premultiply);
 
-    JxlDecoderSetInput(dec.get(), jxl, size);
-    JxlDecoderCloseInput(dec.get());
-    int bitDepth = 8;
+    jxlcoder::JxlInputFeeder feeder(source);
+    if (!feeder.feed(dec)) {
+        return false;
+    }
     *useFloats = false;
-    bool hdrImage = false;
 
     for (;;) {
-        JxlDecoderStatus status = JxlDecoderProcessInput(dec.get());
+        // Lets abandoned work stop between steps, the runner stops it inside of them
+        if (runner.cancelled()) {
+            return false;
+        }
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec);
 
         if (status == JXL_DEC_ERROR) {
             return false;
         } else if (status == JXL_DEC_NEED_MORE_INPUT) {
-            return false;
-        } else if (status == JXL_DEC_BASIC_INFO) {
-            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec.get(), &info)) {
+            // Pull the next chunk, libjxl decodes whatever groups are complete in the meantime
+            if (!feeder.feed(dec)) {
                 return false;
             }
-            *xsize = info.xsize;
-            *ysize = info.ysize;
-            bitDepth = info.bits_per_sample;
-            *depth = info.bits_per_sample;
-            int baseComponents = info.num_color_channels;
-            if (info.num_extra_channels > 0) {
-                baseComponents = 4;
+        } else if (status == JXL_DEC_BASIC_INFO) {
+            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec, &info)) {
+                return false;
             }
-            *components = baseComponents;
+            // Pixels come out already oriented, so rows are as wide as the displayed image
+            bool transposed = info.orientation >= JXL_ORIENT_TRANSPOSE;
+            *xsize = transposed ? info.ysize : info.xsize;
+            *ysize = transposed ? info.xsize : info.ysize;
             *exposedOrientation = static_cast<JxlExposedOrientation>(info.orientation);
-            if (bitDepth > 8 && pixelFormat == optimal) {
-                *useFloats = true;
-                hdrImage = true;
-                format = { static_cast<uint32_t>(baseComponents), JXL_TYPE_UINT16, JXL_NATIVE_ENDIAN, 0 };
-            } else if (pixelFormat == r16) {
-                *useFloats = true;
-                hdrImage = true;
-                format = { static_cast<uint32_t>(baseComponents), JXL_TYPE_UINT16, JXL_NATIVE_ENDIAN, 0 };
-            } else {
-                if (pixelFormat == r8) {
-                    *depth = 8;
-                }
-                format.num_channels = baseComponents;
-                *useFloats = false;
+            JxlResolveOutputFormat(info, pixelFormat, &format, depth, components, useFloats);
+            if (premultiplyAlpha && info.alpha_bits > 0 && !info.alpha_premultiplied && format.num_channels == 4) {
+                premultiply.add(std::make_shared<jxlcoder::JxlPremultiplyStage>());
             }
-            JxlResizableParallelRunnerSetThreads(
-                                                 runner.get(),
-                                                 JxlResizableParallelRunnerSuggestThreads(info.xsize, info.ysize));
         } else if (status == JXL_DEC_COLOR_ENCODING) {
-            // Get the ICC color profile of the pixel data
-
-            //            JxlColorEncoding colorEncoding;
-            //            if (JXL_DEC_SUCCESS != JxlDecoderGetColorAsEncodedProfile(dec.get(), JXL_COLOR_PROFILE_TARGET_DATA, &colorEncoding)) {
-            //                return false;
-            //            }
-            
-            size_t iccSize;
-            if (JXL_DEC_SUCCESS ==
-                JxlDecoderGetICCProfileSize(dec.get(), JXL_COLOR_PROFILE_TARGET_DATA, &iccSize)) {
-                iccProfile->resize(iccSize);
-                if (JXL_DEC_SUCCESS != JxlDecoderGetColorAsICCProfile(dec.get(), JXL_COLOR_PROFILE_TARGET_DATA,
-                                                                      iccProfile->data(), iccProfile->size())) {
-                                                                          return false;
-                                                                      }
-            } else {
-                iccProfile->resize(0);
+            // Describe the color of the pixel data, ICC bytes are only read when an enum can't do it
+            if (!JxlReadOutputColor(dec, format, color)) {
+                return false;
             }
         } else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
             size_t buffer_size;
             if (JXL_DEC_SUCCESS !=
-                JxlDecoderImageOutBufferSize(dec.get(), &format, &buffer_size)) {
+                JxlDecoderImageOutBufferSize(dec, &format, &buffer_size)) {
                 return false;
             }
-            if (buffer_size != *xsize * *ysize * (*components) * (hdrImage ? sizeof(uint16_t) : sizeof(uint8_t))) {
+            const size_t sampleSize = jxlcoder::JxlSampleSize(format.data_type);
+            if (buffer_size != *xsize * *ysize * (*components) * sampleSize) {
                 return false;
             }
-            pixels->resize(*xsize * *ysize * (*components) * (hdrImage ? sizeof(uint16_t) : sizeof(uint8_t)));
+            pixels->resize(*xsize * *ysize * (*components) * sampleSize);
             void *pixelsBuffer = (void *) pixels->data();
 
-            if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutBuffer(dec.get(),
+            if (!premultiply.empty()) {
+                if (JXL_DEC_SUCCESS != output.attach(dec, format, pixels->data(),
+                                                     *xsize * (*components) * sampleSize)) {
+                    return false;
+                }
+                continue;
+            }
+
+            if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutBuffer(dec,
                                                                &format,
                                                                pixelsBuffer,
                                                                pixels->size())) {
@@ -160,10 +171,20 @@ bool DecodeJpegXlOneShot(const uint8_t *jxl, size_t size,
         } else if (status == JXL_DEC_FULL_IMAGE) {
             // Nothing to do. Do not yet return. If the image is an animation, more
             // full frames may be decoded. This example only keeps the last one.
+        } else if (status == JXL_DEC_BOX) {
+            if (!boxes->onBox(dec)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_BOX_NEED_MORE_OUTPUT) {
+            if (!boxes->onNeedMoreOutput(dec)) {
+                return false;
+            }
         } else if (status == JXL_DEC_SUCCESS) {
             // All decoding successfully finished.
-            // It's not required to call JxlDecoderReleaseInput(dec.get()) here since
-            // the decoder will be destroyed.
+            if (boxes) {
+                boxes->finish(dec);
+            }
+            feeder.release(dec);
             return true;
         } else {
             return false;
@@ -171,41 +192,732 @@ bool DecodeJpegXlOneShot(const uint8_t *jxl, size_t size,
     }
 }
 
-bool DecodeBasicInfo(const uint8_t *jxl, size_t size, size_t *xsize, size_t *ysize) {
-    auto runner = JxlResizableParallelRunnerMake(nullptr);
+static bool DecodeJpegXlIntoBufferImpl(jxlcoder::JxlByteSource& source,
+                                       const jxlcoder::JxlRowPipeline* pipeline,
+                                       const JxlOutputBufferProvider& provider,
+                                       size_t *xsize, size_t *ysize,
+                                       JxlColorDescription *color,
+                                       int* depth,
+                                       int* components,
+                                       bool* useFloats,
+                                       JxlDecodingPixelFormat pixelFormat,
+                                       const JxlDecodeOptions& options,
+                                       const jxlcoder::JxlSharedRunner& runnerOptions) {
+    const bool premultiplyAlpha = options.premultiplyAlpha;
+    jxlcoder::JxlBoxCollector* boxes = options.boxes;
+    const bool simdOrientation = options.simdOrientation;
+    const JxlTargetColorSpace colorSpace = options.colorSpace;
+    jxlcoder::JxlSharedRunner runner = runnerOptions;
+    auto lease = jxlcoder::JxlDecoderPool::shared().acquire();
+    if (!lease) {
+        return false;
+    }
+    JxlDecoder* dec = lease.decoder();
+    if (JXL_DEC_SUCCESS !=
+        JxlDecoderSubscribeEvents(dec, JXL_DEC_BASIC_INFO |
+                                  JXL_DEC_COLOR_ENCODING |
+                                  JXL_DEC_FULL_IMAGE |
+                                  (boxes ? JXL_DEC_BOX : 0))) {
+        return false;
+    }
+    if (boxes && !boxes->attach(dec)) {
+        return false;
+    }
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec,
+                                                       jxlcoder::JxlSharedParallelRunner,
+                                                       &runner)) {
+        return false;
+    }
+
+    // Premultiplied images are kept as stored, straight ones are premultiplied in the pipeline below,
+    // so alpha never makes a round trip through unpremultiplication
+    if (JXL_DEC_SUCCESS != JxlDecoderSetUnpremultiplyAlpha(dec, premultiplyAlpha ? JXL_FALSE : JXL_TRUE)) {
+        return false;
+    }
+
+    // libjxl writes rows as stored, they are oriented in blocks once the image is complete
+    if (simdOrientation && JXL_DEC_SUCCESS != JxlDecoderSetKeepOrientation(dec, JXL_TRUE)) {
+        return false;
+    }
+
+    JxlBasicInfo info;
+    JxlPixelFormat format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+    uint8_t* buffer = nullptr;
+    size_t bufferSize = 0;
+    size_t bufferStride = 0;
+    // Where libjxl writes to, the buffer itself unless the image still has to be oriented
+    uint8_t* target = nullptr;
+    size_t targetSize = 0;
+    size_t targetStride = 0;
+    std::vector<uint8_t> stored;
+    jxlcoder::JxlRowPipeline stages;
+    std::unique_ptr<jxlcoder::JxlPipelineOutput> output;
+
+    jxlcoder::JxlInputFeeder feeder(source);
+    if (!feeder.feed(dec)) {
+        return false;
+    }
+
+    for (;;) {
+        if (runner.cancelled()) {
+            return false;
+        }
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec);
+
+        if (status == JXL_DEC_ERROR) {
+            return false;
+        } else if (status == JXL_DEC_NEED_MORE_INPUT) {
+            if (!feeder.feed(dec)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_BASIC_INFO) {
+            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec, &info)) {
+                return false;
+            }
+            bool transposed = info.orientation >= JXL_ORIENT_TRANSPOSE;
+            *xsize = transposed ? info.ysize : info.xsize;
+            *ysize = transposed ? info.xsize : info.ysize;
+            JxlResolveOutputFormat(info, pixelFormat, &format, depth, components, useFloats);
+
+            if (premultiplyAlpha && info.alpha_bits > 0 && !info.alpha_premultiplied && format.num_channels == 4) {
+                stages.add(std::make_shared<jxlcoder::JxlPremultiplyStage>());
+            }
+            if (pipeline) {
+                stages.append(*pipeline);
+            }
+            if (!stages.empty()) {
+                output = std::make_unique<jxlcoder::JxlPipelineOutput>(stages);
+            }
+
+            const size_t sampleSize = jxlcoder::JxlSampleSize(format.data_type);
+            *components = static_cast<int>(stages.outputComponents(format.num_channels));
+            const size_t rowBytes = *xsize * (*components) * sampleSize;
+            size_t rowStride = rowBytes;
+            buffer = provider(*xsize, *ysize, rowBytes, &rowStride, &bufferSize);
+            // Validate the whole layout before a single pixel is written
+            if (!buffer || rowStride < rowBytes || rowStride % sampleSize != 0
+                || reinterpret_cast<uintptr_t>(buffer) % sampleSize != 0
+                || bufferSize < rowStride * (*ysize - 1) + rowBytes) {
+                return false;
+            }
+            bufferStride = rowStride;
+            if (simdOrientation && info.orientation != JXL_ORIENT_IDENTITY) {
+                targetStride = info.xsize * (*components) * sampleSize;
+                stored.resize(targetStride * info.ysize);
+                target = stored.data();
+                targetSize = stored.size();
+            } else {
+                target = buffer;
+                targetSize = bufferSize;
+                targetStride = rowStride;
+            }
+            // libjxl rounds every row up to a multiple of align, which gives exactly the stride here
+            format.align = target == buffer && rowStride != rowBytes ? rowStride : 0;
+        } else if (status == JXL_DEC_COLOR_ENCODING) {
+            if (!JxlReadOutputColor(dec, format, color, colorSpace)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
+            if (output) {
+                // Stages run on every row while libjxl still has it in cache and write it once into the buffer
+                if (JXL_DEC_SUCCESS != output->attach(dec, format, target, targetStride)) {
+                    return false;
+                }
+                continue;
+            }
+            size_t requiredSize;
+            if (JXL_DEC_SUCCESS != JxlDecoderImageOutBufferSize(dec, &format, &requiredSize)) {
+                return false;
+            }
+            if (requiredSize > targetSize) {
+                return false;
+            }
+            if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutBuffer(dec, &format, target, requiredSize)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_FULL_IMAGE) {
+            // Animations keep overwriting the same buffer, the last frame wins
+        } else if (status == JXL_DEC_BOX) {
+            if (!boxes->onBox(dec)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_BOX_NEED_MORE_OUTPUT) {
+            if (!boxes->onNeedMoreOutput(dec)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_SUCCESS) {
+            if (boxes) {
+                boxes->finish(dec);
+            }
+            feeder.release(dec);
+            if (target != buffer) {
+                return jxlcoder::ApplyOrientation(target, targetStride, buffer, bufferStride,
+                                                  info.xsize, info.ysize, *components,
+                                                  jxlcoder::JxlSampleSize(format.data_type),
+                                                  static_cast<JxlExposedOrientation>(info.orientation), runner);
+            }
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+bool DecodeJpegXlIntoBuffer(jxlcoder::JxlByteSource& source,
+                            const JxlOutputBufferProvider& provider,
+                            size_t *xsize, size_t *ysize,
+                            JxlColorDescription *color,
+                            int* depth,
+                            int* components,
+                            bool* useFloats,
+                            JxlDecodingPixelFormat pixelFormat,
+                            const JxlDecodeOptions& options) {
+    return DecodeJpegXlIntoBufferImpl(source, nullptr, provider, xsize, ysize, color,
+                                      depth, components, useFloats, pixelFormat, options,
+                                      jxlcoder::JxlSharedRunner(options.priority));
+}
+
+bool DecodeJpegXlIntoBuffer(jxlcoder::JxlByteSource& source,
+                            const JxlOutputBufferProvider& provider,
+                            size_t *xsize, size_t *ysize,
+                            JxlColorDescription *color,
+                            int* depth,
+                            int* components,
+                            bool* useFloats,
+                            JxlDecodingPixelFormat pixelFormat,
+                            const JxlDecodeOptions& options,
+                            const jxlcoder::JxlSharedRunner& runner) {
+    return DecodeJpegXlIntoBufferImpl(source, nullptr, provider, xsize, ysize, color,
+                                      depth, components, useFloats, pixelFormat, options, runner);
+}
+
+bool DecodeJpegXlWithPipeline(jxlcoder::JxlByteSource& source,
+                              const jxlcoder::JxlRowPipeline& pipeline,
+                              const JxlOutputBufferProvider& provider,
+                              size_t *xsize, size_t *ysize,
+                              JxlColorDescription *color,
+                              int* depth,
+                              int* components,
+                              bool* useFloats,
+                              JxlDecodingPixelFormat pixelFormat,
+                              const JxlDecodeOptions& options) {
+    return DecodeJpegXlIntoBufferImpl(source, &pipeline, provider, xsize, ysize, color,
+                                      depth, components, useFloats, pixelFormat, options,
+                                      jxlcoder::JxlSharedRunner(options.priority));
+}
 
-    auto dec = JxlDecoderMake(nullptr);
+bool DecodeJpegXlIntoBuffer(jxlcoder::JxlByteSource& source,
+                            uint8_t* buffer, size_t bufferSize, size_t rowStride,
+                            size_t *xsize, size_t *ysize,
+                            JxlColorDescription *color,
+                            int* depth,
+                            int* components,
+                            bool* useFloats,
+                            JxlDecodingPixelFormat pixelFormat,
+                            const JxlDecodeOptions& options) {
+    auto provider = [buffer, bufferSize, rowStride](size_t, size_t, size_t rowBytes,
+                                                    size_t* stride, size_t* size) -> uint8_t* {
+        *stride = rowStride != 0 ? rowStride : rowBytes;
+        *size = bufferSize;
+        return buffer;
+    };
+    return DecodeJpegXlIntoBuffer(source, provider, xsize, ysize, color,
+                                  depth, components, useFloats, pixelFormat, options);
+}
+
+struct JxlRegionSink {
+    size_t x;
+    size_t y;
+    size_t width;
+    size_t height;
+    size_t pixelSize;
+    uint8_t* destination;
+};
+
+/**
+ * Receives decoded rows from libjxl, possibly from several threads at once, and keeps only the part inside the region
+ */
+static void JxlRegionSinkCallback(void *opaque, size_t x, size_t y, size_t numPixels, const void *pixels) {
+    auto sink = static_cast<JxlRegionSink*>(opaque);
+    if (y < sink->y || y >= sink->y + sink->height) {
+        return;
+    }
+    size_t from = std::max(x, sink->x);
+    size_t to = std::min(x + numPixels, sink->x + sink->width);
+    if (from >= to) {
+        return;
+    }
+    uint8_t* dst = sink->destination + ((y - sink->y) * sink->width + (from - sink->x)) * sink->pixelSize;
+    auto src = static_cast<const uint8_t*>(pixels) + (from - x) * sink->pixelSize;
+    std::copy(src, src + (to - from) * sink->pixelSize, dst);
+}
+
+bool DecodeJpegXlRegion(jxlcoder::JxlByteSource& source,
+                        size_t regionX, size_t regionY,
+                        size_t regionWidth, size_t regionHeight,
+                        std::vector<uint8_t> *pixels,
+                        JxlColorDescription *color,
+                        int* depth,
+                        int* components,
+                        bool* useFloats,
+                        JxlDecodingPixelFormat pixelFormat,
+                        JxlRunnerPriority priority) {
+    if (regionWidth == 0 || regionHeight == 0) {
+        return false;
+    }
+    jxlcoder::JxlSharedRunner runner(priority);
+    auto lease = jxlcoder::JxlDecoderPool::shared().acquire();
+    if (!lease) {
+        return false;
+    }
+    JxlDecoder* dec = lease.decoder();
     if (JXL_DEC_SUCCESS !=
-        JxlDecoderSubscribeEvents(dec.get(), JXL_DEC_BASIC_INFO |
+        JxlDecoderSubscribeEvents(dec, JXL_DEC_BASIC_INFO |
                                   JXL_DEC_COLOR_ENCODING |
                                   JXL_DEC_FULL_IMAGE)) {
         return false;
     }
 
-    if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec.get(),
-                                                       JxlResizableParallelRunner,
-                                                       runner.get())) {
+    if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec,
+                                                       jxlcoder::JxlSharedParallelRunner,
+                                                       &runner)) {
+        return false;
+    }
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetUnpremultiplyAlpha(dec, JXL_TRUE)) {
         return false;
     }
 
     JxlBasicInfo info;
+    JxlPixelFormat format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+    JxlRegionSink sink = { regionX, regionY, regionWidth, regionHeight, 0, nullptr };
 
-    JxlDecoderSetInput(dec.get(), jxl, size);
-    JxlDecoderCloseInput(dec.get());
+    jxlcoder::JxlInputFeeder feeder(source);
+    if (!feeder.feed(dec)) {
+        return false;
+    }
 
     for (;;) {
-        JxlDecoderStatus status = JxlDecoderProcessInput(dec.get());
+        if (runner.cancelled()) {
+            return false;
+        }
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec);
 
         if (status == JXL_DEC_ERROR) {
             return false;
         } else if (status == JXL_DEC_NEED_MORE_INPUT) {
+            if (!feeder.feed(dec)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_BASIC_INFO) {
+            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec, &info)) {
+                return false;
+            }
+            // Callback coordinates are already oriented, so the region is validated against displayed size
+            bool transposed = info.orientation >= JXL_ORIENT_TRANSPOSE;
+            size_t displayedWidth = transposed ? info.ysize : info.xsize;
+            size_t displayedHeight = transposed ? info.xsize : info.ysize;
+            if (regionX >= displayedWidth || regionY >= displayedHeight
+                || regionWidth > displayedWidth - regionX
+                || regionHeight > displayedHeight - regionY) {
+                return false;
+            }
+            JxlResolveOutputFormat(info, pixelFormat, &format, depth, components, useFloats);
+            sink.pixelSize = (*components) * jxlcoder::JxlSampleSize(format.data_type);
+            pixels->resize(regionWidth * regionHeight * sink.pixelSize);
+            sink.destination = pixels->data();
+        } else if (status == JXL_DEC_COLOR_ENCODING) {
+            if (!JxlReadOutputColor(dec, format, color)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
+            if (JXL_DEC_SUCCESS != JxlDecoderSetImageOutCallback(dec, &format,
+                                                                 JxlRegionSinkCallback, &sink)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_FULL_IMAGE) {
+            // Keep going, for animations only the last frame is kept like in the one shot decoder
+        } else if (status == JXL_DEC_SUCCESS) {
+            feeder.release(dec);
+            return true;
+        } else {
             return false;
+        }
+    }
+}
+
+struct JxlSubsampleSink {
+    size_t width;
+    size_t height;
+    size_t factor;
+    size_t pixelSize;
+    size_t outWidth;
+    size_t outHeight;
+    std::vector<uint8_t>* pixels;
+};
+
+/**
+ * Called single threaded before every render pass, the first one included.
+ * The factor is fixed before decoding starts, so the output never grows past the subsampled size.
+ */
+static void* JxlSubsampleSinkInit(void *opaque, size_t, size_t) {
+    auto sink = static_cast<JxlSubsampleSink*>(opaque);
+    sink->outWidth = (sink->width + sink->factor - 1) / sink->factor;
+    sink->outHeight = (sink->height + sink->factor - 1) / sink->factor;
+    sink->pixels->resize(sink->outWidth * sink->outHeight * sink->pixelSize);
+    return opaque;
+}
+
+static void JxlSubsampleSinkRun(void *opaque, size_t, size_t x, size_t y, size_t numPixels, const void *pixels) {
+    auto sink = static_cast<JxlSubsampleSink*>(opaque);
+    const size_t factor = sink->factor;
+    if (y % factor != 0) {
+        return;
+    }
+    auto src = static_cast<const uint8_t*>(pixels);
+    uint8_t* dstRow = sink->pixels->data() + (y / factor) * sink->outWidth * sink->pixelSize;
+    size_t first = (x + factor - 1) / factor * factor;
+    for (size_t column = first; column < x + numPixels; column += factor) {
+        auto pixel = src + (column - x) * sink->pixelSize;
+        std::copy(pixel, pixel + sink->pixelSize, dstRow + (column / factor) * sink->pixelSize);
+    }
+}
+
+static void JxlSubsampleSinkDestroy(void *) {
+}
+
+bool DecodeJpegXlThumbnail(jxlcoder::JxlByteSource& source,
+                           size_t targetWidth, size_t targetHeight,
+                           std::vector<uint8_t> *pixels, size_t *xsize,
+                           size_t *ysize,
+                           JxlColorDescription *color,
+                           int* depth,
+                           int* components,
+                           bool* useFloats,
+                           JxlDecodingPixelFormat pixelFormat,
+                           const JxlDecodeOptions& options) {
+    const bool preferPreview = options.preferPreview;
+    jxlcoder::JxlSharedRunner runner(options.priority);
+    auto lease = jxlcoder::JxlDecoderPool::shared().acquire();
+    if (!lease) {
+        return false;
+    }
+    JxlDecoder* dec = lease.decoder();
+    if (JXL_DEC_SUCCESS !=
+        JxlDecoderSubscribeEvents(dec, JXL_DEC_BASIC_INFO |
+                                  JXL_DEC_COLOR_ENCODING |
+                                  (preferPreview ? JXL_DEC_PREVIEW_IMAGE : 0) |
+                                  JXL_DEC_FRAME_PROGRESSION |
+                                  JXL_DEC_FULL_IMAGE)) {
+        return false;
+    }
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetParallelRunner(dec,
+                                                       jxlcoder::JxlSharedParallelRunner,
+                                                       &runner)) {
+        return false;
+    }
+
+    // DC gives 1/8 resolution, passes give 1/4 and 1/2 when the file was encoded with them
+    if (JXL_DEC_SUCCESS != JxlDecoderSetProgressiveDetail(dec, kPasses)) {
+        return false;
+    }
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetUnpremultiplyAlpha(dec, JXL_TRUE)) {
+        return false;
+    }
+
+    JxlBasicInfo info;
+    JxlPixelFormat format = {4, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+    JxlSubsampleSink sink = { 0, 0, 1, 0, 0, 0, pixels };
+    size_t allowedFactor = 1;
+    size_t previewWidth = 0;
+    size_t previewHeight = 0;
+    bool usePreview = false;
+
+    jxlcoder::JxlInputFeeder feeder(source);
+    if (!feeder.feed(dec)) {
+        return false;
+    }
+
+    for (;;) {
+        if (runner.cancelled()) {
+            return false;
+        }
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec);
+
+        if (status == JXL_DEC_ERROR) {
+            return false;
+        } else if (status == JXL_DEC_NEED_MORE_INPUT) {
+            if (!feeder.feed(dec)) {
+                return false;
+            }
         } else if (status == JXL_DEC_BASIC_INFO) {
-            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec.get(), &info)) {
+            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec, &info)) {
+                return false;
+            }
+            bool transposed = info.orientation >= JXL_ORIENT_TRANSPOSE;
+            sink.width = transposed ? info.ysize : info.xsize;
+            sink.height = transposed ? info.xsize : info.ysize;
+            if (targetWidth > 0 && targetHeight > 0) {
+                size_t reduction = std::min(sink.width / targetWidth, sink.height / targetHeight);
+                while (allowedFactor * 2 <= std::min<size_t>(reduction, 8)) {
+                    allowedFactor *= 2;
+                }
+            }
+            // Every render is kept at this factor, including the full resolution fallback
+            sink.factor = allowedFactor;
+            JxlResolveOutputFormat(info, pixelFormat, &format, depth, components, useFloats);
+            sink.pixelSize = (*components) * jxlcoder::JxlSampleSize(format.data_type);
+            // The preview comes out oriented like the main image
+            previewWidth = transposed ? info.preview.ysize : info.preview.xsize;
+            previewHeight = transposed ? info.preview.xsize : info.preview.ysize;
+            usePreview = info.have_preview == JXL_TRUE &&
+                previewWidth >= targetWidth && previewHeight >= targetHeight;
+        } else if (status == JXL_DEC_COLOR_ENCODING) {
+            if (!JxlReadOutputColor(dec, format, color)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_NEED_PREVIEW_OUT_BUFFER) {
+            // A preview too small for the target is still decoded once it was subscribed to,
+            // it is tiny and gets overwritten by the main image
+            size_t bufferSize;
+            if (JXL_DEC_SUCCESS != JxlDecoderPreviewOutBufferSize(dec, &format, &bufferSize)) {
+                return false;
+            }
+            pixels->resize(bufferSize);
+            if (JXL_DEC_SUCCESS != JxlDecoderSetPreviewOutBuffer(dec, &format, pixels->data(), pixels->size())) {
+                return false;
+            }
+        } else if (status == JXL_DEC_PREVIEW_IMAGE) {
+            if (usePreview) {
+                *xsize = previewWidth;
+                *ysize = previewHeight;
+                feeder.release(dec);
+                return true;
+            }
+        } else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
+            if (JXL_DEC_SUCCESS != JxlDecoderSetMultithreadedImageOutCallback(dec, &format,
+                                                                              JxlSubsampleSinkInit,
+                                                                              JxlSubsampleSinkRun,
+                                                                              JxlSubsampleSinkDestroy,
+                                                                              &sink)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_FRAME_PROGRESSION) {
+            size_t ratio = JxlDecoderGetIntendedDownsamplingRatio(dec);
+            if (ratio > 1 && ratio <= allowedFactor) {
+                // Enough detail for the target, the flushed image is upsampled so only every factor-th pixel is kept
+                if (JXL_DEC_SUCCESS != JxlDecoderFlushImage(dec)) {
+                    return false;
+                }
+                *xsize = sink.outWidth;
+                *ysize = sink.outHeight;
+                feeder.release(dec);
+                return true;
+            }
+        } else if (status == JXL_DEC_FULL_IMAGE) {
+            // No usable progressive step, the first frame was decoded at full resolution and subsampled
+            *xsize = sink.outWidth;
+            *ysize = sink.outHeight;
+            feeder.release(dec);
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+void JxlResolveOutputFormat(const JxlBasicInfo& info,
+                            JxlDecodingPixelFormat pixelFormat,
+                            JxlPixelFormat* format,
+                            int* depth,
+                            int* components,
+                            bool* useFloats) {
+    int baseComponents = info.num_color_channels;
+    if (info.num_extra_channels > 0) {
+        baseComponents = 4;
+    }
+    *depth = info.bits_per_sample;
+    if (pixelFormat == f16 || pixelFormat == f32) {
+        // Float bitmaps are only supported as gray or RGBA, libjxl fills opaque alpha when there is none
+        if (baseComponents != 1) {
+            baseComponents = 4;
+        }
+        *useFloats = true;
+        *depth = pixelFormat == f16 ? 16 : 32;
+        *format = { static_cast<uint32_t>(baseComponents),
+            pixelFormat == f16 ? JXL_TYPE_FLOAT16 : JXL_TYPE_FLOAT, JXL_NATIVE_ENDIAN, 0 };
+    } else if ((info.bits_per_sample > 8 && pixelFormat == optimal) || pixelFormat == r16) {
+        *useFloats = true;
+        *format = { static_cast<uint32_t>(baseComponents), JXL_TYPE_UINT16, JXL_NATIVE_ENDIAN, 0 };
+    } else {
+        if (pixelFormat == r8) {
+            *depth = 8;
+        }
+        *useFloats = false;
+        *format = { static_cast<uint32_t>(baseComponents), JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0 };
+    }
+    *components = baseComponents;
+}
+
+static bool JxlTargetColorEncoding(JxlTargetColorSpace colorSpace, bool isGray, JxlColorEncoding* encoding) {
+    switch (colorSpace) {
+        case colorSpaceSRGB:
+            JxlColorEncodingSetToSRGB(encoding, isGray);
+            return true;
+        case colorSpaceLinearSRGB:
+            JxlColorEncodingSetToLinearSRGB(encoding, isGray);
+            return true;
+        case colorSpaceDisplayP3:
+            JxlColorEncodingSetToSRGB(encoding, isGray);
+            encoding->primaries = JXL_PRIMARIES_P3;
+            return true;
+        case colorSpaceBT2020PQ:
+            JxlColorEncodingSetToSRGB(encoding, isGray);
+            encoding->primaries = JXL_PRIMARIES_2100;
+            encoding->transfer_function = JXL_TRANSFER_FUNCTION_PQ;
+            encoding->rendering_intent = JXL_RENDERING_INTENT_RELATIVE;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool JxlPrepareOutputColor(JxlDecoder* dec, const JxlPixelFormat& format, JxlTargetColorSpace colorSpace) {
+    JxlColorEncoding target;
+    if (colorSpace != colorSpaceOriginal) {
+        JxlBasicInfo info;
+        if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec, &info)) {
+            return false;
+        }
+        // Gray stays gray, only the white point and transfer function of the target apply to it
+        if (!JxlTargetColorEncoding(colorSpace, info.num_color_channels == 1, &target)) {
+            return false;
+        }
+        // The CMS has to be in place before the output profile, libjxl checks the conversion right away
+        if (JXL_DEC_SUCCESS != JxlDecoderSetCms(dec, *JxlGetDefaultCms())) {
+            return false;
+        }
+        if (JXL_DEC_SUCCESS != JxlDecoderSetOutputColorProfile(dec, &target, nullptr, 0)) {
+            return false;
+        }
+    } else if (format.data_type == JXL_TYPE_FLOAT || format.data_type == JXL_TYPE_FLOAT16) {
+        // libjxl renders float output in linear sRGB by default, ask for the original encoding instead
+        // so PQ, HLG or linear content keeps its transfer function
+        JxlColorEncoding original;
+        if (JXL_DEC_SUCCESS == JxlDecoderGetColorAsEncodedProfile(dec, JXL_COLOR_PROFILE_TARGET_ORIGINAL, &original)) {
+            if (JXL_DEC_SUCCESS != JxlDecoderSetPreferredColorProfile(dec, &original)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool JxlReadDataICCProfile(JxlDecoder* dec, std::vector<uint8_t>* iccProfile) {
+    size_t iccSize;
+    if (JXL_DEC_SUCCESS ==
+        JxlDecoderGetICCProfileSize(dec, JXL_COLOR_PROFILE_TARGET_DATA, &iccSize)) {
+        iccProfile->resize(iccSize);
+        if (JXL_DEC_SUCCESS != JxlDecoderGetColorAsICCProfile(dec, JXL_COLOR_PROFILE_TARGET_DATA,
+                                                              iccProfile->data(), iccProfile->size())) {
+            return false;
+        }
+    } else {
+        iccProfile->resize(0);
+    }
+    return true;
+}
+
+bool JxlReadOutputColorProfile(JxlDecoder* dec, const JxlPixelFormat& format, std::vector<uint8_t>* iccProfile,
+                               JxlTargetColorSpace colorSpace) {
+    if (!JxlPrepareOutputColor(dec, format, colorSpace)) {
+        return false;
+    }
+    return JxlReadDataICCProfile(dec, iccProfile);
+}
+
+bool JxlReadOutputColor(JxlDecoder* dec, const JxlPixelFormat& format, JxlColorDescription* color,
+                        JxlTargetColorSpace colorSpace) {
+    if (!JxlPrepareOutputColor(dec, format, colorSpace)) {
+        return false;
+    }
+    // Fails for images that only have an ICC profile
+    color->parametric =
+    JXL_DEC_SUCCESS == JxlDecoderGetColorAsEncodedProfile(dec, JXL_COLOR_PROFILE_TARGET_DATA, &color->encoding) &&
+    JxlIsNamedColorEncoding(color->encoding);
+    if (color->parametric) {
+        color->iccProfile.clear();
+        return true;
+    }
+    return JxlReadDataICCProfile(dec, &color->iccProfile);
+}
+
+bool JxlIsNamedColorEncoding(const JxlColorEncoding& encoding) {
+    if (encoding.color_space != JXL_COLOR_SPACE_RGB || encoding.white_point != JXL_WHITE_POINT_D65) {
+        return false;
+    }
+    switch (encoding.transfer_function) {
+        case JXL_TRANSFER_FUNCTION_SRGB:
+            return encoding.primaries == JXL_PRIMARIES_SRGB || encoding.primaries == JXL_PRIMARIES_P3;
+        case JXL_TRANSFER_FUNCTION_LINEAR:
+            return encoding.primaries == JXL_PRIMARIES_SRGB ||
+            encoding.primaries == JXL_PRIMARIES_P3 ||
+            encoding.primaries == JXL_PRIMARIES_2100;
+        case JXL_TRANSFER_FUNCTION_PQ:
+        case JXL_TRANSFER_FUNCTION_HLG:
+            return encoding.primaries == JXL_PRIMARIES_P3 || encoding.primaries == JXL_PRIMARIES_2100;
+        default:
+            return false;
+    }
+}
+
+bool DecodeBasicInfo(const uint8_t *jxl, size_t size, size_t *xsize, size_t *ysize) {
+    jxlcoder::JxlMemoryByteSource source(jxl, size);
+    return DecodeBasicInfo(source, xsize, ysize);
+}
+
+bool DecodeBasicInfo(jxlcoder::JxlByteSource& source, size_t *xsize, size_t *ysize) {
+    auto lease = jxlcoder::JxlDecoderPool::shared().acquire();
+    if (!lease) {
+        return false;
+    }
+    JxlDecoder* dec = lease.decoder();
+    if (JXL_DEC_SUCCESS != JxlDecoderSubscribeEvents(dec, JXL_DEC_BASIC_INFO)) {
+        return false;
+    }
+
+    JxlBasicInfo info;
+
+    // Basic info sits in the first few hundred bytes, so a small window avoids reading the whole file
+    jxlcoder::JxlInputFeeder feeder(source, 4096);
+    if (!feeder.feed(dec)) {
+        return false;
+    }
+
+    // Nothing runs on the executor here, but reading the source may block
+    auto cancellation = jxlcoder::JxlCancellationScope::current();
+    for (;;) {
+        if (cancellation && cancellation->isCancelled()) {
+            return false;
+        }
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec);
+
+        if (status == JXL_DEC_ERROR) {
+            return false;
+        } else if (status == JXL_DEC_NEED_MORE_INPUT) {
+            if (!feeder.feed(dec)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_BASIC_INFO) {
+            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec, &info)) {
                 return false;
             }
             *xsize = info.xsize;
             *ysize = info.ysize;
+            feeder.release(dec);
             return true;
         } else if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
             return false;
@@ -219,6 +931,134 @@ bool DecodeBasicInfo(const uint8_t *jxl, size_t size, size_t *xsize, size_t *ysi
     }
 }
 
+bool DecodeJpegXlBoxes(jxlcoder::JxlByteSource& source, jxlcoder::JxlBoxCollector& boxes) {
+    auto lease = jxlcoder::JxlDecoderPool::shared().acquire();
+    if (!lease) {
+        return false;
+    }
+    JxlDecoder* dec = lease.decoder();
+    // Without any image event subscribed libjxl skips over the codestream instead of decoding it
+    if (JXL_DEC_SUCCESS != JxlDecoderSubscribeEvents(dec, JXL_DEC_BOX)) {
+        return false;
+    }
+    if (!boxes.attach(dec)) {
+        return false;
+    }
+
+    jxlcoder::JxlInputFeeder feeder(source);
+    if (!feeder.feed(dec)) {
+        return false;
+    }
+
+    // Nothing runs on the executor here, but reading the source may block
+    auto cancellation = jxlcoder::JxlCancellationScope::current();
+    for (;;) {
+        if (cancellation && cancellation->isCancelled()) {
+            return false;
+        }
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec);
+
+        if (status == JXL_DEC_ERROR) {
+            return false;
+        } else if (status == JXL_DEC_NEED_MORE_INPUT) {
+            if (!feeder.feed(dec)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_BOX) {
+            if (!boxes.onBox(dec)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_BOX_NEED_MORE_OUTPUT) {
+            if (!boxes.onNeedMoreOutput(dec)) {
+                return false;
+            }
+        } else if (status == JXL_DEC_SUCCESS) {
+            boxes.finish(dec);
+            feeder.release(dec);
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+bool ProbeJpegXl(const uint8_t *jxl, size_t size, JxlImageDescriptor* descriptor, size_t* neededBytes) {
+    *neededBytes = 0;
+    // Pooled decoders come with the static runner attached, headers never dispatch parallel work
+    auto lease = jxlcoder::JxlDecoderPool::shared().acquire();
+    if (!lease) {
+        return false;
+    }
+    JxlDecoder* dec = lease.decoder();
+    if (JXL_DEC_SUCCESS != JxlDecoderSubscribeEvents(dec, JXL_DEC_BASIC_INFO | JXL_DEC_COLOR_ENCODING)) {
+        return false;
+    }
+
+    if (JXL_DEC_SUCCESS != JxlDecoderSetInput(dec, jxl, size)) {
+        return false;
+    }
+    JxlDecoderCloseInput(dec);
+
+    bool hasBasicInfo = false;
+    JxlBasicInfo info;
+
+    auto cancellation = jxlcoder::JxlCancellationScope::current();
+    for (;;) {
+        if (cancellation && cancellation->isCancelled()) {
+            return false;
+        }
+        JxlDecoderStatus status = JxlDecoderProcessInput(dec);
+
+        if (status == JXL_DEC_NEED_MORE_INPUT) {
+            if (!hasBasicInfo) {
+                *neededBytes = std::max(JxlDecoderSizeHintBasicInfo(dec), size + 1);
+            } else {
+                // ICC profiles are stored compressed and rarely exceed a few kilobytes
+                *neededBytes = size + 4096;
+            }
+            return false;
+        } else if (status == JXL_DEC_BASIC_INFO) {
+            if (JXL_DEC_SUCCESS != JxlDecoderGetBasicInfo(dec, &info)) {
+                return false;
+            }
+            hasBasicInfo = true;
+            bool transposed = info.orientation >= JXL_ORIENT_TRANSPOSE;
+            descriptor->width = transposed ? info.ysize : info.xsize;
+            descriptor->height = transposed ? info.xsize : info.ysize;
+            descriptor->bitsPerSample = info.bits_per_sample;
+            descriptor->exponentBitsPerSample = info.exponent_bits_per_sample;
+            descriptor->isFloat = info.exponent_bits_per_sample > 0;
+            descriptor->colorChannels = info.num_color_channels;
+            descriptor->hasAlpha = info.alpha_bits > 0;
+            descriptor->alphaPremultiplied = info.alpha_premultiplied == JXL_TRUE;
+            descriptor->orientation = static_cast<JxlExposedOrientation>(info.orientation);
+            descriptor->hasAnimation = info.have_animation == JXL_TRUE;
+            // Counting frames means walking the whole codestream, animations report it as unknown
+            descriptor->frameCountHint = descriptor->hasAnimation ? 0 : 1;
+            descriptor->animationLoops = descriptor->hasAnimation ? info.animation.num_loops : 0;
+            descriptor->hasPreview = info.have_preview == JXL_TRUE;
+            // The preview is oriented like the image
+            descriptor->previewWidth = !descriptor->hasPreview ? 0 : transposed ? info.preview.ysize : info.preview.xsize;
+            descriptor->previewHeight = !descriptor->hasPreview ? 0 : transposed ? info.preview.xsize : info.preview.ysize;
+        } else if (status == JXL_DEC_COLOR_ENCODING) {
+            descriptor->hasColorEncoding =
+            JXL_DEC_SUCCESS == JxlDecoderGetColorAsEncodedProfile(dec, JXL_COLOR_PROFILE_TARGET_ORIGINAL,
+                                                                  &descriptor->colorEncoding);
+            descriptor->hasIccProfile = !descriptor->hasColorEncoding;
+            descriptor->iccProfileSize = 0;
+            if (descriptor->hasIccProfile) {
+                size_t iccSize;
+                if (JXL_DEC_SUCCESS == JxlDecoderGetICCProfileSize(dec, JXL_COLOR_PROFILE_TARGET_ORIGINAL, &iccSize)) {
+                    descriptor->iccProfileSize = iccSize;
+                }
+            }
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
 /**
  * Compresses the provided pixels.
  *
@@ -233,13 +1073,34 @@ bool EncodeJxlOneshot(const std::vector<uint8_t> &pixels, const uint32_t xsize,
                       JxlCompressionOption compressionOption,
                       float compressionDistance,
                       int effort,
-                      int decodingSpeed) {
-    auto enc = JxlEncoderMake(nullptr);
-    auto runner = JxlThreadParallelRunnerMake(nullptr,
-                                              JxlThreadParallelRunnerDefaultNumWorkerThreads());
+                      int decodingSpeed,
+                      JxlRunnerPriority priority) {
+    compressed->clear();
+    jxlcoder::JxlVectorOutputSink output(*compressed);
+    return EncodeJxlOneshot(pixels, xsize, ysize, output, colorspace, compressionOption,
+                            compressionDistance, effort, decodingSpeed, priority);
+}
+
+bool EncodeJxlOneshot(const std::vector<uint8_t> &pixels, const uint32_t xsize,
+                      const uint32_t ysize, jxlcoder::JxlOutputSink& output,
+                      JxlPixelType colorspace,
+                      JxlCompressionOption compressionOption,
+                      float compressionDistance,
+                      int effort,
+                      int decodingSpeed,
+                      JxlRunnerPriority priority) {
+    jxlcoder::JxlSharedRunner runner(priority);
+    jxlcoder::JxlScopedMemoryArena arena;
+    jxlcoder::JxlOutputWriter writer(output);
+    auto enc = JxlEncoderMake(arena.manager());
     if (JXL_ENC_SUCCESS != JxlEncoderSetParallelRunner(enc.get(),
-                                                       JxlThreadParallelRunner,
-                                                       runner.get())) {
+                                                       jxlcoder::JxlSharedParallelRunner,
+                                                       &runner)) {
+        return false;
+    }
+
+    // Compressed bytes go to the sink as libjxl produces them
+    if (!writer.attach(enc.get())) {
         return false;
     }
 
@@ -338,23 +1199,7 @@ bool EncodeJxlOneshot(const std::vector<uint8_t> &pixels, const uint32_t xsize,
         return false;
     }
 
-    JxlEncoderCloseInput(enc.get());
-
-    compressed->resize(64);
-    uint8_t *next_out = compressed->data();
-    size_t avail_out = compressed->size() - (next_out - compressed->data());
-    JxlEncoderStatus process_result = JXL_ENC_NEED_MORE_OUTPUT;
-    while (process_result == JXL_ENC_NEED_MORE_OUTPUT) {
-        process_result = JxlEncoderProcessOutput(enc.get(), &next_out, &avail_out);
-        if (process_result == JXL_ENC_NEED_MORE_OUTPUT) {
-            size_t offset = next_out - compressed->data();
-            compressed->resize(compressed->size() * 2);
-            next_out = compressed->data() + offset;
-            avail_out = compressed->size() - offset;
-        }
-    }
-    compressed->resize(next_out - compressed->data());
-    if (JXL_ENC_SUCCESS != process_result) {
+    if (!writer.finish(enc.get()) || runner.cancelled()) {
         return false;
     }
 
@@ -368,6 +1213,10 @@ bool isJXL(std::vector<uint8_t>& src) {
     return true;
 }
 
+bool isJXL(const uint8_t* data, size_t size) {
+    return JXL_SIG_INVALID != JxlSignatureCheck(data, size);
+}
+
 // HDR-aware encoder that preserves bit depth and color profile
 bool EncodeJxlHDR(
     const std::vector<uint8_t>& pixels,
@@ -385,37 +1234,48 @@ bool EncodeJxlHDR(
     int effort,
     int decodingSpeed,
     const std::vector<uint8_t>* exifData,
-    const std::vector<uint8_t>* xmpData
+    const std::vector<uint8_t>* xmpData,
+    JxlRunnerPriority priority,
+    bool embedPreview
 ) {
-    // DEBUG: Log encoding parameters
-    fprintf(stderr, "[JXL HDR Encode] %ux%u, %d channels, container=%d-bit, original=%d-bit, isFloat=%d\n",
-            xsize, ysize, numChannels, containerBitsPerSample, originalBitsPerSample, isFloat);
-    fprintf(stderr, "[JXL HDR Encode] compression=%s, distance=%.2f, effort=%d, decodingSpeed=%d\n",
-            compressionOption == lossless ? "lossless" : "lossy", compressionDistance, effort, decodingSpeed);
-    fprintf(stderr, "[JXL HDR Encode] transfer=%d, primaries=%d, hasICC=%d (size=%zu)\n",
-            (int)transferFunction, (int)colorPrimaries,
-            iccProfile != nullptr && !iccProfile->empty(),
-            iccProfile ? iccProfile->size() : 0);
-    fprintf(stderr, "[JXL HDR Encode] exif=%zu bytes, xmp=%zu bytes\n",
-            exifData ? exifData->size() : 0, xmpData ? xmpData->size() : 0);
-
-    auto enc = JxlEncoderMake(nullptr);
-
-    // Limit threads to avoid potential threading issues in libjxl
-    // Some images trigger crashes with high thread counts
-    size_t numThreads = JxlThreadParallelRunnerDefaultNumWorkerThreads();
-    if (numThreads > 8) {
-        numThreads = 8;  // Cap at 8 threads for stability
-    }
-    auto runner = JxlThreadParallelRunnerMake(nullptr, numThreads);
+    compressed->clear();
+    jxlcoder::JxlVectorOutputSink output(*compressed);
+    return EncodeJxlHDR(pixels, xsize, ysize, output, numChannels, containerBitsPerSample,
+                        originalBitsPerSample, isFloat, iccProfile, transferFunction, colorPrimaries,
+                        compressionOption, compressionDistance, effort, decodingSpeed,
+                        exifData, xmpData, priority, embedPreview);
+}
 
-    if (JXL_ENC_SUCCESS != JxlEncoderSetParallelRunner(
-            enc.get(), JxlThreadParallelRunner, runner.get())) {
+bool EncodeJxlHDRFrame(
+    JxlEncoder* enc,
+    jxlcoder::JxlOutputSink& output,
+    const JxlEncoderProfile& profile,
+    uint32_t xsize, uint32_t ysize,
+    const std::vector<uint8_t>* pixels,
+    jxlcoder::JxlPixelSource* source,
+    const std::vector<uint8_t>* exifData,
+    const std::vector<uint8_t>* xmpData,
+    bool embedPreview
+) {
+    int numChannels = profile.numChannels;
+    int containerBitsPerSample = profile.containerBitsPerSample;
+    int originalBitsPerSample = profile.originalBitsPerSample;
+    bool isFloat = profile.isFloat;
+    const std::vector<uint8_t>* iccProfile = profile.iccProfile.empty() ? nullptr : &profile.iccProfile;
+    JxlTransferFunctionType transferFunction = profile.transferFunction;
+    JxlColorPrimariesType colorPrimaries = profile.colorPrimaries;
+    JxlCompressionOption compressionOption = profile.compressionOption;
+    float compressionDistance = profile.distance;
+    int effort = profile.effort;
+    int decodingSpeed = profile.decodingSpeed;
+
+    jxlcoder::JxlOutputWriter writer(output);
+
+    // Compressed bytes go to the sink as libjxl produces them, the file is never held here as a whole
+    if (!writer.attach(enc)) {
         return false;
     }
 
-    fprintf(stderr, "[JXL HDR Encode] Using %zu threads\n", numThreads);
-
     // Basic info - use original bit depth for better compression
     // e.g., 10-bit data in 16-bit container: tell encoder only 10 bits are significant
     JxlBasicInfo basicInfo;
@@ -466,13 +1326,13 @@ bool EncodeJxlHDR(
     if (compressionOption == lossless && hasValidIccProfile) {
         // Lossless with ICC profile - use original profile for exact color preservation
         basicInfo.uses_original_profile = JXL_TRUE;
-        if (JXL_ENC_SUCCESS != JxlEncoderSetBasicInfo(enc.get(), &basicInfo)) {
+        if (JXL_ENC_SUCCESS != JxlEncoderSetBasicInfo(enc, &basicInfo)) {
             return false;
         }
 
         // Try to set ICC profile
         if (JXL_ENC_SUCCESS == JxlEncoderSetICCProfile(
-                enc.get(), iccProfile->data(), iccProfile->size())) {
+                enc, iccProfile->data(), iccProfile->size())) {
             iccProfileAccepted = true;
         }
         // If ICC profile fails, fall through to use color encoding
@@ -484,7 +1344,7 @@ bool EncodeJxlHDR(
         // Note: For lossy, libjxl may mishandle ICC profiles, so we explicitly
         // use parametric color encoding for correct HDR interpretation
         basicInfo.uses_original_profile = JXL_FALSE;
-        if (JXL_ENC_SUCCESS != JxlEncoderSetBasicInfo(enc.get(), &basicInfo)) {
+        if (JXL_ENC_SUCCESS != JxlEncoderSetBasicInfo(enc, &basicInfo)) {
             return false;
         }
     }
@@ -496,7 +1356,7 @@ bool EncodeJxlHDR(
         channelInfo.bits_per_sample = originalBitsPerSample;
         channelInfo.exponent_bits_per_sample = isFloat ? basicInfo.exponent_bits_per_sample : 0;
         channelInfo.alpha_premultiplied = JXL_FALSE;
-        if (JXL_ENC_SUCCESS != JxlEncoderSetExtraChannelInfo(enc.get(), 0, &channelInfo)) {
+        if (JXL_ENC_SUCCESS != JxlEncoderSetExtraChannelInfo(enc, 0, &channelInfo)) {
             return false;
         }
     }
@@ -556,14 +1416,14 @@ bool EncodeJxlHDR(
             }
         }
 
-        if (JXL_ENC_SUCCESS != JxlEncoderSetColorEncoding(enc.get(), &color_encoding)) {
+        if (JXL_ENC_SUCCESS != JxlEncoderSetColorEncoding(enc, &color_encoding)) {
             return false;
         }
     }
 
     // Frame settings
     JxlEncoderFrameSettings* frameSettings =
-        JxlEncoderFrameSettingsCreate(enc.get(), nullptr);
+        JxlEncoderFrameSettingsCreate(enc, nullptr);
 
     // Bit depth setting - use original precision for compression efficiency
     // This tells the encoder that e.g. 10-bit data is stored in 16-bit container
@@ -593,6 +1453,25 @@ bool EncodeJxlHDR(
         return false;
     }
 
+    // libjxl cannot write a separate preview frame, instead the low resolution passes go first
+    // so DecodeJpegXlThumbnail stops after a small prefix of the file.
+    // Lossy gets a progressive DC (1/16 and 1/8) and AC passes (1/4, 1/2), lossless uses squeeze
+    if (embedPreview) {
+        if (compressionOption == lossless) {
+            if (JXL_ENC_SUCCESS != JxlEncoderFrameSettingsSetOption(
+                    frameSettings, JXL_ENC_FRAME_SETTING_RESPONSIVE, 1)) {
+                return false;
+            }
+        } else {
+            if (JXL_ENC_SUCCESS != JxlEncoderFrameSettingsSetOption(
+                    frameSettings, JXL_ENC_FRAME_SETTING_PROGRESSIVE_DC, 1) ||
+                JXL_ENC_SUCCESS != JxlEncoderFrameSettingsSetOption(
+                    frameSettings, JXL_ENC_FRAME_SETTING_PROGRESSIVE_AC, 1)) {
+                return false;
+            }
+        }
+    }
+
     // Distance (quality) - only applies to lossy
     if (compressionOption != lossless) {
         if (JXL_ENC_SUCCESS != JxlEncoderSetFrameDistance(frameSettings, compressionDistance)) {
@@ -625,7 +1504,7 @@ bool EncodeJxlHDR(
     size_t bytesPerSample = (containerBitsPerSample <= 8) ? 1 :
                             (containerBitsPerSample <= 16) ? 2 : 4;
     size_t expectedSize = static_cast<size_t>(xsize) * ysize * numChannels * bytesPerSample;
-    if (pixels.size() != expectedSize) {
+    if (pixels && pixels->size() != expectedSize) {
         // Buffer size mismatch - this would cause encoding to fail
         return false;
     }
@@ -635,7 +1514,7 @@ bool EncodeJxlHDR(
     bool hasMetadata = (exifData && !exifData->empty()) || (xmpData && !xmpData->empty());
     if (hasMetadata) {
         // Enable box-based container format
-        if (JXL_ENC_SUCCESS != JxlEncoderUseBoxes(enc.get())) {
+        if (JXL_ENC_SUCCESS != JxlEncoderUseBoxes(enc)) {
             return false;
         }
 
@@ -655,7 +1534,7 @@ bool EncodeJxlHDR(
             exifWithOffset.insert(exifWithOffset.end(), exifData->begin(), exifData->end());
 
             JxlBoxType exifBoxType = {'E', 'x', 'i', 'f'};
-            if (JXL_ENC_SUCCESS != JxlEncoderAddBox(enc.get(), exifBoxType,
+            if (JXL_ENC_SUCCESS != JxlEncoderAddBox(enc, exifBoxType,
                     exifWithOffset.data(), exifWithOffset.size(), JXL_FALSE)) {
                 // Non-fatal: continue without EXIF if it fails
             }
@@ -665,78 +1544,145 @@ bool EncodeJxlHDR(
         if (xmpData && !xmpData->empty()) {
             JxlBoxType xmpBoxType = {'x', 'm', 'l', ' '};
             // XMP can be Brotli-compressed for smaller files
-            if (JXL_ENC_SUCCESS != JxlEncoderAddBox(enc.get(), xmpBoxType,
+            if (JXL_ENC_SUCCESS != JxlEncoderAddBox(enc, xmpBoxType,
                     xmpData->data(), xmpData->size(), JXL_TRUE)) {
                 // Non-fatal: continue without XMP if it fails
             }
         }
 
         // Close boxes section before adding image frame
-        JxlEncoderCloseBoxes(enc.get());
-    }
-
-    // Add image frame
-    if (JXL_ENC_SUCCESS != JxlEncoderAddImageFrame(
-            frameSettings, &pixel_format,
-            pixels.data(), pixels.size())) {
-        return false;
+        JxlEncoderCloseBoxes(enc);
     }
 
-    JxlEncoderCloseInput(enc.get());
-
-    // Process output with dynamic buffer growth
-    // Pre-allocate a reasonable initial buffer based on image size
-    // Estimate: lossy ~1 byte/pixel, lossless ~2 bytes/pixel as starting point
-    size_t estimatedSize = xsize * ysize * numChannels;
-    if (compressionOption == lossless) {
-        estimatedSize = std::max(estimatedSize, (size_t)(xsize * ysize * 2));
+    if (pixels) {
+        if (JXL_ENC_SUCCESS != JxlEncoderAddImageFrame(
+                frameSettings, &pixel_format,
+                pixels->data(), pixels->size())) {
+            return false;
+        }
     } else {
-        estimatedSize = std::max(estimatedSize / 4, (size_t)65536);
+        // Streaming input and output for anything larger than one group, libjxl then holds
+        // only the groups it is working on instead of the whole frame
+        if (JXL_ENC_SUCCESS != JxlEncoderFrameSettingsSetOption(
+                frameSettings, JXL_ENC_FRAME_SETTING_BUFFERING, 2)) {
+            return false;
+        }
+        jxlcoder::JxlChunkedFrameInput input(*source, pixel_format);
+        // The last frame closes the input and flushes everything to the writer
+        if (JXL_ENC_SUCCESS != JxlEncoderAddChunkedFrame(frameSettings, JXL_TRUE, input.inputSource()) ||
+            input.failed()) {
+            return false;
+        }
     }
-    compressed->resize(estimatedSize);
 
-    uint8_t* next_out = compressed->data();
-    size_t avail_out = compressed->size();
-    JxlEncoderStatus status = JXL_ENC_NEED_MORE_OUTPUT;
-
-    int iterations = 0;
-    const int maxIterations = 100; // Safety limit
-
-    while (status == JXL_ENC_NEED_MORE_OUTPUT && iterations < maxIterations) {
-        iterations++;
-        status = JxlEncoderProcessOutput(enc.get(), &next_out, &avail_out);
+    return writer.finish(enc);
+}
 
-        if (status == JXL_ENC_NEED_MORE_OUTPUT) {
-            size_t offset = next_out - compressed->data();
-            size_t newSize = compressed->size() * 2;
 
-            // Safety check: don't allocate more than 2GB
-            if (newSize > 2ULL * 1024 * 1024 * 1024) {
-                fprintf(stderr, "[JXL HDR Encode] ERROR: Output buffer exceeded 2GB limit\n");
-                return false;
-            }
+static JxlEncoderProfile JxlMakeEncoderProfile(int numChannels,
+                                               int containerBitsPerSample,
+                                               int originalBitsPerSample,
+                                               bool isFloat,
+                                               const std::vector<uint8_t>* iccProfile,
+                                               JxlTransferFunctionType transferFunction,
+                                               JxlColorPrimariesType colorPrimaries,
+                                               JxlCompressionOption compressionOption,
+                                               float compressionDistance,
+                                               int effort,
+                                               int decodingSpeed) {
+    JxlEncoderProfile profile;
+    profile.numChannels = numChannels;
+    profile.containerBitsPerSample = containerBitsPerSample;
+    profile.originalBitsPerSample = originalBitsPerSample;
+    profile.isFloat = isFloat;
+    if (iccProfile) {
+        profile.iccProfile = *iccProfile;
+    }
+    profile.transferFunction = transferFunction;
+    profile.colorPrimaries = colorPrimaries;
+    profile.compressionOption = compressionOption;
+    profile.distance = compressionDistance;
+    profile.effort = effort;
+    profile.decodingSpeed = decodingSpeed;
+    return profile;
+}
 
-            compressed->resize(newSize);
-            next_out = compressed->data() + offset;
-            avail_out = compressed->size() - offset;
-        } else if (status == JXL_ENC_ERROR) {
-            fprintf(stderr, "[JXL HDR Encode] ERROR: JxlEncoderProcessOutput returned error\n");
-            return false;
-        }
+static bool EncodeJxlHDRWithNewEncoder(const JxlEncoderProfile& profile,
+                                       uint32_t xsize, uint32_t ysize,
+                                       const std::vector<uint8_t>* pixels,
+                                       jxlcoder::JxlPixelSource* source,
+                                       jxlcoder::JxlOutputSink& output,
+                                       const std::vector<uint8_t>* exifData,
+                                       const std::vector<uint8_t>* xmpData,
+                                       bool embedPreview,
+                                       JxlRunnerPriority priority) {
+    jxlcoder::JxlSharedRunner runner(priority);
+    runner.maxThreads = kHDREncoderMaxThreads;
+    jxlcoder::JxlScopedMemoryArena arena;
+    auto enc = JxlEncoderMake(arena.manager());
+    if (!enc) {
+        return false;
     }
 
-    if (iterations >= maxIterations) {
-        fprintf(stderr, "[JXL HDR Encode] ERROR: Exceeded maximum iterations (%d)\n", maxIterations);
+    if (JXL_ENC_SUCCESS != JxlEncoderSetParallelRunner(
+            enc.get(), jxlcoder::JxlSharedParallelRunner, &runner)) {
         return false;
     }
 
-    compressed->resize(next_out - compressed->data());
+    return EncodeJxlHDRFrame(enc.get(), output, profile, xsize, ysize, pixels, source,
+                             exifData, xmpData, embedPreview) && !runner.cancelled();
+}
 
-    // DEBUG: Log final compressed size
-    fprintf(stderr, "[JXL HDR Encode] Final size: %.2f MB (%.1f:1 ratio from %zu bytes raw)\n",
-            compressed->size() / (1024.0 * 1024.0),
-            (double)(xsize * ysize * numChannels * (containerBitsPerSample / 8)) / compressed->size(),
-            pixels.size());
+bool EncodeJxlHDR(
+    const std::vector<uint8_t>& pixels,
+    uint32_t xsize, uint32_t ysize,
+    jxlcoder::JxlOutputSink& output,
+    int numChannels,
+    int containerBitsPerSample,
+    int originalBitsPerSample,
+    bool isFloat,
+    const std::vector<uint8_t>* iccProfile,
+    JxlTransferFunctionType transferFunction,
+    JxlColorPrimariesType colorPrimaries,
+    JxlCompressionOption compressionOption,
+    float compressionDistance,
+    int effort,
+    int decodingSpeed,
+    const std::vector<uint8_t>* exifData,
+    const std::vector<uint8_t>* xmpData,
+    JxlRunnerPriority priority,
+    bool embedPreview
+) {
+    JxlEncoderProfile profile = JxlMakeEncoderProfile(numChannels, containerBitsPerSample, originalBitsPerSample,
+                                                      isFloat, iccProfile, transferFunction, colorPrimaries,
+                                                      compressionOption, compressionDistance, effort, decodingSpeed);
+    return EncodeJxlHDRWithNewEncoder(profile, xsize, ysize, &pixels, nullptr, output,
+                                      exifData, xmpData, embedPreview, priority);
+}
 
-    return status == JXL_ENC_SUCCESS;
+bool EncodeJxlHDRChunked(
+    jxlcoder::JxlPixelSource& source,
+    uint32_t xsize, uint32_t ysize,
+    jxlcoder::JxlOutputSink& output,
+    int numChannels,
+    int containerBitsPerSample,
+    int originalBitsPerSample,
+    bool isFloat,
+    const std::vector<uint8_t>* iccProfile,
+    JxlTransferFunctionType transferFunction,
+    JxlColorPrimariesType colorPrimaries,
+    JxlCompressionOption compressionOption,
+    float compressionDistance,
+    int effort,
+    int decodingSpeed,
+    const std::vector<uint8_t>* exifData,
+    const std::vector<uint8_t>* xmpData,
+    JxlRunnerPriority priority
+) {
+    // Progressive passes need the whole frame at once, libjxl would buffer it again
+    JxlEncoderProfile profile = JxlMakeEncoderProfile(numChannels, containerBitsPerSample, originalBitsPerSample,
+                                                      isFloat, iccProfile, transferFunction, colorPrimaries,
+                                                      compressionOption, compressionDistance, effort, decodingSpeed);
+    return EncodeJxlHDRWithNewEncoder(profile, xsize, ysize, nullptr, &source, output,
+                                      exifData, xmpData, false, priority);
 }
@@ -28,29 +28,270 @@
 
 #include <stdio.h>
 #ifdef __cplusplus
+#include <functional>
 #include <vector>
 #endif
 #ifdef __cplusplus
 
 #include "JxlDefinitions.h"
+#include "JxlByteSource.hpp"
+#include "JxlRowPipeline.hpp"
+#include "JxlBoxCollector.hpp"
+#include "JxlOutputSink.hpp"
+#include "JxlPixelSource.hpp"
+#include "JxlSharedRunner.hpp"
+#include <jxl/codestream_header.h>
+#include <jxl/color_encoding.h>
+#include <jxl/types.h>
+#include <jxl/decode.h>
+#include <jxl/encode.h>
 
+/**
+ * Color of decoded pixels. Spaces platforms know by name (see JxlIsNamedColorEncoding) are described
+ * by encoding alone and carry no ICC bytes, the platform color space made from the name produces
+ * a profile only if something asks for it. Everything else carries the ICC profile.
+ */
+struct JxlColorDescription {
+    bool parametric = false;
+    JxlColorEncoding encoding = {};
+    std::vector<uint8_t> iccProfile;
+};
+
+/**
+ * Optional decoding settings. Each decoding function documents which of them it honors, the rest are ignored.
+ */
+struct JxlDecodeOptions {
+    // Color comes out multiplied by alpha, images stored premultiplied are passed through as is
+    bool premultiplyAlpha = false;
+    // Metadata boxes are collected into it during the same pass
+    jxlcoder::JxlBoxCollector* boxes = nullptr;
+    // libjxl keeps the stored orientation and the finished image is oriented by jxlcoder::ApplyOrientation
+    bool simdOrientation = false;
+    // Pixels are converted into this space with the bundled CMS while they are decoded
+    JxlTargetColorSpace colorSpace = colorSpaceOriginal;
+    // An embedded preview large enough for the target is returned instead of decoding the main image
+    bool preferPreview = false;
+    JxlRunnerPriority priority = runnerNormal;
+};
+
+/**
+ * Honors premultiplyAlpha, boxes and priority.
+ */
 bool DecodeJpegXlOneShot(const uint8_t *jxl, size_t size,
                          std::vector<uint8_t> *pixels, size_t *xsize,
                          size_t *ysize,
-                         std::vector<uint8_t> *icc_profile,
+                         JxlColorDescription *color,
                          int* depth,
                          int* components,
                          bool* useFloats,
                          JxlExposedOrientation* exposedOrientation,
-                         JxlDecodingPixelFormat pixelFormat);
+                         JxlDecodingPixelFormat pixelFormat,
+                         const JxlDecodeOptions& options = JxlDecodeOptions());
+/**
+ * Same as DecodeJpegXlOneShot, but pulls the compressed bytes from the source while decoding
+ * instead of requiring the whole file in memory.
+ */
+bool DecodeJpegXlStream(jxlcoder::JxlByteSource& source,
+                        std::vector<uint8_t> *pixels, size_t *xsize,
+                        size_t *ysize,
+                        JxlColorDescription *color,
+                        int* depth,
+                        int* components,
+                        bool* useFloats,
+                        JxlExposedOrientation* exposedOrientation,
+                        JxlDecodingPixelFormat pixelFormat,
+                        const JxlDecodeOptions& options = JxlDecodeOptions());
+/**
+ * Called once the image size is known, before any pixel is decoded.
+ * Returns the destination, and sets rowStride (preset to the tight row size) and bufferSize.
+ * Returning nullptr aborts decoding.
+ */
+typedef std::function<uint8_t*(size_t width, size_t height, size_t rowBytes,
+                               size_t* rowStride, size_t* bufferSize)> JxlOutputBufferProvider;
+
+/**
+ * Decodes straight into memory owned by the caller, nothing is zero filled or copied afterwards.
+ * Rows are rowStride bytes apart, the stride must hold a full row and be a multiple of the sample size,
+ * and the buffer must be aligned to the sample size and hold every row, otherwise decoding fails up front.
+ * xsize and ysize are the displayed dimensions, orientation is already applied.
+ * Honors every option but preferPreview. simdOrientation costs one scratch image for oriented files,
+ * with a colorSpace other than colorSpaceOriginal color describes the target space.
+ */
+bool DecodeJpegXlIntoBuffer(jxlcoder::JxlByteSource& source,
+                            const JxlOutputBufferProvider& provider,
+                            size_t *xsize, size_t *ysize,
+                            JxlColorDescription *color,
+                            int* depth,
+                            int* components,
+                            bool* useFloats,
+                            JxlDecodingPixelFormat pixelFormat,
+                            const JxlDecodeOptions& options = JxlDecodeOptions());
+/**
+ * Same as above with full control over how the decoder uses the shared executor, options.priority is not used
+ */
+bool DecodeJpegXlIntoBuffer(jxlcoder::JxlByteSource& source,
+                            const JxlOutputBufferProvider& provider,
+                            size_t *xsize, size_t *ysize,
+                            JxlColorDescription *color,
+                            int* depth,
+                            int* components,
+                            bool* useFloats,
+                            JxlDecodingPixelFormat pixelFormat,
+                            const JxlDecodeOptions& options,
+                            const jxlcoder::JxlSharedRunner& runner);
+/**
+ * Same as DecodeJpegXlIntoBuffer, but every row goes through the pipeline stages on its way into the buffer.
+ * components reports the pipeline output, which is also what rowBytes given to the provider is based on.
+ * Honors the same options as DecodeJpegXlIntoBuffer.
+ */
+bool DecodeJpegXlWithPipeline(jxlcoder::JxlByteSource& source,
+                              const jxlcoder::JxlRowPipeline& pipeline,
+                              const JxlOutputBufferProvider& provider,
+                              size_t *xsize, size_t *ysize,
+                              JxlColorDescription *color,
+                              int* depth,
+                              int* components,
+                              bool* useFloats,
+                              JxlDecodingPixelFormat pixelFormat,
+                              const JxlDecodeOptions& options = JxlDecodeOptions());
+/**
+ * Same as above for a buffer that already exists, rowStride of 0 means tightly packed rows.
+ */
+bool DecodeJpegXlIntoBuffer(jxlcoder::JxlByteSource& source,
+                            uint8_t* buffer, size_t bufferSize, size_t rowStride,
+                            size_t *xsize, size_t *ysize,
+                            JxlColorDescription *color,
+                            int* depth,
+                            int* components,
+                            bool* useFloats,
+                            JxlDecodingPixelFormat pixelFormat,
+                            const JxlDecodeOptions& options = JxlDecodeOptions());
+/**
+ * Decodes only the rectangle at regionX, regionY in displayed (already oriented) coordinates.
+ * Pixels outside of it are dropped as libjxl produces them, so memory is proportional to the region.
+ * Fails if the region does not fit into the image.
+ */
+bool DecodeJpegXlRegion(jxlcoder::JxlByteSource& source,
+                        size_t regionX, size_t regionY,
+                        size_t regionWidth, size_t regionHeight,
+                        std::vector<uint8_t> *pixels,
+                        JxlColorDescription *color,
+                        int* depth,
+                        int* components,
+                        bool* useFloats,
+                        JxlDecodingPixelFormat pixelFormat,
+                        JxlRunnerPriority priority = runnerNormal);
+/**
+ * Decodes a reduced resolution image for thumbnails.
+ * Decoding stops at the cheapest progressive step (DC or pass) whose resolution still covers the target,
+ * so xsize and ysize are at least the target size and usually need only a small resample afterwards.
+ * Returned dimensions are already oriented. Animations produce their first frame.
+ * With preferPreview an embedded preview image at least as large as the target is returned as is,
+ * it precedes the first frame in the codestream so nothing of the main image gets decoded.
+ * Honors preferPreview and priority.
+ */
+bool DecodeJpegXlThumbnail(jxlcoder::JxlByteSource& source,
+                           size_t targetWidth, size_t targetHeight,
+                           std::vector<uint8_t> *pixels, size_t *xsize,
+                           size_t *ysize,
+                           JxlColorDescription *color,
+                           int* depth,
+                           int* components,
+                           bool* useFloats,
+                           JxlDecodingPixelFormat pixelFormat,
+                           const JxlDecodeOptions& options = JxlDecodeOptions());
+/**
+ * Picks the output pixel layout for the decoded image, shared by every decoding path.
+ * useFloats is set when samples are wider than 8 bits, format.data_type tells integer and float samples apart.
+ */
+void JxlResolveOutputFormat(const JxlBasicInfo& info,
+                            JxlDecodingPixelFormat pixelFormat,
+                            JxlPixelFormat* format,
+                            int* depth,
+                            int* components,
+                            bool* useFloats);
+/**
+ * Reads the ICC profile of the decoded pixels on JXL_DEC_COLOR_ENCODING.
+ * For float formats the original transfer function is requested first, since libjxl would output linear sRGB otherwise.
+ * Any other colorSpace replaces that with a conversion through the default CMS.
+ */
+bool JxlReadOutputColorProfile(JxlDecoder* dec, const JxlPixelFormat& format, std::vector<uint8_t>* iccProfile,
+                               JxlTargetColorSpace colorSpace = colorSpaceOriginal);
+/**
+ * Same as JxlReadOutputColorProfile, but named spaces are reported as a JxlColorEncoding
+ * and libjxl does not synthesize an ICC profile for them.
+ */
+bool JxlReadOutputColor(JxlDecoder* dec, const JxlPixelFormat& format, JxlColorDescription* color,
+                        JxlTargetColorSpace colorSpace = colorSpaceOriginal);
+/**
+ * RGB with D65 white: sRGB or Display P3 primaries with sRGB or linear transfer,
+ * P3 or BT.2020 primaries with PQ or HLG, and linear BT.2020.
+ */
+bool JxlIsNamedColorEncoding(const JxlColorEncoding& encoding);
 bool DecodeBasicInfo(const uint8_t *jxl, size_t size, size_t *xsize, size_t *ysize);
+
+/**
+ * Everything known about the image from its headers alone.
+ */
+struct JxlImageDescriptor {
+    // Displayed size, orientation already applied
+    uint32_t width;
+    uint32_t height;
+    uint32_t bitsPerSample;
+    uint32_t exponentBitsPerSample;
+    bool isFloat;
+    uint32_t colorChannels;
+    bool hasAlpha;
+    bool alphaPremultiplied;
+    JxlExposedOrientation orientation;
+    bool hasAnimation;
+    // 1 for still images, 0 when unknown
+    uint32_t frameCountHint;
+    // 0 means infinite looping
+    uint32_t animationLoops;
+    // Exactly one of hasColorEncoding and hasIccProfile is set
+    bool hasColorEncoding;
+    JxlColorEncoding colorEncoding;
+    bool hasIccProfile;
+    size_t iccProfileSize;
+    bool hasPreview;
+    // Displayed size like width and height
+    uint32_t previewWidth;
+    uint32_t previewHeight;
+};
+
+/**
+ * Reads only image headers, without decoding pixels or creating threads.
+ * @param neededBytes set when the data ends before the headers do, as a hint of the total prefix
+ * length to retry with; stays 0 for invalid data
+ * @return true if the descriptor is complete
+ */
+bool ProbeJpegXl(const uint8_t *jxl, size_t size, JxlImageDescriptor* descriptor, size_t* neededBytes);
+bool DecodeBasicInfo(jxlcoder::JxlByteSource& source, size_t *xsize, size_t *ysize);
+/**
+ * Collects metadata boxes without decoding any pixels. Bare codestreams have no boxes and succeed empty.
+ */
+bool DecodeJpegXlBoxes(jxlcoder::JxlByteSource& source, jxlcoder::JxlBoxCollector& boxes);
 bool EncodeJxlOneshot(const std::vector<uint8_t> &pixels, const uint32_t xsize,
                       const uint32_t ysize, std::vector<uint8_t> *compressed,
                       JxlPixelType colorspace,
                       JxlCompressionOption compressionOption,
                       float compressionDistance,
                       int effort,
-                      int decodingSpeed);
+                      int decodingSpeed,
+                      JxlRunnerPriority priority = runnerNormal);
+/**
+ * Same as above, but compressed bytes are written to the sink while they are produced,
+ * so the compressed file is never held in memory as a whole.
+ */
+bool EncodeJxlOneshot(const std::vector<uint8_t> &pixels, const uint32_t xsize,
+                      const uint32_t ysize, jxlcoder::JxlOutputSink& output,
+                      JxlPixelType colorspace,
+                      JxlCompressionOption compressionOption,
+                      float compressionDistance,
+                      int effort,
+                      int decodingSpeed,
+                      JxlRunnerPriority priority = runnerNormal);
 
 // Transfer function enum (must match JXLTransferFunction in JXLSystemImage.hpp)
 enum JxlTransferFunctionType {
@@ -67,6 +308,25 @@ enum JxlColorPrimariesType {
     PrimariesBT2020 = 2     // Rec.2020 wide gamut
 };
 
+/**
+ * Settings of an HDR encode that do not depend on the image itself, see EncodeJxlHDR for their meaning.
+ * Only the dimensions and metadata change from image to image.
+ */
+struct JxlEncoderProfile {
+    int numChannels = 4;
+    int containerBitsPerSample = 8;
+    int originalBitsPerSample = 8;
+    bool isFloat = false;
+    // Empty to describe the color by transferFunction and colorPrimaries
+    std::vector<uint8_t> iccProfile;
+    JxlTransferFunctionType transferFunction = TransferSRGB;
+    JxlColorPrimariesType colorPrimaries = PrimariesSRGB;
+    JxlCompressionOption compressionOption = lossless;
+    float distance = 1.0f;
+    int effort = 7;
+    int decodingSpeed = 0;
+};
+
 // HDR-aware encoder that preserves bit depth and color profile
 bool EncodeJxlHDR(
     const std::vector<uint8_t>& pixels,
@@ -84,10 +344,76 @@ bool EncodeJxlHDR(
     int effort,
     int decodingSpeed,
     const std::vector<uint8_t>* exifData = nullptr,  // Optional EXIF data (TIFF format)
-    const std::vector<uint8_t>* xmpData = nullptr    // Optional XMP data (UTF-8 XML)
+    const std::vector<uint8_t>* xmpData = nullptr,   // Optional XMP data (UTF-8 XML)
+    JxlRunnerPriority priority = runnerNormal,       // Scheduling priority on the shared runner
+    bool embedPreview = false                        // Low resolution steps up front for preview decoding
+);
+
+// Same as above, writing to the sink while compressed bytes are produced
+bool EncodeJxlHDR(
+    const std::vector<uint8_t>& pixels,
+    uint32_t xsize, uint32_t ysize,
+    jxlcoder::JxlOutputSink& output,
+    int numChannels,                         // 3 or 4
+    int containerBitsPerSample,              // Container size: 8, 16, 32
+    int originalBitsPerSample,               // Original precision: 8, 10, 12, 16 (for better compression)
+    bool isFloat,                            // true for float16/float32
+    const std::vector<uint8_t>* iccProfile,  // can be nullptr
+    JxlTransferFunctionType transferFunction, // Transfer function when no ICC profile
+    JxlColorPrimariesType colorPrimaries,     // Color primaries when no ICC profile
+    JxlCompressionOption compressionOption,
+    float compressionDistance,
+    int effort,
+    int decodingSpeed,
+    const std::vector<uint8_t>* exifData = nullptr,  // Optional EXIF data (TIFF format)
+    const std::vector<uint8_t>* xmpData = nullptr,   // Optional XMP data (UTF-8 XML)
+    JxlRunnerPriority priority = runnerNormal,       // Scheduling priority on the shared runner
+    bool embedPreview = false                        // Low resolution steps up front for preview decoding
+);
+
+// Same as above for frames too large to hold, pixels are pulled from source a few groups at a time
+// through JxlEncoderAddChunkedFrame while compressed bytes go to the sink
+bool EncodeJxlHDRChunked(
+    jxlcoder::JxlPixelSource& source,
+    uint32_t xsize, uint32_t ysize,
+    jxlcoder::JxlOutputSink& output,
+    int numChannels,                         // 3 or 4
+    int containerBitsPerSample,              // Container size: 8, 16, 32
+    int originalBitsPerSample,               // Original precision: 8, 10, 12, 16 (for better compression)
+    bool isFloat,                            // true for float16/float32
+    const std::vector<uint8_t>* iccProfile,  // can be nullptr
+    JxlTransferFunctionType transferFunction, // Transfer function when no ICC profile
+    JxlColorPrimariesType colorPrimaries,     // Color primaries when no ICC profile
+    JxlCompressionOption compressionOption,
+    float compressionDistance,
+    int effort,
+    int decodingSpeed,
+    const std::vector<uint8_t>* exifData = nullptr,  // Optional EXIF data (TIFF format)
+    const std::vector<uint8_t>* xmpData = nullptr,   // Optional XMP data (UTF-8 XML)
+    JxlRunnerPriority priority = runnerNormal        // Scheduling priority on the shared runner
+);
+
+// Some images trigger crashes in libjxl with high thread counts, runners driving EncodeJxlHDRFrame
+// set JxlSharedRunner::maxThreads to this
+static constexpr size_t kHDREncoderMaxThreads = 8;
+
+// Configures enc from the profile and encodes one image into output. enc must be new or reset
+// and have its parallel runner set, the caller keeps it and checks the runner for cancellation.
+// Pixels come from the buffer or, when it is null, are pulled from source as a chunked frame
+bool EncodeJxlHDRFrame(
+    JxlEncoder* enc,
+    jxlcoder::JxlOutputSink& output,
+    const JxlEncoderProfile& profile,
+    uint32_t xsize, uint32_t ysize,
+    const std::vector<uint8_t>* pixels,
+    jxlcoder::JxlPixelSource* source,
+    const std::vector<uint8_t>* exifData = nullptr,
+    const std::vector<uint8_t>* xmpData = nullptr,
+    bool embedPreview = false
 );
 
 bool isJXL(std::vector<uint8_t>& src);
+bool isJXL(const uint8_t* data, size_t size);
 
 template <typename DataType>
 class JXLDataWrapper {
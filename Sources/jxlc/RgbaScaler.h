@@ -32,7 +32,9 @@
 
 typedef NS_ENUM(NSInteger, JxlIPixelFormat)  {
     kU8 NS_SWIFT_NAME(uniform8),
-    kF16 NS_SWIFT_NAME(float16)
+    kF16 NS_SWIFT_NAME(float16),
+    kHalf NS_SWIFT_NAME(half),
+    kFloat NS_SWIFT_NAME(float32)
 };
 
 @interface RgbaScaler : NSObject
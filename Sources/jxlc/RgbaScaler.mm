@@ -531,6 +531,44 @@ static bool scaleRgba16(vector<uint8_t> &src, int components, int width, int hei
     return true;
 }
 
+/**
+ * Float samples come either as gray or RGBA, both have a direct vImage scaler
+ */
+static bool scaleFloat(vector<uint8_t> &src, int components, int width, int height, int newWidth, int newHeight, bool half) {
+    if (components != 1 && components != 4) {
+        return false;
+    }
+    const size_t sampleSize = half ? sizeof(uint16_t) : sizeof(float);
+    vector<uint8_t> dst(components * sampleSize * newWidth * newHeight);
+    vImage_Buffer sourceBuffer = {
+        .data = src.data(),
+        .width = static_cast<vImagePixelCount>(width),
+        .height = static_cast<vImagePixelCount>(height),
+        .rowBytes = static_cast<vImagePixelCount>(width * components * sampleSize)
+    };
+
+    vImage_Buffer destBuffer = {
+        .data = dst.data(),
+        .width = static_cast<vImagePixelCount>(newWidth),
+        .height = static_cast<vImagePixelCount>(newHeight),
+        .rowBytes = static_cast<vImagePixelCount>(newWidth * components * sampleSize)
+    };
+
+    vImage_Error result;
+    if (half) {
+        result = components == 4 ? vImageScale_ARGB16F(&sourceBuffer, &destBuffer, nullptr, kvImageNoFlags)
+        : vImageScale_Planar16F(&sourceBuffer, &destBuffer, nullptr, kvImageNoFlags);
+    } else {
+        result = components == 4 ? vImageScale_ARGBFFFF(&sourceBuffer, &destBuffer, nullptr, kvImageNoFlags)
+        : vImageScale_PlanarF(&sourceBuffer, &destBuffer, nullptr, kvImageNoFlags);
+    }
+    if (result != kvImageNoError) {
+        return false;
+    }
+    src = std::move(dst);
+    return true;
+}
+
 +(bool) scaleData:(vector<uint8_t>&)src width:(int)width height:(int)height newWidth:(int)newWidth newHeight:(int)newHeight components:(int)components pixelFormat:(JxlIPixelFormat)pixelFormat {
     
     if (newWidth < 0 || newHeight < 0) {
@@ -544,6 +582,8 @@ static bool scaleRgba16(vector<uint8_t> &src, int components, int width, int hei
                           newWidth:newWidth newHeight:newHeight];
         } else if (pixelFormat == kF16) {
             return scaleRgba16(src, components, width, height, newWidth, newHeight);
+        } else if (pixelFormat == kHalf || pixelFormat == kFloat) {
+            return scaleFloat(src, components, width, height, newWidth, newHeight, pixelFormat == kHalf);
         }
     } catch (const std::bad_alloc& e) {
         return false;
@@ -0,0 +1,156 @@
+//
+//  blend.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#include "blend.hpp"
+#include <algorithm>
+#include <cstring>
+#include <hwy/highway.h>
+
+namespace jxlcoder {
+
+using namespace hwy;
+using namespace hwy::HWY_NAMESPACE;
+
+/**
+ * Blends Lanes(df) pixels in place, samples are widened to floats in 0...255
+ */
+template<JxlBlendMode mode, bool premultiplied>
+static inline void BlendPixels(uint8_t* canvas, const uint8_t* layer) {
+    const ScalableTag<float> df;
+    const Rebind<int32_t, decltype(df)> di;
+    const Rebind<uint8_t, decltype(df)> du;
+    using VU = Vec<decltype(du)>;
+    using VF = Vec<decltype(df)>;
+
+    VU u0, u1, u2, u3;
+    LoadInterleaved4(du, canvas, u0, u1, u2, u3);
+    VF o[4] = { ConvertTo(df, PromoteTo(di, u0)), ConvertTo(df, PromoteTo(di, u1)),
+        ConvertTo(df, PromoteTo(di, u2)), ConvertTo(df, PromoteTo(di, u3)) };
+    LoadInterleaved4(du, layer, u0, u1, u2, u3);
+    VF n[4] = { ConvertTo(df, PromoteTo(di, u0)), ConvertTo(df, PromoteTo(di, u1)),
+        ConvertTo(df, PromoteTo(di, u2)), ConvertTo(df, PromoteTo(di, u3)) };
+
+    const VF scale = Set(df, 1.0f / 255.0f);
+    const VF one = Set(df, 1.0f);
+    const VF layerAlpha = Mul(n[3], scale);
+    VF r[4];
+    if constexpr (mode == JXL_BLEND_ADD) {
+        for (int c = 0; c < 4; ++c) {
+            r[c] = Add(o[c], n[c]);
+        }
+    } else if constexpr (mode == JXL_BLEND_MULADD) {
+        // Colors are added weighted by the layer alpha, the canvas alpha stays as it was
+        for (int c = 0; c < 3; ++c) {
+            r[c] = MulAdd(n[c], layerAlpha, o[c]);
+        }
+        r[3] = o[3];
+    } else if constexpr (mode == JXL_BLEND_MUL) {
+        for (int c = 0; c < 4; ++c) {
+            r[c] = Mul(Mul(o[c], n[c]), scale);
+        }
+    } else if constexpr (premultiplied) {
+        const VF inverse = Sub(one, layerAlpha);
+        for (int c = 0; c < 4; ++c) {
+            r[c] = MulAdd(o[c], inverse, n[c]);
+        }
+    } else {
+        // Straight alpha: weights are the layer alpha and what the layer leaves of the canvas alpha
+        const VF canvasWeight = Mul(Mul(o[3], scale), Sub(one, layerAlpha));
+        const VF alpha = Add(layerAlpha, canvasWeight);
+        const auto visible = Gt(alpha, Zero(df));
+        const VF reciprocal = IfThenElseZero(visible, Div(one, IfThenElse(visible, alpha, one)));
+        for (int c = 0; c < 3; ++c) {
+            r[c] = Mul(MulAdd(n[c], layerAlpha, Mul(o[c], canvasWeight)), reciprocal);
+        }
+        r[3] = Mul(alpha, Set(df, 255.0f));
+    }
+
+    const VF zero = Zero(df);
+    const VF maxColors = Set(df, 255.0f);
+    VU out[4];
+    for (int c = 0; c < 4; ++c) {
+        out[c] = DemoteTo(du, NearestInt(Min(Max(r[c], zero), maxColors)));
+    }
+    StoreInterleaved4(out[0], out[1], out[2], out[3], du, canvas);
+}
+
+template<JxlBlendMode mode, bool premultiplied>
+static void BlendRows(uint8_t* canvas, size_t canvasStride,
+                      const uint8_t* layer, size_t layerStride,
+                      size_t width, size_t height) {
+    const ScalableTag<float> df;
+    const size_t lanes = Lanes(df);
+    for (size_t y = 0; y < height; ++y) {
+        uint8_t* canvasRow = canvas + y * canvasStride;
+        const uint8_t* layerRow = layer + y * layerStride;
+        size_t x = 0;
+        for (; x + lanes <= width; x += lanes) {
+            BlendPixels<mode, premultiplied>(canvasRow + x * 4, layerRow + x * 4);
+        }
+        if (x < width) {
+            // The tail goes through the same kernel from a full vector of scratch pixels
+            uint8_t canvasTail[HWY_MAX_BYTES] = { 0 };
+            uint8_t layerTail[HWY_MAX_BYTES] = { 0 };
+            const size_t tailBytes = (width - x) * 4;
+            std::memcpy(canvasTail, canvasRow + x * 4, tailBytes);
+            std::memcpy(layerTail, layerRow + x * 4, tailBytes);
+            BlendPixels<mode, premultiplied>(canvasTail, layerTail);
+            std::memcpy(canvasRow + x * 4, canvasTail, tailBytes);
+        }
+    }
+}
+
+bool BlendRgba8(uint8_t* canvas, size_t canvasStride,
+                const uint8_t* layer, size_t layerStride,
+                size_t width, size_t height,
+                JxlBlendMode mode, bool premultiplied) {
+    switch (mode) {
+        case JXL_BLEND_REPLACE:
+            for (size_t y = 0; y < height; ++y) {
+                std::memcpy(canvas + y * canvasStride, layer + y * layerStride, width * 4);
+            }
+            return true;
+        case JXL_BLEND_ADD:
+            BlendRows<JXL_BLEND_ADD, false>(canvas, canvasStride, layer, layerStride, width, height);
+            return true;
+        case JXL_BLEND_BLEND:
+            if (premultiplied) {
+                BlendRows<JXL_BLEND_BLEND, true>(canvas, canvasStride, layer, layerStride, width, height);
+            } else {
+                BlendRows<JXL_BLEND_BLEND, false>(canvas, canvasStride, layer, layerStride, width, height);
+            }
+            return true;
+        case JXL_BLEND_MULADD:
+            BlendRows<JXL_BLEND_MULADD, false>(canvas, canvasStride, layer, layerStride, width, height);
+            return true;
+        case JXL_BLEND_MUL:
+            BlendRows<JXL_BLEND_MUL, false>(canvas, canvasStride, layer, layerStride, width, height);
+            return true;
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,49 @@
+//
+//  blend.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#ifndef JXLCODER_BLEND_HPP
+#define JXLCODER_BLEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <jxl/codestream_header.h>
+
+namespace jxlcoder {
+
+/**
+ * Blends width x height RGBA8 layer pixels onto the canvas with the JPEG XL blend mode, alpha is channel 3.
+ * Alpha follows the color channels: JXL_BLEND_BLEND composites it, the other modes treat it as one more channel.
+ * premultiplied only changes JXL_BLEND_BLEND, as in the specification.
+ * @return false for an unknown blend mode
+ */
+bool BlendRgba8(uint8_t* canvas, size_t canvasStride,
+                const uint8_t* layer, size_t layerStride,
+                size_t width, size_t height,
+                JxlBlendMode mode, bool premultiplied);
+
+}
+
+#endif //JXLCODER_BLEND_HPP
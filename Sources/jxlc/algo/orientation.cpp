@@ -0,0 +1,321 @@
+//
+//  orientation.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#include "orientation.hpp"
+#include <algorithm>
+#include <cstring>
+#include <hwy/highway.h>
+
+namespace jxlcoder {
+
+using namespace hwy;
+using namespace hwy::HWY_NAMESPACE;
+
+// Tiles keep both the source rows and the destination rows of a transpose in L1
+static constexpr size_t kTile = 16;
+// Rows (or source columns for transposes) handed to one executor task
+static constexpr size_t kBand = 64;
+static constexpr size_t kParallelPixels = 512 * 1024;
+
+template<size_t Bytes>
+struct OrientationPixel {
+    uint8_t bytes[Bytes];
+};
+
+struct OrientationJob {
+    const uint8_t* src;
+    size_t srcStride;
+    uint8_t* dst;
+    size_t dstStride;
+    size_t width;
+    size_t height;
+    bool flipX;
+    bool flipY;
+};
+
+/**
+ * dst[x] = src[width - 1 - x] for pixels of Channels samples of T
+ */
+template<typename T, int Channels>
+static void MirrorRow(const T* src, T* dst, size_t width) {
+    const ScalableTag<T> d;
+    using V = Vec<decltype(d)>;
+    const size_t lanes = Lanes(d);
+    size_t x = 0;
+    for (; x + lanes <= width; x += lanes) {
+        const T* from = src + (width - x - lanes) * Channels;
+        T* to = dst + x * Channels;
+        if constexpr (Channels == 1) {
+            StoreU(Reverse(d, LoadU(d, from)), d, to);
+        } else if constexpr (Channels == 3) {
+            V c0, c1, c2;
+            LoadInterleaved3(d, from, c0, c1, c2);
+            StoreInterleaved3(Reverse(d, c0), Reverse(d, c1), Reverse(d, c2), d, to);
+        } else {
+            V c0, c1, c2, c3;
+            LoadInterleaved4(d, from, c0, c1, c2, c3);
+            StoreInterleaved4(Reverse(d, c0), Reverse(d, c1), Reverse(d, c2), Reverse(d, c3), d, to);
+        }
+    }
+    for (; x < width; ++x) {
+        std::copy(src + (width - 1 - x) * Channels, src + (width - x) * Channels, dst + x * Channels);
+    }
+}
+
+template<typename T, int Channels>
+static void OrientRows(const OrientationJob& job, size_t fromY, size_t toY) {
+    for (size_t y = fromY; y < toY; ++y) {
+        auto srcRow = job.src + (job.flipY ? job.height - 1 - y : y) * job.srcStride;
+        auto dstRow = job.dst + y * job.dstStride;
+        if (job.flipX) {
+            MirrorRow<T, Channels>(reinterpret_cast<const T*>(srcRow), reinterpret_cast<T*>(dstRow), job.width);
+        } else {
+            std::memcpy(dstRow, srcRow, job.width * Channels * sizeof(T));
+        }
+    }
+}
+
+/**
+ * Source pixel (x, y) lands in destination row x (flipped with flipY) at column y (flipped with flipX)
+ */
+template<typename P>
+static inline P* TransposedPixel(const OrientationJob& job, size_t x, size_t y) {
+    size_t row = job.flipY ? job.width - 1 - x : x;
+    size_t column = job.flipX ? job.height - 1 - y : y;
+    return reinterpret_cast<P*>(job.dst + row * job.dstStride) + column;
+}
+
+template<typename P>
+static inline void TransposeScalar(const OrientationJob& job, size_t fromX, size_t toX, size_t fromY, size_t toY) {
+    for (size_t y = fromY; y < toY; ++y) {
+        auto srcRow = reinterpret_cast<const P*>(job.src + y * job.srcStride);
+        for (size_t x = fromX; x < toX; ++x) {
+            *TransposedPixel<P>(job, x, y) = srcRow[x];
+        }
+    }
+}
+
+/**
+ * Transposes a Block x Block square of single lane pixels in registers.
+ * Rows are combined with interleaves of doubling lane width, log2(Block) steps in total.
+ */
+template<typename P>
+struct TransposeBlock {
+    static constexpr size_t size = 1;
+};
+
+template<>
+struct TransposeBlock<uint64_t> {
+    static constexpr size_t size = 2;
+
+    static void run(const OrientationJob& job, size_t x, size_t y) {
+        const FixedTag<uint64_t, 2> d;
+        auto v0 = LoadU(d, reinterpret_cast<const uint64_t*>(job.src + y * job.srcStride) + x);
+        auto v1 = LoadU(d, reinterpret_cast<const uint64_t*>(job.src + (y + 1) * job.srcStride) + x);
+        store(job, d, x, y, InterleaveLower(d, v0, v1), InterleaveUpper(d, v0, v1));
+    }
+
+    template<class D, class V>
+    static void store(const OrientationJob& job, D d, size_t x, size_t y, V r0, V r1) {
+        const size_t first = job.flipX ? y + size - 1 : y;
+        StoreU(job.flipX ? Reverse(d, r0) : r0, d, TransposedPixel<uint64_t>(job, x, first));
+        StoreU(job.flipX ? Reverse(d, r1) : r1, d, TransposedPixel<uint64_t>(job, x + 1, first));
+    }
+};
+
+template<>
+struct TransposeBlock<uint32_t> {
+    static constexpr size_t size = 4;
+
+    static void run(const OrientationJob& job, size_t x, size_t y) {
+        const FixedTag<uint32_t, 4> d;
+        const Repartition<uint64_t, decltype(d)> d64;
+        using V = Vec<decltype(d)>;
+        V v[4];
+        for (size_t i = 0; i < 4; ++i) {
+            v[i] = LoadU(d, reinterpret_cast<const uint32_t*>(job.src + (y + i) * job.srcStride) + x);
+        }
+        auto t0 = BitCast(d64, InterleaveLower(d, v[0], v[1]));
+        auto t1 = BitCast(d64, InterleaveLower(d, v[2], v[3]));
+        auto t2 = BitCast(d64, InterleaveUpper(d, v[0], v[1]));
+        auto t3 = BitCast(d64, InterleaveUpper(d, v[2], v[3]));
+        V r[4] = {
+            BitCast(d, InterleaveLower(d64, t0, t1)),
+            BitCast(d, InterleaveUpper(d64, t0, t1)),
+            BitCast(d, InterleaveLower(d64, t2, t3)),
+            BitCast(d, InterleaveUpper(d64, t2, t3)),
+        };
+        const size_t first = job.flipX ? y + size - 1 : y;
+        for (size_t i = 0; i < 4; ++i) {
+            StoreU(job.flipX ? Reverse(d, r[i]) : r[i], d, TransposedPixel<uint32_t>(job, x + i, first));
+        }
+    }
+};
+
+template<>
+struct TransposeBlock<uint16_t> {
+    static constexpr size_t size = 8;
+
+    static void run(const OrientationJob& job, size_t x, size_t y) {
+        const FixedTag<uint16_t, 8> d;
+        const Repartition<uint32_t, decltype(d)> d32;
+        const Repartition<uint64_t, decltype(d)> d64;
+        using V = Vec<decltype(d)>;
+        V v[8];
+        for (size_t i = 0; i < 8; ++i) {
+            v[i] = LoadU(d, reinterpret_cast<const uint16_t*>(job.src + (y + i) * job.srcStride) + x);
+        }
+        Vec<decltype(d32)> t[8];
+        for (size_t i = 0; i < 4; ++i) {
+            t[i] = BitCast(d32, InterleaveLower(d, v[2 * i], v[2 * i + 1]));
+            t[i + 4] = BitCast(d32, InterleaveUpper(d, v[2 * i], v[2 * i + 1]));
+        }
+        // t[0..3] hold columns 0...3 of row pairs, t[4..7] columns 4...7
+        Vec<decltype(d64)> u[8];
+        for (size_t half = 0; half < 2; ++half) {
+            auto base = t + half * 4;
+            u[half * 4 + 0] = BitCast(d64, InterleaveLower(d32, base[0], base[1]));
+            u[half * 4 + 1] = BitCast(d64, InterleaveUpper(d32, base[0], base[1]));
+            u[half * 4 + 2] = BitCast(d64, InterleaveLower(d32, base[2], base[3]));
+            u[half * 4 + 3] = BitCast(d64, InterleaveUpper(d32, base[2], base[3]));
+        }
+        const size_t first = job.flipX ? y + size - 1 : y;
+        for (size_t i = 0; i < 4; ++i) {
+            auto quarter = i < 2 ? 0 : 4;
+            auto lower = u[quarter + (i % 2)];
+            auto upper = u[quarter + 2 + (i % 2)];
+            V r0 = BitCast(d, InterleaveLower(d64, lower, upper));
+            V r1 = BitCast(d, InterleaveUpper(d64, lower, upper));
+            size_t column = x + (i < 2 ? 0 : 4) + (i % 2) * 2;
+            StoreU(job.flipX ? Reverse(d, r0) : r0, d, TransposedPixel<uint16_t>(job, column, first));
+            StoreU(job.flipX ? Reverse(d, r1) : r1, d, TransposedPixel<uint16_t>(job, column + 1, first));
+        }
+    }
+};
+
+template<typename P>
+static void OrientColumns(const OrientationJob& job, size_t fromX, size_t toX) {
+    constexpr size_t block = TransposeBlock<P>::size;
+    for (size_t y0 = 0; y0 < job.height; y0 += kTile) {
+        const size_t yEnd = std::min(y0 + kTile, job.height);
+        for (size_t x0 = fromX; x0 < toX; x0 += kTile) {
+            const size_t xEnd = std::min(x0 + kTile, toX);
+            size_t y = y0;
+            if constexpr (block > 1) {
+                for (; y + block <= yEnd; y += block) {
+                    size_t x = x0;
+                    for (; x + block <= xEnd; x += block) {
+                        TransposeBlock<P>::run(job, x, y);
+                    }
+                    TransposeScalar<P>(job, x, xEnd, y, y + block);
+                }
+            }
+            TransposeScalar<P>(job, x0, xEnd, y, yEnd);
+        }
+    }
+}
+
+template<typename T>
+static bool OrientRowsFor(size_t components, OrientationJob& job, std::function<void(size_t, size_t)>* band) {
+    switch (components) {
+        case 1:
+            *band = [&job](size_t from, size_t to) { OrientRows<T, 1>(job, from, to); };
+            return true;
+        case 3:
+            *band = [&job](size_t from, size_t to) { OrientRows<T, 3>(job, from, to); };
+            return true;
+        case 4:
+            *band = [&job](size_t from, size_t to) { OrientRows<T, 4>(job, from, to); };
+            return true;
+        default:
+            return false;
+    }
+}
+
+template<typename P>
+static std::function<void(size_t, size_t)> OrientColumnsFor(OrientationJob& job) {
+    return [&job](size_t from, size_t to) { OrientColumns<P>(job, from, to); };
+}
+
+bool ApplyOrientation(const uint8_t* src, size_t srcStride,
+                      uint8_t* dst, size_t dstStride,
+                      size_t width, size_t height,
+                      size_t components, size_t sampleSize,
+                      JxlExposedOrientation orientation,
+                      const JxlSharedRunner& runner) {
+    if (components != 1 && components != 3 && components != 4) {
+        return false;
+    }
+    if (orientation < Identity || orientation > Rotate90CCW) {
+        return false;
+    }
+    const bool transposed = orientation >= OrientTranspose;
+    OrientationJob job = { src, srcStride, dst, dstStride, width, height,
+        orientation == FlipHorizontal || orientation == Rotate180 ||
+            orientation == Rotate90CW || orientation == AntiTranspose,
+        orientation == Rotate180 || orientation == FlipVertical ||
+            orientation == AntiTranspose || orientation == Rotate90CCW };
+
+    // Bands run over destination rows, which for transposes are the source columns
+    std::function<void(size_t, size_t)> band;
+    if (!transposed) {
+        bool supported = false;
+        switch (sampleSize) {
+            case 1: supported = OrientRowsFor<uint8_t>(components, job, &band); break;
+            case 2: supported = OrientRowsFor<uint16_t>(components, job, &band); break;
+            case 4: supported = OrientRowsFor<uint32_t>(components, job, &band); break;
+        }
+        if (!supported) {
+            return false;
+        }
+    } else {
+        switch (components * sampleSize) {
+            case 1: band = OrientColumnsFor<uint8_t>(job); break;
+            case 2: band = OrientColumnsFor<uint16_t>(job); break;
+            case 3: band = OrientColumnsFor<OrientationPixel<3>>(job); break;
+            case 4: band = OrientColumnsFor<uint32_t>(job); break;
+            case 6: band = OrientColumnsFor<OrientationPixel<6>>(job); break;
+            case 8: band = OrientColumnsFor<uint64_t>(job); break;
+            case 12: band = OrientColumnsFor<OrientationPixel<12>>(job); break;
+            case 16: band = OrientColumnsFor<OrientationPixel<16>>(job); break;
+            default: return false;
+        }
+    }
+
+    const size_t extent = transposed ? width : height;
+    const size_t bands = (extent + kBand - 1) / kBand;
+    if (width * height < kParallelPixels || bands < 2 || runner.serial) {
+        band(0, extent);
+        return true;
+    }
+    JxlSharedExecutor::shared().parallelFor(static_cast<uint32_t>(bands), runner.priority,
+                                            [&band, extent](uint32_t index, size_t) {
+        band(index * kBand, std::min<size_t>((index + 1) * kBand, extent));
+    });
+    return true;
+}
+
+}
@@ -0,0 +1,54 @@
+//
+//  orientation.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#ifndef JXLCODER_ORIENTATION_HPP
+#define JXLCODER_ORIENTATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "../JxlDefinitions.h"
+#include "../JxlSharedRunner.hpp"
+
+namespace jxlcoder {
+
+/**
+ * Writes src into dst with the EXIF orientation applied, as libjxl does when keep_orientation is off.
+ * width and height are the stored dimensions of src, for the transposing orientations (5...8) dst is height x width.
+ * Pixels are components (1, 3 or 4) samples of sampleSize bytes (1, 2 or 4), floats are moved as raw bits.
+ * Row bands of large images are spread over the shared executor unless the runner is serial.
+ * src and dst must not overlap.
+ * @return false for an unsupported pixel layout
+ */
+bool ApplyOrientation(const uint8_t* src, size_t srcStride,
+                      uint8_t* dst, size_t dstStride,
+                      size_t width, size_t height,
+                      size_t components, size_t sampleSize,
+                      JxlExposedOrientation orientation,
+                      const JxlSharedRunner& runner = JxlSharedRunner());
+
+}
+
+#endif //JXLCODER_ORIENTATION_HPP
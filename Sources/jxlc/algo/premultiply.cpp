@@ -0,0 +1,106 @@
+//
+//  premultiply.cpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#include "premultiply.hpp"
+#include <cstring>
+#include <hwy/highway.h>
+
+namespace jxlcoder {
+
+using namespace hwy;
+using namespace hwy::HWY_NAMESPACE;
+
+/**
+ * round(x / 255) for x up to 255 * 255, and round(x / 65535) for x up to 65535 * 65535 with shift 16:
+ * t = x + half, (t + (t >> shift)) >> shift
+ */
+template<int shift, typename V>
+static inline V DivideByMax(V x) {
+    const V t = Add(x, Set(DFromV<V>(), static_cast<TFromV<V>>(1u << (shift - 1))));
+    return ShiftRight<shift>(Add(t, ShiftRight<shift>(t)));
+}
+
+/**
+ * Premultiplies Lanes(di) pixels, samples are widened to 32 bit lanes
+ */
+static inline void PremultiplyPixels8(const uint8_t* src, uint8_t* dst) {
+    const ScalableTag<int32_t> di;
+    const Rebind<uint8_t, decltype(di)> du;
+    using VU = Vec<decltype(du)>;
+
+    VU u0, u1, u2, u3;
+    LoadInterleaved4(du, src, u0, u1, u2, u3);
+    const auto alpha = PromoteTo(di, u3);
+    const VU r = DemoteTo(du, DivideByMax<8>(Mul(PromoteTo(di, u0), alpha)));
+    const VU g = DemoteTo(du, DivideByMax<8>(Mul(PromoteTo(di, u1), alpha)));
+    const VU b = DemoteTo(du, DivideByMax<8>(Mul(PromoteTo(di, u2), alpha)));
+    StoreInterleaved4(r, g, b, u3, du, dst);
+}
+
+static inline void PremultiplyPixels16(const uint16_t* src, uint16_t* dst) {
+    const ScalableTag<uint32_t> du32;
+    const Rebind<int32_t, decltype(du32)> di;
+    const Rebind<uint16_t, decltype(du32)> du;
+    using VU = Vec<decltype(du)>;
+
+    VU u0, u1, u2, u3;
+    LoadInterleaved4(du, src, u0, u1, u2, u3);
+    const auto alpha = PromoteTo(du32, u3);
+    // Products need all 32 bits, results fit into 16 and go back through signed lanes
+    const VU r = DemoteTo(du, BitCast(di, DivideByMax<16>(Mul(PromoteTo(du32, u0), alpha))));
+    const VU g = DemoteTo(du, BitCast(di, DivideByMax<16>(Mul(PromoteTo(du32, u1), alpha))));
+    const VU b = DemoteTo(du, BitCast(di, DivideByMax<16>(Mul(PromoteTo(du32, u2), alpha))));
+    StoreInterleaved4(r, g, b, u3, du, dst);
+}
+
+template<typename T, void (*kernel)(const T*, T*)>
+static void PremultiplyRows(const T* src, T* dst, size_t numPixels) {
+    const ScalableTag<int32_t> di;
+    const size_t lanes = Lanes(di);
+    size_t x = 0;
+    for (; x + lanes <= numPixels; x += lanes) {
+        kernel(src + x * 4, dst + x * 4);
+    }
+    if (x < numPixels) {
+        // The tail goes through the same kernel from a full vector of scratch pixels
+        T srcTail[HWY_MAX_BYTES / sizeof(int32_t) * 4] = { 0 };
+        T dstTail[HWY_MAX_BYTES / sizeof(int32_t) * 4];
+        const size_t tailBytes = (numPixels - x) * 4 * sizeof(T);
+        std::memcpy(srcTail, src + x * 4, tailBytes);
+        kernel(srcTail, dstTail);
+        std::memcpy(dst + x * 4, dstTail, tailBytes);
+    }
+}
+
+void PremultiplyRgba8(const uint8_t* src, uint8_t* dst, size_t numPixels) {
+    PremultiplyRows<uint8_t, PremultiplyPixels8>(src, dst, numPixels);
+}
+
+void PremultiplyRgba16(const uint16_t* src, uint16_t* dst, size_t numPixels) {
+    PremultiplyRows<uint16_t, PremultiplyPixels16>(src, dst, numPixels);
+}
+
+}
@@ -0,0 +1,46 @@
+//
+//  premultiply.hpp
+//  JxclCoder [https://github.com/awxkee/jxl-coder-swift]
+//
+//  Created by Radzivon Bartoshyk on 16/10/2026.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+
+#ifndef JXLCODER_PREMULTIPLY_HPP
+#define JXLCODER_PREMULTIPLY_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace jxlcoder {
+
+/**
+ * Multiplies the color of numPixels RGBA pixels by their alpha, alpha is channel 3 and is kept.
+ * Results are rounded to nearest as round(color * alpha / max) without a division.
+ * src and dst may be the same.
+ */
+void PremultiplyRgba8(const uint8_t* src, uint8_t* dst, size_t numPixels);
+void PremultiplyRgba16(const uint16_t* src, uint16_t* dst, size_t numPixels);
+
+}
+
+#endif //JXLCODER_PREMULTIPLY_HPP